@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRBallCrowdSubsystem.h"
+#include "../OneMoreRun.h"
+#include "../Track/OMRTrackSurfaceSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+void UOMRBallCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	LLM_SCOPE_BYTAG(OMR_Crowd);
+
+	StepAccumulator = FMath::Min(StepAccumulator + DeltaTime, FixedStep * MaxStepsPerFrame);
+
+	const FOMRTrackSurfaceField* Field = GetSurfaceField();
+
+	while (StepAccumulator >= FixedStep)
+	{
+		Crowd.Step(FixedStep, Field);
+		StepAccumulator -= FixedStep;
+	}
+}
+
+TStatId UOMRBallCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOMRBallCrowdSubsystem, STATGROUP_Tickables);
+}
+
+void UOMRBallCrowdSubsystem::SpawnCrowd(int32 Count)
+{
+	Count = FMath::Max(Count, 0);
+
+	FVector Origin = FVector::ZeroVector;
+	FVector Forward = FVector::ForwardVector;
+
+	if (const APawn* Pawn = GetWorld()->GetFirstPlayerController() ? GetWorld()->GetFirstPlayerController()->GetPawn() : nullptr)
+	{
+		Origin = Pawn->GetActorLocation();
+		Forward = FVector::VectorPlaneProject(Pawn->GetActorForwardVector(), FVector::UpVector).GetSafeNormal();
+		Crowd.Tuning.FallbackGroundZ = Origin.Z - Crowd.Tuning.Ball.Radius;
+	}
+
+	LLM_SCOPE_BYTAG(OMR_Crowd);
+
+	Crowd.Reset(Count);
+
+	// Grid behind the player, everyone pushing forward with a little spread
+	const int32 Columns = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)Count)), 1);
+	const FVector Right = FVector::CrossProduct(FVector::UpVector, Forward);
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const float Row = (float)(i / Columns);
+		const float Column = (float)(i % Columns) - Columns * 0.5f;
+
+		const int32 Index = Crowd.Add(Origin - Forward * (Row + 1.f) * 150.f + Right * Column * 150.f);
+
+		const FVector Dir = Forward.RotateAngleAxis(FMath::FRandRange(-10.f, 10.f), FVector::UpVector);
+		Crowd.SetInput(Index, Dir.X, Dir.Y);
+	}
+
+	StepAccumulator = 0.f;
+}
+
+void UOMRBallCrowdSubsystem::ClearCrowd()
+{
+	Crowd.Reset(0);
+}
+
+double UOMRBallCrowdSubsystem::RunBenchmark(int32 Count, int32 Steps) const
+{
+	FOMRBallCrowd Bench;
+	Bench.Tuning = Crowd.Tuning;
+	Bench.Reset(Count);
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const int32 Index = Bench.Add(FVector(i * 150.f, 0.f, Bench.Tuning.FallbackGroundZ + Bench.Tuning.Ball.Radius));
+		Bench.SetInput(Index, 1.f, FMath::Sin(i * 0.37f) * 0.3f);
+	}
+
+	const FOMRTrackSurfaceField* Field = GetSurfaceField();
+
+	const double Start = FPlatformTime::Seconds();
+	for (int32 Step = 0; Step < Steps; ++Step)
+	{
+		Bench.Step(FixedStep, Field);
+	}
+	const double Elapsed = FPlatformTime::Seconds() - Start;
+
+	return Steps > 0 ? (Elapsed * 1000.0) / Steps : 0.0;
+}
+
+const FOMRTrackSurfaceField* UOMRBallCrowdSubsystem::GetSurfaceField() const
+{
+	// Field lookups only, no scene queries
+	const UOMRTrackSurfaceSubsystem* Surface = GetWorld()->GetSubsystem<UOMRTrackSurfaceSubsystem>();
+	return Surface && Surface->HasField() ? &Surface->GetField() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRCrowdSpawnCommand(
+	TEXT("OMR.Crowd.Spawn"),
+	TEXT("OMR.Crowd.Spawn <Count> - simulate Count headless balls"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UOMRBallCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRBallCrowdSubsystem>() : nullptr)
+		{
+			Subsystem->SpawnCrowd(Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 0) : 500);
+		}
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRCrowdClearCommand(
+	TEXT("OMR.Crowd.Clear"),
+	TEXT("OMR.Crowd.Clear - remove all headless balls"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UOMRBallCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRBallCrowdSubsystem>() : nullptr)
+		{
+			Subsystem->ClearCrowd();
+		}
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRCrowdBenchCommand(
+	TEXT("OMR.Crowd.Bench"),
+	TEXT("OMR.Crowd.Bench <Count> <Steps> - time the crowd kernel"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UOMRBallCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRBallCrowdSubsystem>() : nullptr;
+		if (!Subsystem) return;
+
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 0) : 500;
+		const int32 Steps = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1000;
+		const double MsPerStep = Subsystem->RunBenchmark(Count, Steps);
+
+		UE_LOG(LogTemp, Display, TEXT("Crowd kernel: %d balls, %.3f ms/step (%s 2 ms budget)"),
+			Count, MsPerStep, MsPerStep <= 2.0 ? TEXT("within") : TEXT("over"));
+	})
+);
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "../Player/OMRBallCrowd.h"
+#include "OMRBallCrowdSubsystem.generated.h"
+
+/**
+ * Steps a headless FOMRBallCrowd at a fixed rate for bot fields and stress tests.
+ *
+ * OMR.Crowd.Spawn <Count>        spawn bots around the first player pawn
+ * OMR.Crowd.Clear
+ * OMR.Crowd.Bench <Count> <Steps> time the kernel against the 2 ms budget
+ */
+UCLASS()
+class ONEMORERUN_API UOMRBallCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Crowd.Num() > 0; }
+
+	void SpawnCrowd(int32 Count);
+	void ClearCrowd();
+
+	// Runs Steps kernel steps on a throwaway crowd, returns average milliseconds per step
+	double RunBenchmark(int32 Count, int32 Steps) const;
+
+	const FOMRBallCrowd& GetCrowd() const { return Crowd; }
+
+	float FixedStep = 1.f / 120.f;
+	int32 MaxStepsPerFrame = 4;
+
+private:
+	const FOMRTrackSurfaceField* GetSurfaceField() const;
+
+	FOMRBallCrowd Crowd;
+	float StepAccumulator = 0.f;
+};
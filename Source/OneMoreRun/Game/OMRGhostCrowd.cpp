@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRGhostCrowd.h"
+#include "OMRGhostRecorder.h"
+
+void FOMRGhostCrowd::Reset()
+{
+	FirstSample.Reset();
+	NumSamples.Reset();
+	LapTimes.Reset();
+
+	SampleX.Reset();
+	SampleY.Reset();
+	SampleZ.Reset();
+	SampleRotations.Reset();
+
+	Index0.Reset();
+	Index1.Reset();
+	Alpha.Reset();
+	LocX.Reset();
+	LocY.Reset();
+	LocZ.Reset();
+	Rotations.Reset();
+
+	Curves.Reset();
+}
+
+void FOMRGhostCrowd::Reserve(int32 NumGhosts, int32 InNumSamples)
+{
+	FirstSample.Reserve(NumGhosts);
+	NumSamples.Reserve(NumGhosts);
+	LapTimes.Reserve(NumGhosts);
+
+	SampleX.Reserve(InNumSamples);
+	SampleY.Reserve(InNumSamples);
+	SampleZ.Reserve(InNumSamples);
+	SampleRotations.Reserve(InNumSamples);
+
+	Index0.Reserve(NumGhosts);
+	Index1.Reserve(NumGhosts);
+	Alpha.Reserve(NumGhosts);
+	LocX.Reserve(NumGhosts);
+	LocY.Reserve(NumGhosts);
+	LocZ.Reserve(NumGhosts);
+	Rotations.Reserve(NumGhosts);
+}
+
+int32 FOMRGhostCrowd::Add(const FOMRGhostTrack& Track)
+{
+	if (Track.Num() == 0) return INDEX_NONE;
+
+	// Sequential GetSample walks the deltas forward, one decode per sample
+	FOMRGhostSample Sample;
+
+	for (int32 Index = 0; Index < Track.Num(); ++Index)
+	{
+		Track.GetSample(Index, Sample);
+
+		SampleX.Add((float)Sample.Location.X);
+		SampleY.Add((float)Sample.Location.Y);
+		SampleZ.Add((float)Sample.Location.Z);
+		SampleRotations.Add(FOMRGhostTrack::PackRotation(Sample.Rotation));
+	}
+
+	const int32 Ghost = FirstSample.Add(SampleX.Num() - Track.Num());
+	NumSamples.Add(Track.Num());
+	LapTimes.Add(Track.LapTime >= 0.f ? Track.LapTime : Track.GetDuration());
+
+	Index0.AddZeroed();
+	Index1.AddZeroed();
+	Alpha.AddZeroed();
+	LocX.AddZeroed();
+	LocY.AddZeroed();
+	LocZ.AddZeroed();
+	Rotations.Add(FQuat4f::Identity);
+
+	// Curves are per layout, rebuilt for everyone
+	Curves.Reset();
+
+	return Ghost;
+}
+
+void FOMRGhostCrowd::Evaluate(float Time)
+{
+	const int32 Count = Num();
+	const float SampleTime = FMath::Max(Time * FOMRGhostTrack::SampleRate, 0.f);
+
+	// Sample pair and blend per ghost
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const float Last = (float)(NumSamples[i] - 1);
+		const float Clamped = FMath::Min(SampleTime, Last);
+		const int32 Floor = (int32)Clamped;
+
+		Index0[i] = FirstSample[i] + Floor;
+		Index1[i] = FirstSample[i] + FMath::Min(Floor + 1, NumSamples[i] - 1);
+		Alpha[i] = Clamped - (float)Floor;
+	}
+
+	// Locations
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const int32 A = Index0[i];
+		const int32 B = Index1[i];
+		const float T = Alpha[i];
+
+		LocX[i] = SampleX[A] + (SampleX[B] - SampleX[A]) * T;
+		LocY[i] = SampleY[A] + (SampleY[B] - SampleY[A]) * T;
+		LocZ[i] = SampleZ[A] + (SampleZ[B] - SampleZ[A]) * T;
+	}
+
+	// Rotations, unpacked on demand so the shared arrays stay at 4 bytes a sample
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const FQuat4f A(FOMRGhostTrack::UnpackRotation(SampleRotations[Index0[i]]));
+		const FQuat4f B(FOMRGhostTrack::UnpackRotation(SampleRotations[Index1[i]]));
+
+		Rotations[i] = FQuat4f::FastLerp(A, B, Alpha[i]).GetNormalized();
+	}
+}
+
+void FOMRGhostCrowd::GetTransforms(float Scale, TArray<FTransform>& OutTransforms) const
+{
+	const int32 Count = Num();
+	OutTransforms.SetNumUninitialized(Count, EAllowShrinking::No);
+
+	const FVector Scale3D(Scale);
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		OutTransforms[i] = FTransform(FQuat(Rotations[i]), FVector(LocX[i], LocY[i], LocZ[i]), Scale3D);
+	}
+}
+
+void FOMRGhostCrowd::BuildProgressCurves(const FOMRTrackProgress& Progress, float Step)
+{
+	Curves.Reset();
+
+	if (!Progress.IsValid()) return;
+
+	Curves.SetNum(Num());
+
+	for (int32 Ghost = 0; Ghost < Num(); ++Ghost)
+	{
+		FOMRProgressCurve& Curve = Curves[Ghost];
+		Curve.Init(Progress.GetLength(), Step);
+
+		FOMRLapProgressTracker Tracker;
+
+		for (int32 Index = 0; Index < NumSamples[Ghost]; ++Index)
+		{
+			const int32 Sample = FirstSample[Ghost] + Index;
+
+			if (Tracker.Update(Progress, FVector(SampleX[Sample], SampleY[Sample], SampleZ[Sample])))
+			{
+				Curve.Advance(Tracker.Distance, Index / FOMRGhostTrack::SampleRate);
+			}
+		}
+	}
+}
+
+bool FOMRGhostCrowd::GetGapAt(int32 Ghost, float Distance, float LapTime, float& OutGap) const
+{
+	if (!Curves.IsValidIndex(Ghost)) return false;
+
+	const FOMRProgressCurve& Curve = Curves[Ghost];
+	if (!Curve.IsValid() || Distance > Curve.GetReachedDistance()) return false;
+
+	OutGap = LapTime - Curve.GetTimeAt(Distance);
+
+	return true;
+}
+
+int32 FOMRGhostCrowd::GetAllocatedSize() const
+{
+	return FirstSample.GetAllocatedSize() + NumSamples.GetAllocatedSize() + LapTimes.GetAllocatedSize() +
+		SampleX.GetAllocatedSize() + SampleY.GetAllocatedSize() + SampleZ.GetAllocatedSize() + SampleRotations.GetAllocatedSize() +
+		Index0.GetAllocatedSize() + Index1.GetAllocatedSize() + Alpha.GetAllocatedSize() +
+		LocX.GetAllocatedSize() + LocY.GetAllocatedSize() + LocZ.GetAllocatedSize() + Rotations.GetAllocatedSize() +
+		Curves.GetAllocatedSize();
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Track/OMRTrackProgress.h"
+
+class FOMRGhostTrack;
+
+/**
+ * Playback of many ghosts at once in structure-of-arrays form.
+ *
+ * Each ghost is decoded once when added, its samples go back to back into flat arrays shared
+ * by all ghosts. Samples are at the fixed FOMRGhostTrack::SampleRate, so finding the pair
+ * around a lap time is index arithmetic, not a search. Evaluate runs index, location and
+ * rotation stages as separate loops over all ghosts, the first two branch-free.
+ */
+class ONEMORERUN_API FOMRGhostCrowd
+{
+public:
+	void Reset();
+
+	// Sizes the per-ghost arrays and the shared sample arrays up front
+	void Reserve(int32 NumGhosts, int32 NumSamples);
+
+	// Returns the ghost index, INDEX_NONE for an empty track
+	int32 Add(const FOMRGhostTrack& Track);
+
+	int32 Num() const { return FirstSample.Num(); }
+	float GetLapTime(int32 Ghost) const { return LapTimes[Ghost]; }
+
+	// Every ghost at lap-relative Time, clamped to its own recording
+	void Evaluate(float Time);
+
+	// Results of the last Evaluate
+	FVector GetLocation(int32 Ghost) const { return FVector(LocX[Ghost], LocY[Ghost], LocZ[Ghost]); }
+	FQuat GetRotation(int32 Ghost) const { return FQuat(Rotations[Ghost]); }
+
+	// Instance transforms from the last Evaluate, OutTransforms is resized to Num()
+	void GetTransforms(float Scale, TArray<FTransform>& OutTransforms) const;
+
+	// Time-at-distance of every ghost, for gaps at equal track progress
+	void BuildProgressCurves(const FOMRTrackProgress& Progress, float Step);
+	bool HasProgressCurves() const { return Curves.Num() == Num() && Num() > 0; }
+
+	// LapTime minus when the ghost reached Distance, positive means behind it. False past
+	// where the ghost's curve ends
+	bool GetGapAt(int32 Ghost, float Distance, float LapTime, float& OutGap) const;
+
+	int32 GetAllocatedSize() const;
+
+private:
+	// Per ghost
+	TArray<int32> FirstSample;
+	TArray<int32> NumSamples;
+	TArray<float> LapTimes;
+
+	// Samples of every ghost, FirstSample[G] .. FirstSample[G] + NumSamples[G] - 1
+	TArray<float> SampleX, SampleY, SampleZ;
+	TArray<uint32> SampleRotations;
+
+	// Evaluate stages, per ghost
+	TArray<int32> Index0;
+	TArray<int32> Index1;
+	TArray<float> Alpha;
+	TArray<float> LocX, LocY, LocZ;
+	TArray<FQuat4f> Rotations;
+
+	TArray<FOMRProgressCurve> Curves;
+};
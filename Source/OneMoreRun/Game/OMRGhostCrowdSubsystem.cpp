@@ -0,0 +1,351 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRGhostCrowdSubsystem.h"
+#include "../OneMoreRun.h"
+#include "OMRGhostFile.h"
+#include "OMRTimeTrialGameState.h"
+#include "../Player/OMRPlayerPawn.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Materials/MaterialInterface.h"
+
+DECLARE_CYCLE_STAT(TEXT("Ghost Crowd Update"), STAT_OMR_GhostCrowd, STATGROUP_OMR);
+
+void UOMRGhostCrowdSubsystem::Deinitialize()
+{
+	if (InstanceActor)
+	{
+		InstanceActor->Destroy();
+	}
+
+	InstanceActor = nullptr;
+	Instances = nullptr;
+	Crowd.Reset();
+
+	Super::Deinitialize();
+}
+
+void UOMRGhostCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	OMR_SCOPED_STAGE(STAT_OMR_GhostCrowd);
+	LLM_SCOPE_BYTAG(OMR_Ghosts);
+
+	const AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>();
+
+	// Needs the track's progress index, which is built after the first registry change
+	if (GS && !Crowd.HasProgressCurves() && GS->GetTrackProgress().IsValid())
+	{
+		Crowd.BuildProgressCurves(GS->GetTrackProgress(), GS->ProgressCurveStep);
+	}
+
+	// Everyone waits on the line until the lap starts
+	const float LapTime = GS && GS->bLapActive ? (float)(GetWorld()->GetTimeSeconds() - GS->LapStartRaceTime) : 0.f;
+
+	Crowd.Evaluate(LapTime);
+
+	if (!Instances) return;
+
+	Crowd.GetTransforms(GetInstanceScale(), InstanceTransforms);
+
+	if (bInstancesDirty)
+	{
+		bInstancesDirty = false;
+
+		Instances->ClearInstances();
+		Instances->AddInstances(InstanceTransforms, false, true);
+	}
+	else
+	{
+		Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
+
+TStatId UOMRGhostCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOMRGhostCrowdSubsystem, STATGROUP_Tickables);
+}
+
+int32 UOMRGhostCrowdSubsystem::LoadTopGhosts(int32 MaxGhosts)
+{
+	LLM_SCOPE_BYTAG(OMR_Ghosts);
+
+	const FString TrackName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	const uint32 TrackId = FOMRGhostFile::MakeTrackId(TrackName);
+	const AOMRPlayerPawn* Pawn = Cast<AOMRPlayerPawn>(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	TArray<FOMRGhostFile::FDirectoryEntry> Entries;
+	FOMRGhostFile::ScanDirectory(FOMRGhostFile::GetGhostDirectory(), Entries);
+
+	// Same rule as the saved best, other layouts or handling can't be raced fairly
+	Entries.RemoveAll([TrackId, Pawn](const FOMRGhostFile::FDirectoryEntry& Entry)
+	{
+		return Entry.Header.TrackId != TrackId || (Pawn && Entry.Header.TuningHash != Pawn->GetTuningHash());
+	});
+
+	Entries.Sort([](const FOMRGhostFile::FDirectoryEntry& A, const FOMRGhostFile::FDirectoryEntry& B)
+	{
+		return A.Header.LapTime < B.Header.LapTime;
+	});
+
+	// The saved best is also one of the lap ghosts, race it once
+	for (int32 Index = Entries.Num() - 1; Index > 0; --Index)
+	{
+		const FOMRGhostFile::FHeader& Header = Entries[Index].Header;
+		const FOMRGhostFile::FHeader& Previous = Entries[Index - 1].Header;
+
+		if (Header.LapTime == Previous.LapTime && Header.NumSamples == Previous.NumSamples && Header.TuningHash == Previous.TuningHash)
+		{
+			Entries.RemoveAt(Index);
+		}
+	}
+
+	const int32 Count = FMath::Min(FMath::Max(MaxGhosts, 0), Entries.Num());
+
+	int32 TotalSamples = 0;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		TotalSamples += Entries[Index].Header.NumSamples;
+	}
+
+	ClearGhosts();
+	Crowd.Reserve(Count, TotalSamples);
+
+	// One decode buffer for every file, each ghost is copied into the crowd's arrays
+	FOMRGhostTrack Track;
+
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		FOMRGhostFile File;
+
+		if (File.Open(Entries[Index].Filename) && File.DecodeAll(Track))
+		{
+			AddGhost(Track);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Could not decode ghost %s."), *Entries[Index].Filename);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Loaded %d of %d ghosts for %s, %d KB."),
+		Crowd.Num(), Entries.Num(), *TrackName, Crowd.GetAllocatedSize() / 1024);
+
+	return Crowd.Num();
+}
+
+int32 UOMRGhostCrowdSubsystem::AddGhost(const FOMRGhostTrack& Track)
+{
+	LLM_SCOPE_BYTAG(OMR_Ghosts);
+
+	const int32 Ghost = Crowd.Add(Track);
+
+	if (Ghost != INDEX_NONE)
+	{
+		EnsureInstances();
+		bInstancesDirty = true;
+	}
+
+	return Ghost;
+}
+
+void UOMRGhostCrowdSubsystem::ClearGhosts()
+{
+	Crowd.Reset();
+	InstanceTransforms.Reset();
+
+	if (Instances)
+	{
+		Instances->ClearInstances();
+	}
+
+	bInstancesDirty = false;
+}
+
+bool UOMRGhostCrowdSubsystem::GetGapToRival(int32 Ghost, float& OutGap) const
+{
+	const AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>();
+	if (!GS || !GS->bLapActive) return false;
+
+	const float LapTime = (float)(GetWorld()->GetTimeSeconds() - GS->LapStartRaceTime);
+
+	return Crowd.GetGapAt(Ghost, GS->LapProgressDistance, LapTime, OutGap);
+}
+
+void UOMRGhostCrowdSubsystem::EnsureInstances()
+{
+	if (Instances) return;
+
+	UStaticMesh* Mesh = Cast<UStaticMesh>(GhostMesh.TryLoad());
+	if (!Mesh)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Ghost mesh %s not found, ghosts won't be drawn."), *GhostMesh.ToString());
+		return;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	InstanceActor = GetWorld()->SpawnActor<AActor>(SpawnParams);
+	if (!InstanceActor) return;
+
+	Instances = NewObject<UInstancedStaticMeshComponent>(InstanceActor, TEXT("GhostInstances"));
+	Instances->SetMobility(EComponentMobility::Movable);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+	Instances->SetStaticMesh(Mesh);
+
+	if (UMaterialInterface* Material = Cast<UMaterialInterface>(GhostMaterial.TryLoad()))
+	{
+		Instances->SetMaterial(0, Material);
+	}
+
+	InstanceActor->SetRootComponent(Instances);
+	Instances->RegisterComponent();
+}
+
+float UOMRGhostCrowdSubsystem::GetInstanceScale() const
+{
+	const AOMRPlayerPawn* Pawn = Cast<AOMRPlayerPawn>(UGameplayStatics::GetPlayerPawn(this, 0));
+	return Pawn ? Pawn->GetBallRadius() / FMath::Max(GhostMeshRadius, 1.f) : 1.f;
+}
+
+double UOMRGhostCrowdSubsystem::RunBenchmark(int32 Count, int32 Frames, double& OutInstanceMs) const
+{
+	OutInstanceMs = 0.0;
+
+	// Three minute synthetic lap, every ghost a copy of it
+	FOMRGhostTrack Track;
+	Track.Init(180.f);
+
+	for (int32 i = 0; i < Track.GetCapacity(); ++i)
+	{
+		const float T = i / FOMRGhostTrack::SampleRate;
+
+		FOMRGhostSample Sample;
+		Sample.Location = FVector(FMath::Sin(T * 0.2f) * 20000.f, FMath::Sin(T * 0.4f) * 8000.f, FMath::Sin(T * 0.9f) * 300.f);
+		Sample.Rotation = FQuat(FVector(0.3f, 1.f, 0.f).GetSafeNormal(), T * 12.f);
+
+		Track.Add(Sample);
+	}
+	Track.LapTime = Track.GetDuration();
+
+	FOMRGhostCrowd Bench;
+	Bench.Reserve(Count, Count * Track.Num());
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		Bench.Add(Track);
+	}
+
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Count);
+
+	// Same component setup as the real crowd, so the instance update costs the same
+	UStaticMesh* Mesh = Cast<UStaticMesh>(GhostMesh.TryLoad());
+	AActor* BenchActor = nullptr;
+	UInstancedStaticMeshComponent* BenchInstances = nullptr;
+
+	if (Mesh)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+
+		BenchActor = GetWorld()->SpawnActor<AActor>(SpawnParams);
+	}
+
+	if (BenchActor)
+	{
+		BenchInstances = NewObject<UInstancedStaticMeshComponent>(BenchActor, TEXT("BenchInstances"));
+		BenchInstances->SetMobility(EComponentMobility::Movable);
+		BenchInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		BenchInstances->SetCastShadow(false);
+		BenchInstances->SetStaticMesh(Mesh);
+
+		BenchActor->SetRootComponent(BenchInstances);
+		BenchInstances->RegisterComponent();
+
+		Bench.Evaluate(0.f);
+		Bench.GetTransforms(1.f, Transforms);
+		BenchInstances->AddInstances(Transforms, false, true);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Ghost mesh %s not found, timing evaluation only."), *GhostMesh.ToString());
+	}
+
+	double InstanceSeconds = 0.0;
+
+	const double Start = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < Frames; ++Frame)
+	{
+		Bench.Evaluate(Frame / 60.f);
+		Bench.GetTransforms(1.f, Transforms);
+
+		if (BenchInstances)
+		{
+			const double InstanceStart = FPlatformTime::Seconds();
+			BenchInstances->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+			InstanceSeconds += FPlatformTime::Seconds() - InstanceStart;
+		}
+	}
+	const double Elapsed = FPlatformTime::Seconds() - Start;
+
+	if (BenchActor)
+	{
+		BenchActor->Destroy();
+	}
+
+	if (Frames <= 0) return 0.0;
+
+	OutInstanceMs = (InstanceSeconds * 1000.0) / Frames;
+	return (Elapsed * 1000.0) / Frames;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRGhostsLoadCommand(
+	TEXT("OMR.Ghosts.Load"),
+	TEXT("OMR.Ghosts.Load [Count] - race the fastest Count saved ghosts for this track"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UOMRGhostCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRGhostCrowdSubsystem>() : nullptr)
+		{
+			Subsystem->LoadTopGhosts(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : Subsystem->DefaultGhostCount);
+		}
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRGhostsClearCommand(
+	TEXT("OMR.Ghosts.Clear"),
+	TEXT("OMR.Ghosts.Clear - remove all crowd ghosts"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UOMRGhostCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRGhostCrowdSubsystem>() : nullptr)
+		{
+			Subsystem->ClearGhosts();
+		}
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRGhostsBenchCommand(
+	TEXT("OMR.Ghosts.Bench"),
+	TEXT("OMR.Ghosts.Bench <Count> <Frames> - time ghost crowd evaluation"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UOMRGhostCrowdSubsystem* Subsystem = World ? World->GetSubsystem<UOMRGhostCrowdSubsystem>() : nullptr;
+		if (!Subsystem) return;
+
+		const int32 Count = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 0) : 100;
+		const int32 Frames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 1000;
+
+		double InstanceMs = 0.0;
+		const double MsPerFrame = Subsystem->RunBenchmark(Count, Frames, InstanceMs);
+
+		UE_LOG(LogTemp, Display, TEXT("Ghost crowd: %d ghosts, %.3f ms/frame, %.3f of it instance updates (%s 0.3 ms budget)"),
+			Count, MsPerFrame, InstanceMs, MsPerFrame <= 0.3 ? TEXT("within") : TEXT("over"));
+	})
+);
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OMRGhostCrowd.h"
+#include "OMRGhostCrowdSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+/**
+ * Races the player against many saved ghosts at once: one FOMRGhostCrowd evaluated on the
+ * lap clock each frame, drawn as a single instanced static mesh.
+ *
+ * OMR.Ghosts.Load [Count]          fastest Count saved ghosts for this track and tuning
+ * OMR.Ghosts.Clear
+ * OMR.Ghosts.Bench <Count> <Frames> time evaluation and instance updates against the 0.3 ms budget
+ */
+UCLASS(Config = Game)
+class ONEMORERUN_API UOMRGhostCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Crowd.Num() > 0; }
+
+	// Saved ghosts (Saved/Ghosts) for this track and tuning, fastest first. The game state
+	// saves one per completed lap, see AOMRTimeTrialGameState::SavedLapGhosts
+	int32 LoadTopGhosts(int32 MaxGhosts);
+
+	int32 AddGhost(const FOMRGhostTrack& Track);
+	void ClearGhosts();
+
+	UFUNCTION(BlueprintPure)
+	int32 NumGhosts() const { return Crowd.Num(); }
+
+	UFUNCTION(BlueprintPure)
+	float GetGhostLapTime(int32 Ghost) const { return Ghost >= 0 && Ghost < Crowd.Num() ? Crowd.GetLapTime(Ghost) : -1.f; }
+
+	// Player's lap time minus the ghost's time at the player's track distance, positive
+	// means behind. False before the lap starts or past where the ghost's lap was recorded
+	UFUNCTION(BlueprintCallable)
+	bool GetGapToRival(int32 Ghost, float& OutGap) const;
+
+	// Evaluates Count copies of a synthetic lap Frames times and pushes them to a scratch
+	// instanced mesh the way Tick does, returns average game thread milliseconds per frame.
+	// OutInstanceMs is the instance update's share of it
+	double RunBenchmark(int32 Count, int32 Frames, double& OutInstanceMs) const;
+
+	const FOMRGhostCrowd& GetCrowd() const { return Crowd; }
+
+	// Shadowless and without collision, GhostMaterial is typically translucent
+	UPROPERTY(Config)
+	FSoftObjectPath GhostMesh = FSoftObjectPath(TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+
+	UPROPERTY(Config)
+	FSoftObjectPath GhostMaterial;
+
+	// GhostMesh radius at scale 1, instances are scaled to the player's ball
+	UPROPERTY(Config)
+	float GhostMeshRadius = 50.f;
+
+	UPROPERTY(Config)
+	int32 DefaultGhostCount = 100;
+
+private:
+	void EnsureInstances();
+	float GetInstanceScale() const;
+
+	FOMRGhostCrowd Crowd;
+
+	UPROPERTY(Transient)
+	TObjectPtr<AActor> InstanceActor;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	// Reused every frame
+	TArray<FTransform> InstanceTransforms;
+
+	bool bInstancesDirty = false;
+};
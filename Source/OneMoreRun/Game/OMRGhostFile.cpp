@@ -0,0 +1,468 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRGhostFile.h"
+#include "../OneMoreRun.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace OMRGhostFile
+{
+	// Split times are padded so the chunk table stays 8-byte aligned
+	FORCEINLINE int64 GetSplitBytes(int32 NumSplits)
+	{
+		return Align((int64)NumSplits * sizeof(float), 8);
+	}
+
+	FORCEINLINE int64 GetChunkTableOffset(int32 NumSplits)
+	{
+		return sizeof(FOMRGhostFile::FHeader) + GetSplitBytes(NumSplits);
+	}
+}
+
+FOMRGhostFile::~FOMRGhostFile()
+{
+	Close();
+}
+
+bool FOMRGhostFile::Open(const FString& Filename)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FOpenMappedResult MappedResult = PlatformFile.OpenMappedEx(*Filename);
+	if (MappedResult.HasValue())
+	{
+		MappedHandle = MappedResult.StealValue();
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+
+		if (MappedRegion)
+		{
+			Data = MappedRegion->GetMappedPtr();
+			DataSize = MappedRegion->GetMappedSize();
+		}
+	}
+
+	if (!Data)
+	{
+		if (!FFileHelper::LoadFileToArray(LoadedBytes, *Filename, FILEREAD_Silent))
+		{
+			Close();
+			return false;
+		}
+
+		Data = LoadedBytes.GetData();
+		DataSize = LoadedBytes.Num();
+	}
+
+	if (!Validate())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Ghost %s is invalid or out of date."), *Filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool FOMRGhostFile::OpenBytes(TArray64<uint8>&& Bytes)
+{
+	Close();
+
+	LoadedBytes = MoveTemp(Bytes);
+	Data = LoadedBytes.GetData();
+	DataSize = LoadedBytes.Num();
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FOMRGhostFile::Close()
+{
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	LoadedBytes.Empty();
+
+	Data = nullptr;
+	DataSize = 0;
+}
+
+bool FOMRGhostFile::Validate()
+{
+	// Header and tables, chunk payloads are only inflated when they are decoded
+	if (!Data || DataSize < (int64)sizeof(FHeader)) return false;
+
+	const FHeader& Header = GetHeader();
+
+	const bool bHeaderValid =
+		Header.Magic == Magic &&
+		Header.Version == Version &&
+		Header.SampleRate == FOMRGhostTrack::SampleRate &&
+		Header.ChunkSamples == ChunkSamples &&
+		Header.NumSamples >= 0 &&
+		Header.NumSplits >= 0 &&
+		Header.NumChunks == FMath::DivideAndRoundUp(Header.NumSamples, ChunkSamples);
+
+	if (!bHeaderValid) return false;
+
+	const int64 DataOffset = OMRGhostFile::GetChunkTableOffset(Header.NumSplits) + (int64)Header.NumChunks * sizeof(FChunkEntry);
+	if (DataSize < DataOffset) return false;
+
+	// Every chunk inside the file and after the tables, and the size its samples encode to
+	const FChunkEntry* ChunkTable = GetChunkTable();
+
+	for (int32 ChunkIndex = 0; ChunkIndex < Header.NumChunks; ++ChunkIndex)
+	{
+		const FChunkEntry& Entry = ChunkTable[ChunkIndex];
+
+		const int32 FirstSample = ChunkIndex * ChunkSamples;
+		const int32 LastSample = FMath::Min(FirstSample + ChunkSamples, Header.NumSamples);
+		const int32 ExpectedSize = FOMRGhostTrack::GetByteSize(LastSample) - FOMRGhostTrack::GetByteSize(FirstSample);
+
+		if (Entry.UncompressedSize != ExpectedSize ||
+			Entry.CompressedSize <= 0 ||
+			Entry.CompressedSize > Entry.UncompressedSize ||
+			Entry.Offset < DataOffset ||
+			Entry.Offset > DataSize - Entry.CompressedSize)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+TConstArrayView<float> FOMRGhostFile::GetSplitTimes() const
+{
+	if (!Data) return TConstArrayView<float>();
+
+	return TConstArrayView<float>(reinterpret_cast<const float*>(Data + sizeof(FHeader)), GetHeader().NumSplits);
+}
+
+const FOMRGhostFile::FChunkEntry* FOMRGhostFile::GetChunkTable() const
+{
+	return reinterpret_cast<const FChunkEntry*>(Data + OMRGhostFile::GetChunkTableOffset(GetHeader().NumSplits));
+}
+
+void FOMRGhostFile::BeginDecode(FOMRGhostTrack& Track) const
+{
+	if (!Data) return;
+
+	const FHeader& Header = GetHeader();
+
+	if (Track.GetCapacity() < Header.NumSamples)
+	{
+		LLM_SCOPE_BYTAG(OMR_Ghosts);
+		Track.Init(Header.NumSamples / FOMRGhostTrack::SampleRate);
+	}
+
+	Track.Reset();
+	Track.LapTime = Header.LapTime;
+}
+
+bool FOMRGhostFile::DecodeChunk(int32 ChunkIndex, FOMRGhostTrack& Track) const
+{
+	if (!Data) return false;
+
+	const FHeader& Header = GetHeader();
+
+	if (ChunkIndex < 0 || ChunkIndex >= Header.NumChunks) return false;
+
+	// Chunks append, the track must hold exactly the chunks before this one
+	const int32 FirstSample = ChunkIndex * ChunkSamples;
+	if (Track.NumSamples != FirstSample) return false;
+
+	const int32 LastSample = FMath::Min(FirstSample + ChunkSamples, Header.NumSamples);
+	const int32 ExpectedSize = FOMRGhostTrack::GetByteSize(LastSample) - FOMRGhostTrack::GetByteSize(FirstSample);
+
+	const FChunkEntry& Entry = GetChunkTable()[ChunkIndex];
+
+	if (Entry.UncompressedSize != ExpectedSize ||
+		Entry.CompressedSize <= 0 ||
+		Entry.Offset < 0 ||
+		Entry.Offset + Entry.CompressedSize > DataSize ||
+		Track.GetByteSize(LastSample) > Track.Bytes.Num())
+	{
+		return false;
+	}
+
+	uint8* Dest = Track.Bytes.GetData() + FOMRGhostTrack::GetByteSize(FirstSample);
+	const uint8* Source = Data + Entry.Offset;
+
+	if (Entry.CompressedSize == Entry.UncompressedSize)
+	{
+		FMemory::Memcpy(Dest, Source, Entry.UncompressedSize);
+	}
+	else if (!FCompression::UncompressMemory(NAME_Zlib, Dest, Entry.UncompressedSize, Source, Entry.CompressedSize))
+	{
+		return false;
+	}
+
+	Track.NumSamples = LastSample;
+	Track.CursorIndex = INDEX_NONE;
+
+	return true;
+}
+
+bool FOMRGhostFile::DecodeAll(FOMRGhostTrack& Track) const
+{
+	if (!Data) return false;
+
+	BeginDecode(Track);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < GetHeader().NumChunks; ++ChunkIndex)
+	{
+		if (!DecodeChunk(ChunkIndex, Track))
+		{
+			Track.Reset();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FOMRGhostFile::Encode(const FOMRGhostTrack& Track, uint32 TrackId, uint32 TuningHash, TConstArrayView<float> SplitTimes, TArray64<uint8>& OutBytes)
+{
+	FHeader Header;
+	Header.TrackId = TrackId;
+	Header.TuningHash = TuningHash;
+	Header.LapTime = Track.LapTime;
+	Header.NumSamples = Track.Num();
+	Header.NumSplits = SplitTimes.Num();
+	Header.NumChunks = FMath::DivideAndRoundUp(Track.Num(), ChunkSamples);
+	Header.SavedTime = FDateTime::UtcNow().GetTicks();
+
+	const int64 TableOffset = OMRGhostFile::GetChunkTableOffset(Header.NumSplits);
+	const int64 DataOffset = TableOffset + (int64)Header.NumChunks * sizeof(FChunkEntry);
+
+	OutBytes.Reset();
+	OutBytes.AddZeroed(DataOffset);
+
+	FMemory::Memcpy(OutBytes.GetData(), &Header, sizeof(FHeader));
+	FMemory::Memcpy(OutBytes.GetData() + sizeof(FHeader), SplitTimes.GetData(), SplitTimes.Num() * sizeof(float));
+
+	const TConstArrayView<uint8> Encoded = Track.GetBytes();
+
+	for (int32 ChunkIndex = 0; ChunkIndex < Header.NumChunks; ++ChunkIndex)
+	{
+		const int32 FirstSample = ChunkIndex * ChunkSamples;
+		const int32 LastSample = FMath::Min(FirstSample + ChunkSamples, Header.NumSamples);
+
+		const int32 SourceOffset = FOMRGhostTrack::GetByteSize(FirstSample);
+		const int32 SourceSize = FOMRGhostTrack::GetByteSize(LastSample) - SourceOffset;
+
+		FChunkEntry Entry;
+		Entry.Offset = OutBytes.Num();
+		Entry.UncompressedSize = SourceSize;
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, SourceSize);
+		OutBytes.AddUninitialized(CompressedSize);
+
+		const bool bCompressed = FCompression::CompressMemory(
+			NAME_Zlib,
+			OutBytes.GetData() + Entry.Offset,
+			CompressedSize,
+			Encoded.GetData() + SourceOffset,
+			SourceSize
+		);
+
+		// Store raw when compression fails or doesn't shrink the chunk
+		if (!bCompressed || CompressedSize >= SourceSize)
+		{
+			FMemory::Memcpy(OutBytes.GetData() + Entry.Offset, Encoded.GetData() + SourceOffset, SourceSize);
+			CompressedSize = SourceSize;
+		}
+
+		OutBytes.SetNum(Entry.Offset + CompressedSize, EAllowShrinking::No);
+		Entry.CompressedSize = CompressedSize;
+
+		FMemory::Memcpy(OutBytes.GetData() + TableOffset + ChunkIndex * sizeof(FChunkEntry), &Entry, sizeof(FChunkEntry));
+	}
+
+	return true;
+}
+
+bool FOMRGhostFile::Write(const FString& Filename, const FOMRGhostTrack& Track, uint32 TrackId, uint32 TuningHash, TConstArrayView<float> SplitTimes)
+{
+	LLM_SCOPE_BYTAG(OMR_Ghosts);
+
+	TArray64<uint8> Bytes;
+	if (!Encode(Track, TrackId, TuningHash, SplitTimes, Bytes)) return false;
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FOMRGhostFile::ReadHeader(const FString& Filename, FHeader& OutHeader)
+{
+	TUniquePtr<IFileHandle> Handle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!Handle) return false;
+
+	FHeader Header;
+	if (!Handle->Read(reinterpret_cast<uint8*>(&Header), sizeof(FHeader))) return false;
+
+	if (Header.Magic != Magic || Header.Version != Version) return false;
+
+	OutHeader = Header;
+	return true;
+}
+
+void FOMRGhostFile::ScanDirectory(const FString& Directory, TArray<FDirectoryEntry>& OutEntries)
+{
+	TArray<FString> Files;
+	IFileManager::Get().FindFiles(Files, *(Directory / TEXT("*.omrghost")), true, false);
+
+	OutEntries.Reserve(OutEntries.Num() + Files.Num());
+
+	for (const FString& File : Files)
+	{
+		FDirectoryEntry Entry;
+		Entry.Filename = Directory / File;
+
+		if (ReadHeader(Entry.Filename, Entry.Header))
+		{
+			OutEntries.Add(MoveTemp(Entry));
+		}
+	}
+}
+
+uint32 FOMRGhostFile::MakeTrackId(const FString& MapName)
+{
+	return FCrc::StrCrc32(*MapName);
+}
+
+FString FOMRGhostFile::GetGhostDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Ghosts");
+}
+
+FString FOMRGhostFile::GetBestGhostPath(const FString& MapName)
+{
+	return GetGhostDirectory() / (MapName + TEXT("_Best.omrghost"));
+}
+
+FString FOMRGhostFile::GetLapGhostPath(const FString& MapName, int64 SavedTicks)
+{
+	return GetGhostDirectory() / FString::Printf(TEXT("%s_Lap_%lld.omrghost"), *MapName, SavedTicks);
+}
+
+bool FOMRGhostFile::IsLapGhostPath(const FString& Filename, const FString& MapName)
+{
+	return FPaths::GetCleanFilename(Filename).StartsWith(MapName + TEXT("_Lap_"));
+}
+
+// Codec benchmark: OMR.Ghost.Bench [Seconds] [Iterations]
+
+static void OMRRunGhostCodecBenchmark(const TArray<FString>& Args)
+{
+	const float Seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 180.f;
+	const int32 Iterations = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 50, 1);
+
+	// Synthetic lap: rolling figure-eight with some vertical motion
+	FOMRGhostTrack Track;
+	Track.Init(Seconds);
+
+	const int32 NumSamples = Track.GetCapacity();
+	const float Step = 1.f / FOMRGhostTrack::SampleRate;
+
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		const float T = i * Step;
+
+		FOMRGhostSample Sample;
+		Sample.Location = FVector(FMath::Sin(T * 0.2f) * 20000.f, FMath::Sin(T * 0.4f) * 8000.f, FMath::Sin(T * 0.9f) * 300.f);
+		Sample.Velocity = FVector(FMath::Cos(T * 0.2f) * 4000.f, FMath::Cos(T * 0.4f) * 3200.f, FMath::Cos(T * 0.9f) * 270.f);
+		Sample.Rotation = FQuat(FVector(0.3f, 1.f, 0.f).GetSafeNormal(), T * 12.f);
+		Sample.bGrounded = FMath::Frac(T * 0.1f) > 0.1f;
+
+		Track.Add(Sample);
+	}
+	Track.LapTime = Track.GetDuration();
+
+	// Codec
+	TArray64<uint8> CodecBytes;
+	FOMRGhostFile::Encode(Track, 0, 0, TConstArrayView<float>(), CodecBytes);
+
+	FOMRGhostFile File;
+	File.OpenBytes(CopyTemp(CodecBytes));
+
+	// Both sides do the same work: file bytes in, every sample out as an FOMRGhostSample
+	FOMRGhostTrack Decoded;
+	TArray<FOMRGhostSample> CodecSamples;
+	CodecSamples.SetNum(NumSamples);
+
+	double Start = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		File.DecodeAll(Decoded);
+
+		for (int32 i = 0; i < Decoded.Num(); ++i)
+		{
+			Decoded.GetSample(i, CodecSamples[i]);
+		}
+	}
+	const double CodecSeconds = FPlatformTime::Seconds() - Start;
+
+	FOMRGhostSample Sample;
+
+	// Plain FArchive of the decoded samples
+	TArray<uint8> ArchiveBytes;
+	{
+		FMemoryWriter Writer(ArchiveBytes);
+
+		int32 Count = NumSamples;
+		Writer << Count;
+
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			Track.GetSample(i, Sample);
+			Writer << Sample.Location << Sample.Rotation << Sample.Velocity << Sample.bGrounded;
+		}
+	}
+
+	TArray<FOMRGhostSample> ArchiveSamples;
+	ArchiveSamples.SetNum(NumSamples);
+
+	Start = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		FMemoryReader Reader(ArchiveBytes);
+
+		int32 Count = 0;
+		Reader << Count;
+
+		for (int32 i = 0; i < Count; ++i)
+		{
+			FOMRGhostSample& Out = ArchiveSamples[i];
+			Reader << Out.Location << Out.Rotation << Out.Velocity << Out.bGrounded;
+		}
+	}
+	const double ArchiveSeconds = FPlatformTime::Seconds() - Start;
+
+	const double TotalSamples = (double)NumSamples * Iterations;
+
+	UE_LOG(LogTemp, Display, TEXT("Ghost codec: %d samples, %lld bytes (%d in memory), %.1f M samples/s"),
+		NumSamples, CodecBytes.Num(), Track.GetBytes().Num(), TotalSamples / FMath::Max(CodecSeconds, UE_SMALL_NUMBER) / 1e6);
+
+	UE_LOG(LogTemp, Display, TEXT("FArchive:    %d samples, %d bytes, %.1f M samples/s"),
+		NumSamples, ArchiveBytes.Num(), TotalSamples / FMath::Max(ArchiveSeconds, UE_SMALL_NUMBER) / 1e6);
+}
+
+static FAutoConsoleCommand GOMRGhostBenchCommand(
+	TEXT("OMR.Ghost.Bench"),
+	TEXT("OMR.Ghost.Bench <Seconds> <Iterations> - compare the ghost codec with plain FArchive serialization"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&OMRRunGhostCodecBenchmark)
+);
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OMRGhostRecorder.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Saved ghost: one FOMRGhostTrack plus the lap's split times.
+ *
+ * File layout (little endian, see FOMRGhostFile::Encode):
+ *   FHeader | float SplitTimes[NumSplits] | FChunkEntry[NumChunks] | chunk data...
+ * Each chunk is ChunkSamples encoded ghost samples (ChunkBlocks keyframe blocks), zlib
+ * compressed, or stored raw when compression doesn't help. Chunks decode independently,
+ * so playback can start on chunk 0 while the rest of the mapping stays cold.
+ */
+class ONEMORERUN_API FOMRGhostFile
+{
+public:
+	static constexpr uint32 Magic = 0x47524D4F; // 'OMRG'
+	static constexpr uint32 Version = 1;
+	static constexpr int32 ChunkBlocks = 4;
+	static constexpr int32 ChunkSamples = FOMRGhostTrack::KeyframeInterval * ChunkBlocks;
+	static constexpr int32 ChunkBytes = FOMRGhostTrack::BlockBytes * ChunkBlocks;
+
+	struct FHeader
+	{
+		uint32 Magic = FOMRGhostFile::Magic;
+		uint32 Version = FOMRGhostFile::Version;
+		uint32 TrackId = 0;
+		uint32 TuningHash = 0;
+		float LapTime = 0.f;
+		float SampleRate = FOMRGhostTrack::SampleRate;
+		int32 NumSamples = 0;
+		int32 NumSplits = 0;
+		int32 NumChunks = 0;
+		int32 ChunkSamples = FOMRGhostFile::ChunkSamples;
+		// FDateTime ticks, UTC
+		int64 SavedTime = 0;
+	};
+
+	struct FChunkEntry
+	{
+		int64 Offset = 0;
+		int32 CompressedSize = 0;
+		int32 UncompressedSize = 0;
+	};
+	static_assert(sizeof(FChunkEntry) == 16, "FChunkEntry is part of the file format");
+
+	struct FDirectoryEntry
+	{
+		FString Filename;
+		FHeader Header;
+	};
+
+	FOMRGhostFile() = default;
+	~FOMRGhostFile();
+
+	FOMRGhostFile(const FOMRGhostFile&) = delete;
+	FOMRGhostFile& operator=(const FOMRGhostFile&) = delete;
+
+	// Memory maps the file, falling back to reading it whole where mapping is unsupported
+	bool Open(const FString& Filename);
+	bool OpenBytes(TArray64<uint8>&& Bytes);
+	void Close();
+
+	bool IsValid() const { return Data != nullptr; }
+
+	const FHeader& GetHeader() const { return *reinterpret_cast<const FHeader*>(Data); }
+	TConstArrayView<float> GetSplitTimes() const;
+
+	// Sizes Track for the whole lap and empties it, then DecodeChunk in order
+	void BeginDecode(FOMRGhostTrack& Track) const;
+
+	// Appends chunk ChunkIndex to Track, which must already hold chunks 0..ChunkIndex-1
+	bool DecodeChunk(int32 ChunkIndex, FOMRGhostTrack& Track) const;
+
+	bool DecodeAll(FOMRGhostTrack& Track) const;
+
+	// Write side
+	static bool Encode(
+		const FOMRGhostTrack& Track,
+		uint32 TrackId,
+		uint32 TuningHash,
+		TConstArrayView<float> SplitTimes,
+		TArray64<uint8>& OutBytes
+	);
+
+	static bool Write(
+		const FString& Filename,
+		const FOMRGhostTrack& Track,
+		uint32 TrackId,
+		uint32 TuningHash,
+		TConstArrayView<float> SplitTimes
+	);
+
+	// Reads only the header, for listing many ghosts without opening them
+	static bool ReadHeader(const FString& Filename, FHeader& OutHeader);
+	static void ScanDirectory(const FString& Directory, TArray<FDirectoryEntry>& OutEntries);
+
+	static uint32 MakeTrackId(const FString& MapName);
+
+	// Saved/Ghosts
+	static FString GetGhostDirectory();
+	static FString GetBestGhostPath(const FString& MapName);
+
+	// One per completed lap, named by when it was saved
+	static FString GetLapGhostPath(const FString& MapName, int64 SavedTicks);
+	static bool IsLapGhostPath(const FString& Filename, const FString& MapName);
+
+private:
+	bool Validate();
+
+	const FChunkEntry* GetChunkTable() const;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Used when the platform can't map the file
+	TArray64<uint8> LoadedBytes;
+};
@@ -0,0 +1,368 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRGhostRecorder.h"
+
+namespace OMRGhost
+{
+	enum ESampleFlags : uint8
+	{
+		Flag_Grounded = 1 << 0,
+	};
+
+	constexpr double InvSqrt2 = 0.70710678118654752;
+
+	template <typename T>
+	FORCEINLINE void Write(uint8*& Cursor, T Value)
+	{
+		FMemory::Memcpy(Cursor, &Value, sizeof(T));
+		Cursor += sizeof(T);
+	}
+
+	template <typename T>
+	FORCEINLINE T Read(const uint8*& Cursor)
+	{
+		T Value;
+		FMemory::Memcpy(&Value, Cursor, sizeof(T));
+		Cursor += sizeof(T);
+		return Value;
+	}
+
+	FORCEINLINE int16 QuantizeInt16(double Value)
+	{
+		return (int16)FMath::Clamp<int64>(FMath::RoundToInt64(Value), MIN_int16, MAX_int16);
+	}
+
+	// Rotation, velocity and flags are stored the same way in both record types
+	void WriteTail(uint8*& Cursor, const FOMRGhostSample& Sample)
+	{
+		Write<uint32>(Cursor, FOMRGhostTrack::PackRotation(Sample.Rotation));
+		Write<int16>(Cursor, QuantizeInt16(Sample.Velocity.X));
+		Write<int16>(Cursor, QuantizeInt16(Sample.Velocity.Y));
+		Write<int16>(Cursor, QuantizeInt16(Sample.Velocity.Z));
+		Write<uint8>(Cursor, Sample.bGrounded ? Flag_Grounded : 0);
+	}
+
+	void ReadTail(const uint8*& Cursor, FOMRGhostSample& OutSample)
+	{
+		OutSample.Rotation = FOMRGhostTrack::UnpackRotation(Read<uint32>(Cursor));
+
+		const int16 VelX = Read<int16>(Cursor);
+		const int16 VelY = Read<int16>(Cursor);
+		const int16 VelZ = Read<int16>(Cursor);
+		OutSample.Velocity = FVector(VelX, VelY, VelZ);
+
+		OutSample.bGrounded = (Read<uint8>(Cursor) & Flag_Grounded) != 0;
+	}
+}
+
+void FOMRGhostTrack::Init(float MaxDuration)
+{
+	Capacity = FMath::CeilToInt(FMath::Max(MaxDuration, 0.f) * SampleRate) + 1;
+
+	Bytes.SetNumUninitialized(GetByteSize(Capacity));
+
+	Reset();
+}
+
+void FOMRGhostTrack::Reset()
+{
+	NumSamples = 0;
+	bTruncated = false;
+	LapTime = -1.f;
+	LastLocation = FVector::ZeroVector;
+	CursorIndex = INDEX_NONE;
+}
+
+int32 FOMRGhostTrack::GetByteOffset(int32 Index)
+{
+	const int32 Block = Index / KeyframeInterval;
+	const int32 InBlock = Index % KeyframeInterval;
+
+	return Block * BlockBytes + (InBlock == 0 ? 0 : KeyframeBytes + (InBlock - 1) * DeltaBytes);
+}
+
+int32 FOMRGhostTrack::GetByteSize(int32 InNumSamples)
+{
+	if (InNumSamples <= 0) return 0;
+
+	const int32 Last = InNumSamples - 1;
+	return GetByteOffset(Last) + (Last % KeyframeInterval == 0 ? KeyframeBytes : DeltaBytes);
+}
+
+bool FOMRGhostTrack::Add(const FOMRGhostSample& Sample)
+{
+	if (NumSamples >= Capacity)
+	{
+		bTruncated = true;
+		return false;
+	}
+
+	uint8* Cursor = Bytes.GetData() + GetByteOffset(NumSamples);
+
+	if (NumSamples % KeyframeInterval == 0)
+	{
+		const FVector3f Location(Sample.Location);
+
+		OMRGhost::Write<float>(Cursor, Location.X);
+		OMRGhost::Write<float>(Cursor, Location.Y);
+		OMRGhost::Write<float>(Cursor, Location.Z);
+
+		LastLocation = FVector(Location);
+	}
+	else
+	{
+		// Against the decoded location, a clamped jump (teleport) catches up over the next samples
+		const FVector Delta = (Sample.Location - LastLocation) / LocationStep;
+
+		const int16 DeltaX = OMRGhost::QuantizeInt16(Delta.X);
+		const int16 DeltaY = OMRGhost::QuantizeInt16(Delta.Y);
+		const int16 DeltaZ = OMRGhost::QuantizeInt16(Delta.Z);
+
+		OMRGhost::Write<int16>(Cursor, DeltaX);
+		OMRGhost::Write<int16>(Cursor, DeltaY);
+		OMRGhost::Write<int16>(Cursor, DeltaZ);
+
+		LastLocation += FVector(DeltaX, DeltaY, DeltaZ) * LocationStep;
+	}
+
+	OMRGhost::WriteTail(Cursor, Sample);
+
+	++NumSamples;
+	return true;
+}
+
+void FOMRGhostTrack::CopyFrom(const FOMRGhostTrack& Other)
+{
+	if (Other.NumSamples > Capacity)
+	{
+		Init(Other.Capacity / SampleRate);
+	}
+
+	FMemory::Memcpy(Bytes.GetData(), Other.Bytes.GetData(), GetByteSize(Other.NumSamples));
+
+	NumSamples = Other.NumSamples;
+	bTruncated = Other.bTruncated;
+	LapTime = Other.LapTime;
+	LastLocation = Other.LastLocation;
+	CursorIndex = INDEX_NONE;
+}
+
+void FOMRGhostTrack::GetSample(int32 Index, FOMRGhostSample& OutSample) const
+{
+	check(Index >= 0 && Index < NumSamples);
+
+	const int32 KeyIndex = Index - Index % KeyframeInterval;
+
+	int32 From;
+	FVector Location;
+
+	// Continue from the last decoded sample when it's earlier in the same block
+	if (CursorIndex >= KeyIndex && CursorIndex <= Index)
+	{
+		From = CursorIndex;
+		Location = CursorLocation;
+	}
+	else
+	{
+		const uint8* Cursor = Bytes.GetData() + GetByteOffset(KeyIndex);
+
+		const float X = OMRGhost::Read<float>(Cursor);
+		const float Y = OMRGhost::Read<float>(Cursor);
+		const float Z = OMRGhost::Read<float>(Cursor);
+
+		From = KeyIndex;
+		Location = FVector(X, Y, Z);
+	}
+
+	for (int32 i = From + 1; i <= Index; ++i)
+	{
+		const uint8* Cursor = Bytes.GetData() + GetByteOffset(i);
+
+		const int16 DeltaX = OMRGhost::Read<int16>(Cursor);
+		const int16 DeltaY = OMRGhost::Read<int16>(Cursor);
+		const int16 DeltaZ = OMRGhost::Read<int16>(Cursor);
+
+		Location += FVector(DeltaX, DeltaY, DeltaZ) * LocationStep;
+	}
+
+	CursorIndex = Index;
+	CursorLocation = Location;
+
+	const uint8* Tail = Bytes.GetData() + GetByteOffset(Index) + (Index == KeyIndex ? 3 * sizeof(float) : 3 * sizeof(int16));
+
+	OutSample.Location = Location;
+	OMRGhost::ReadTail(Tail, OutSample);
+}
+
+bool FOMRGhostTrack::Evaluate(float Time, FOMRGhostSample& OutSample) const
+{
+	if (NumSamples == 0) return false;
+
+	const float SampleTime = FMath::Clamp(Time * SampleRate, 0.f, (float)(NumSamples - 1));
+
+	const int32 Index0 = FMath::FloorToInt(SampleTime);
+	const int32 Index1 = FMath::Min(Index0 + 1, NumSamples - 1);
+	const float Alpha = SampleTime - Index0;
+
+	FOMRGhostSample A;
+	FOMRGhostSample B;
+	GetSample(Index0, A);
+	GetSample(Index1, B);
+
+	OutSample.Location = FMath::Lerp(A.Location, B.Location, (double)Alpha);
+	OutSample.Rotation = FQuat::Slerp(A.Rotation, B.Rotation, Alpha);
+	OutSample.Velocity = FMath::Lerp(A.Velocity, B.Velocity, (double)Alpha);
+	OutSample.bGrounded = Alpha < 0.5f ? A.bGrounded : B.bGrounded;
+
+	return true;
+}
+
+uint32 FOMRGhostTrack::PackRotation(const FQuat& Rotation)
+{
+	const FQuat Q = Rotation.GetNormalized();
+	const double C[4] = { Q.X, Q.Y, Q.Z, Q.W };
+
+	int32 Largest = 0;
+	for (int32 i = 1; i < 4; ++i)
+	{
+		if (FMath::Abs(C[i]) > FMath::Abs(C[Largest]))
+		{
+			Largest = i;
+		}
+	}
+
+	// q and -q are the same rotation, make the dropped component positive
+	const double Sign = C[Largest] < 0.0 ? -1.0 : 1.0;
+
+	uint32 Packed = (uint32)Largest;
+	int32 Shift = 2;
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (i == Largest) continue;
+
+		// The other three are within +-1/sqrt(2)
+		const double Normalized = (C[i] * Sign / OMRGhost::InvSqrt2) * 0.5 + 0.5;
+		const uint32 Quantized = (uint32)FMath::Clamp<int64>(FMath::RoundToInt64(Normalized * 1023.0), 0, 1023);
+
+		Packed |= Quantized << Shift;
+		Shift += 10;
+	}
+
+	return Packed;
+}
+
+FQuat FOMRGhostTrack::UnpackRotation(uint32 Packed)
+{
+	const int32 Largest = Packed & 3;
+
+	double C[4];
+	double SumSquares = 0.0;
+	int32 Shift = 2;
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		if (i == Largest) continue;
+
+		const double Normalized = ((Packed >> Shift) & 1023) / 1023.0;
+		C[i] = (Normalized * 2.0 - 1.0) * OMRGhost::InvSqrt2;
+		SumSquares += C[i] * C[i];
+		Shift += 10;
+	}
+
+	C[Largest] = FMath::Sqrt(FMath::Max(1.0 - SumSquares, 0.0));
+
+	return FQuat(C[0], C[1], C[2], C[3]).GetNormalized();
+}
+
+void FOMRGhostRecorder::Init(int32 HistoryLaps, float MaxLapDuration)
+{
+	History.SetNum(FMath::Max(HistoryLaps, 1));
+
+	for (FOMRGhostTrack& Track : History)
+	{
+		Track.Init(MaxLapDuration);
+	}
+
+	BestGhost.Init(MaxLapDuration);
+
+	WriteSlot = 0;
+	NumCommitted = 0;
+	bRecording = false;
+}
+
+void FOMRGhostRecorder::BeginLap()
+{
+	if (!IsInitialized()) return;
+
+	History[WriteSlot].Reset();
+
+	PrevTime = 0.f;
+	NextSampleTime = 0.f;
+	bRecording = true;
+}
+
+void FOMRGhostRecorder::Record(float LapTime, const FOMRGhostSample& Sample)
+{
+	if (!bRecording) return;
+
+	FOMRGhostTrack& Track = History[WriteSlot];
+
+	// Emit every fixed-rate sample between the previous frame and this one
+	while (NextSampleTime <= LapTime)
+	{
+		const float Span = LapTime - PrevTime;
+		const float Alpha = Span > KINDA_SMALL_NUMBER ? FMath::Clamp((NextSampleTime - PrevTime) / Span, 0.f, 1.f) : 1.f;
+
+		FOMRGhostSample Resampled;
+		Resampled.Location = FMath::Lerp(PrevSample.Location, Sample.Location, (double)Alpha);
+		Resampled.Rotation = FQuat::Slerp(PrevSample.Rotation, Sample.Rotation, Alpha);
+		Resampled.Velocity = FMath::Lerp(PrevSample.Velocity, Sample.Velocity, (double)Alpha);
+		Resampled.bGrounded = Alpha < 0.5f ? PrevSample.bGrounded : Sample.bGrounded;
+
+		if (!Track.Add(Resampled)) break;
+
+		NextSampleTime = Track.Num() / FOMRGhostTrack::SampleRate;
+	}
+
+	PrevTime = LapTime;
+	PrevSample = Sample;
+}
+
+void FOMRGhostRecorder::EndLap(float LapTime, bool bNewBest)
+{
+	if (!bRecording) return;
+
+	FOMRGhostTrack& Track = History[WriteSlot];
+	Track.LapTime = LapTime;
+
+	if (bNewBest)
+	{
+		BestGhost.CopyFrom(Track);
+	}
+
+	WriteSlot = (WriteSlot + 1) % History.Num();
+	NumCommitted = FMath::Min(NumCommitted + 1, History.Num());
+	bRecording = false;
+}
+
+const FOMRGhostTrack* FOMRGhostRecorder::GetLap(int32 LapsAgo) const
+{
+	if (LapsAgo < 0 || LapsAgo >= NumCommitted) return nullptr;
+
+	const int32 Slot = (WriteSlot - 1 - LapsAgo + History.Num()) % History.Num();
+	return &History[Slot];
+}
+
+int32 FOMRGhostRecorder::GetAllocatedSize() const
+{
+	int32 Size = BestGhost.GetAllocatedSize() + History.GetAllocatedSize();
+
+	for (const FOMRGhostTrack& Track : History)
+	{
+		Size += Track.GetAllocatedSize();
+	}
+
+	return Size;
+}
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FOMRGhostSample
+{
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector Velocity = FVector::ZeroVector;
+	bool bGrounded = false;
+};
+
+/**
+ * One lap of ball samples at a fixed rate, quantized into a preallocated byte buffer.
+ *
+ * Samples are stored in fixed-size blocks so any sample can be found without an index:
+ *   Keyframe (23 bytes): float Location[3] | uint32 Rotation | int16 Velocity[3] | uint8 Flags
+ *   Delta    (17 bytes): int16 LocationDelta[3] | uint32 Rotation | int16 Velocity[3] | uint8 Flags
+ * Location deltas are in LocationStep units against the decoded previous location, so
+ * quantization error doesn't accumulate. Rotation uses smallest-three packing (2 + 3x10 bits),
+ * velocity is in whole cm/s.
+ */
+class ONEMORERUN_API FOMRGhostTrack
+{
+public:
+	static constexpr float SampleRate = 20.f;
+	static constexpr int32 KeyframeInterval = 64;
+	static constexpr int32 KeyframeBytes = 23;
+	static constexpr int32 DeltaBytes = 17;
+	static constexpr int32 BlockBytes = KeyframeBytes + (KeyframeInterval - 1) * DeltaBytes;
+	static constexpr float LocationStep = 0.1f;
+
+	// Allocates storage for MaxDuration seconds (~61 KB for 3 minutes), nothing after this allocates
+	void Init(float MaxDuration);
+
+	// Empties the track, keeps the storage
+	void Reset();
+
+	// False once the track is full, the lap is then marked truncated
+	bool Add(const FOMRGhostSample& Sample);
+
+	// Reuses this track's storage, Other must not be larger than our capacity
+	void CopyFrom(const FOMRGhostTrack& Other);
+
+	int32 Num() const { return NumSamples; }
+	int32 GetCapacity() const { return Capacity; }
+	bool IsTruncated() const { return bTruncated; }
+	float GetDuration() const { return NumSamples > 1 ? (NumSamples - 1) / SampleRate : 0.f; }
+
+	// Lap time the track was committed with, negative while recording
+	float LapTime = -1.f;
+
+	void GetSample(int32 Index, FOMRGhostSample& OutSample) const;
+
+	// Interpolated state at a lap-relative time, clamped to the recorded range
+	bool Evaluate(float Time, FOMRGhostSample& OutSample) const;
+
+	// Encoded samples, GetByteSize(Num()) bytes
+	TConstArrayView<uint8> GetBytes() const { return TConstArrayView<uint8>(Bytes.GetData(), GetByteSize(NumSamples)); }
+	int32 GetAllocatedSize() const { return Bytes.GetAllocatedSize(); }
+
+	static int32 GetByteOffset(int32 Index);
+	static int32 GetByteSize(int32 NumSamples);
+
+	static uint32 PackRotation(const FQuat& Rotation);
+	static FQuat UnpackRotation(uint32 Packed);
+
+private:
+	// Loads encoded chunks straight into Bytes
+	friend class FOMRGhostFile;
+
+	TArray<uint8> Bytes;
+	int32 Capacity = 0;
+	int32 NumSamples = 0;
+	bool bTruncated = false;
+
+	// Decoded location of the last added sample, deltas are taken against this
+	FVector LastLocation = FVector::ZeroVector;
+
+	// Sequential playback walks forward from here instead of the block keyframe
+	mutable int32 CursorIndex = INDEX_NONE;
+	mutable FVector CursorLocation = FVector::ZeroVector;
+};
+
+/**
+ * Records every lap at FOMRGhostTrack::SampleRate into a ring of preallocated tracks and
+ * keeps a copy of the best one. Feed it the ball state every frame, it resamples to the
+ * fixed rate by interpolating between frames.
+ */
+class ONEMORERUN_API FOMRGhostRecorder
+{
+public:
+	void Init(int32 HistoryLaps, float MaxLapDuration);
+
+	bool IsInitialized() const { return History.Num() > 0; }
+
+	void BeginLap();
+	void Record(float LapTime, const FOMRGhostSample& Sample);
+
+	// Commits the lap into the history, promotes it when bNewBest
+	void EndLap(float LapTime, bool bNewBest);
+
+	// Drops the lap being recorded, its slot is reused by the next BeginLap
+	void AbortLap() { bRecording = false; }
+
+	bool IsRecording() const { return bRecording; }
+
+	bool HasBestGhost() const { return BestGhost.Num() > 0; }
+	const FOMRGhostTrack& GetBestGhost() const { return BestGhost; }
+
+	// Decode target for a saved best ghost
+	FOMRGhostTrack& GetBestGhostForLoading() { return BestGhost; }
+
+	// 0 is the most recent completed lap
+	int32 GetNumLaps() const { return NumCommitted; }
+	const FOMRGhostTrack* GetLap(int32 LapsAgo) const;
+
+	int32 GetAllocatedSize() const;
+
+private:
+	TArray<FOMRGhostTrack> History;
+	FOMRGhostTrack BestGhost;
+
+	int32 WriteSlot = 0;
+	int32 NumCommitted = 0;
+	bool bRecording = false;
+
+	// Previous frame, to interpolate samples that fall between frames
+	float PrevTime = 0.f;
+	FOMRGhostSample PrevSample;
+	float NextSampleTime = 0.f;
+};
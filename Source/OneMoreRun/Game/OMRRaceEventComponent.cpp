@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRRaceEventComponent.h"
+#include "OMRTimeTrialGameState.h"
+
+UOMRRaceEventComponent::UOMRRaceEventComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UOMRRaceEventComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		ListenerHandle = GS->GetRaceEvents().AddListener(
+			FOMRRaceEventListener::CreateUObject(this, &UOMRRaceEventComponent::HandleRaceEvents),
+			(uint32)EventMask);
+	}
+}
+
+void UOMRRaceEventComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->GetRaceEvents().RemoveListener(ListenerHandle);
+	}
+
+	ListenerHandle.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UOMRRaceEventComponent::HandleRaceEvents(TConstArrayView<FOMRRaceEvent> Events)
+{
+	if (!OnRaceEvent.IsBound()) return;
+
+	for (const FOMRRaceEvent& Event : Events)
+	{
+		if ((uint32)EventMask & FOMRRaceEventBus::GetTypeBit(Event.Type))
+		{
+			OnRaceEvent.Broadcast(Event);
+		}
+	}
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "OMRRaceEvents.h"
+#include "OMRRaceEventComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnOMRRaceEvent, const FOMRRaceEvent&, Event);
+
+/**
+ * Blueprint side of the race event bus. Add it to any actor to get the events of EventMask one
+ * at a time, actors without it cost the bus nothing.
+ */
+UCLASS(ClassGroup = (OneMoreRun), meta = (BlueprintSpawnableComponent))
+class ONEMORERUN_API UOMRRaceEventComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UOMRRaceEventComponent();
+
+	UPROPERTY(EditAnywhere, Category = "Race Events", meta = (Bitmask, BitmaskEnum = "/Script/OneMoreRun.EOMRRaceEvent"))
+	int32 EventMask = -1;
+
+	UPROPERTY(BlueprintAssignable, Category = "Race Events")
+	FOnOMRRaceEvent OnRaceEvent;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void HandleRaceEvents(TConstArrayView<FOMRRaceEvent> Events);
+
+	FDelegateHandle ListenerHandle;
+};
@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRRaceEvents.h"
+
+FOMRRaceEvent FOMRRaceEvent::MakeLapStart(int32 InLap)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::LapStart;
+	Event.Lap = InLap;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeLapComplete(int32 InLap, float LapTime, bool bInNewBest)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::LapComplete;
+	Event.Lap = InLap;
+	Event.Time = LapTime;
+	Event.bNewBest = bInNewBest;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeCheckpoint(int32 InCheckpoint, float SplitTime)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::Checkpoint;
+	Event.Checkpoint = InCheckpoint;
+	Event.Time = SplitTime;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeSplit(int32 InCheckpoint, float SplitTime, float SplitDelta)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::Split;
+	Event.Checkpoint = InCheckpoint;
+	Event.Time = SplitTime;
+	Event.Delta = SplitDelta;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeCountdownTick(int32 InCount)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::CountdownTick;
+	Event.Count = InCount;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeLanding(float InImpactSpeed)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::Landing;
+	Event.ImpactSpeed = InImpactSpeed;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeRespawn(int32 InCheckpoint)
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::Respawn;
+	Event.Checkpoint = InCheckpoint;
+	return Event;
+}
+
+FOMRRaceEvent FOMRRaceEvent::MakeReset()
+{
+	FOMRRaceEvent Event;
+	Event.Type = EOMRRaceEvent::Reset;
+	return Event;
+}
+
+FDelegateHandle FOMRRaceEventBus::AddListener(FOMRRaceEventListener Listener, uint32 TypeMask)
+{
+	if (!Listener.IsBound()) return FDelegateHandle();
+
+	const FDelegateHandle Handle = Listener.GetHandle();
+
+	FListener& Entry = bDispatching ? AddedWhileDispatching.AddDefaulted_GetRef() : Listeners.AddDefaulted_GetRef();
+	Entry.Delegate = MoveTemp(Listener);
+	Entry.TypeMask = TypeMask;
+
+	return Handle;
+}
+
+void FOMRRaceEventBus::RemoveListener(FDelegateHandle Handle)
+{
+	AddedWhileDispatching.RemoveAll([Handle](const FListener& Listener) { return Listener.Delegate.GetHandle() == Handle; });
+
+	for (int32 Index = 0; Index < Listeners.Num(); ++Index)
+	{
+		if (Listeners[Index].Delegate.GetHandle() != Handle) continue;
+
+		// Unbound now, compacted once the dispatch is done
+		if (bDispatching)
+		{
+			Listeners[Index].Delegate.Unbind();
+			bRemovedWhileDispatching = true;
+		}
+		else
+		{
+			Listeners.RemoveAt(Index);
+		}
+
+		return;
+	}
+}
+
+void FOMRRaceEventBus::Post(const FOMRRaceEvent& Event)
+{
+	Pending.Add(Event);
+	PendingTypes |= GetTypeBit(Event.Type);
+}
+
+void FOMRRaceEventBus::Flush()
+{
+	if (Pending.Num() == 0 || bDispatching) return;
+
+	const uint32 Types = PendingTypes;
+
+	Swap(Pending, Dispatching);
+	Pending.Reset();
+	PendingTypes = 0;
+
+	bDispatching = true;
+
+	for (int32 Index = 0; Index < Listeners.Num(); ++Index)
+	{
+		if ((Listeners[Index].TypeMask & Types) == 0) continue;
+
+		Listeners[Index].Delegate.ExecuteIfBound(Dispatching);
+	}
+
+	bDispatching = false;
+
+	if (bRemovedWhileDispatching)
+	{
+		bRemovedWhileDispatching = false;
+		Listeners.RemoveAll([](const FListener& Listener) { return !Listener.Delegate.IsBound(); });
+	}
+
+	// Listeners added during the dispatch wait for the next batch
+	if (AddedWhileDispatching.Num() > 0)
+	{
+		Listeners.Append(MoveTemp(AddedWhileDispatching));
+		AddedWhileDispatching.Reset();
+	}
+
+	Dispatching.Reset();
+}
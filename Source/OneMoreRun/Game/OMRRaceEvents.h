@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OMRRaceEvents.generated.h"
+
+UENUM(BlueprintType)
+enum class EOMRRaceEvent : uint8
+{
+	LapStart,
+	LapComplete,
+	// Checkpoint crossing with a best lap to compare against, always follows its Checkpoint
+	Split,
+	Checkpoint,
+	// Count 0 is GO
+	CountdownTick,
+	Landing,
+	Respawn,
+	Reset,
+};
+
+USTRUCT(BlueprintType)
+struct FOMRRaceEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EOMRRaceEvent Type = EOMRRaceEvent::Reset;
+
+	// Stamped by AOMRTimeTrialGameState::PostRaceEvent
+	UPROPERTY(BlueprintReadOnly)
+	double WorldTime = 0.0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Lap = 0;
+
+	// Checkpoint, Split and Respawn, INDEX_NONE respawns at the gate
+	UPROPERTY(BlueprintReadOnly)
+	int32 Checkpoint = INDEX_NONE;
+
+	// Lap time for LapComplete, split time for Checkpoint and Split
+	UPROPERTY(BlueprintReadOnly)
+	float Time = 0.f;
+
+	// Split against the best lap, negative is ahead
+	UPROPERTY(BlueprintReadOnly)
+	float Delta = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bNewBest = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Count = 0;
+
+	// Landing, vertical speed at touchdown
+	UPROPERTY(BlueprintReadOnly)
+	float ImpactSpeed = 0.f;
+
+	static FOMRRaceEvent MakeLapStart(int32 InLap);
+	static FOMRRaceEvent MakeLapComplete(int32 InLap, float LapTime, bool bInNewBest);
+	static FOMRRaceEvent MakeCheckpoint(int32 InCheckpoint, float SplitTime);
+	static FOMRRaceEvent MakeSplit(int32 InCheckpoint, float SplitTime, float SplitDelta);
+	static FOMRRaceEvent MakeCountdownTick(int32 InCount);
+	static FOMRRaceEvent MakeLanding(float InImpactSpeed);
+	static FOMRRaceEvent MakeRespawn(int32 InCheckpoint);
+	static FOMRRaceEvent MakeReset();
+};
+
+// Every event of one frame, in the order they were posted
+DECLARE_DELEGATE_OneParam(FOMRRaceEventListener, TConstArrayView<FOMRRaceEvent>);
+
+/**
+ * Race events for native listeners (HUD, telemetry, audio, ghosts).
+ *
+ * Events posted during a frame are held and handed out once, in Flush, as one batch per
+ * listener, through plain delegates. A listener only registered for some types is skipped on
+ * frames without them, but still gets the whole batch and filters it itself.
+ */
+class ONEMORERUN_API FOMRRaceEventBus
+{
+public:
+	static constexpr uint32 AllEvents = ~0u;
+	static uint32 GetTypeBit(EOMRRaceEvent Type) { return 1u << (uint32)Type; }
+
+	FDelegateHandle AddListener(FOMRRaceEventListener Listener, uint32 TypeMask = AllEvents);
+	void RemoveListener(FDelegateHandle Handle);
+
+	void Post(const FOMRRaceEvent& Event);
+
+	// Events posted by listeners during Flush go out with the next one
+	void Flush();
+
+	int32 NumListeners() const { return Listeners.Num(); }
+	int32 NumPending() const { return Pending.Num(); }
+
+private:
+	struct FListener
+	{
+		FOMRRaceEventListener Delegate;
+		uint32 TypeMask = AllEvents;
+	};
+
+	TArray<FListener> Listeners;
+
+	// Added by a listener during Flush, joins after it so Listeners never reallocates mid-call
+	TArray<FListener> AddedWhileDispatching;
+
+	TArray<FOMRRaceEvent> Pending;
+	uint32 PendingTypes = 0;
+
+	// Swapped with Pending for the dispatch, both keep their allocation
+	TArray<FOMRRaceEvent> Dispatching;
+
+	bool bDispatching = false;
+	bool bRemovedWhileDispatching = false;
+};
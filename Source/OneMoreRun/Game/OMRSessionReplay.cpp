@@ -0,0 +1,442 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRSessionReplay.h"
+#include "OMRGhostRecorder.h"
+
+namespace OMRReplay
+{
+	enum EFrameFlags : uint8
+	{
+		Flag_Grounded = 1 << 0,
+		Flag_Teleport = 1 << 1,
+	};
+
+	constexpr int32 LocationBytes = 6 * sizeof(int16);
+	constexpr int32 TailBytes = 27;
+	constexpr int32 TailFlagsOffset = TailBytes - 1;
+
+	static_assert(FOMRSessionReplay::KeyframeBytes == 6 * sizeof(float) + TailBytes, "Keyframe layout");
+	static_assert(FOMRSessionReplay::DeltaBytes == LocationBytes + TailBytes, "Delta layout");
+
+	template <typename T>
+	FORCEINLINE void Write(uint8*& Cursor, T Value)
+	{
+		FMemory::Memcpy(Cursor, &Value, sizeof(T));
+		Cursor += sizeof(T);
+	}
+
+	template <typename T>
+	FORCEINLINE T Read(const uint8*& Cursor)
+	{
+		T Value;
+		FMemory::Memcpy(&Value, Cursor, sizeof(T));
+		Cursor += sizeof(T);
+		return Value;
+	}
+
+	FORCEINLINE int16 QuantizeInt16(double Value)
+	{
+		return (int16)FMath::Clamp<int64>(FMath::RoundToInt64(Value), MIN_int16, MAX_int16);
+	}
+
+	FORCEINLINE bool FitsInt16(const FVector& Value)
+	{
+		return Value.GetAbsMax() < (double)MAX_int16;
+	}
+
+	FORCEINLINE uint8 QuantizeUInt8(float Value, float Scale)
+	{
+		return (uint8)FMath::Clamp(FMath::RoundToInt(Value * Scale), 0, MAX_uint8);
+	}
+
+	FORCEINLINE uint16 QuantizeUInt16(float Value, float Scale)
+	{
+		return (uint16)FMath::Clamp(FMath::RoundToInt(Value * Scale), 0, MAX_uint16);
+	}
+
+	void WriteTail(uint8*& Cursor, const FOMRReplayFrame& Frame, uint8 Flags)
+	{
+		Write<uint32>(Cursor, FOMRGhostTrack::PackRotation(Frame.BallRotation));
+		Write<int16>(Cursor, QuantizeInt16(Frame.BallVelocity.X));
+		Write<int16>(Cursor, QuantizeInt16(Frame.BallVelocity.Y));
+		Write<int16>(Cursor, QuantizeInt16(Frame.BallVelocity.Z));
+
+		Write<uint32>(Cursor, FOMRGhostTrack::PackRotation(Frame.CameraRotation));
+
+		const FVector MoveDir = Frame.SmoothedMoveDir.GetClampedToMaxSize(1.0) * MAX_int16;
+		Write<int16>(Cursor, QuantizeInt16(MoveDir.X));
+		Write<int16>(Cursor, QuantizeInt16(MoveDir.Y));
+		Write<int16>(Cursor, QuantizeInt16(MoveDir.Z));
+
+		Write<uint16>(Cursor, QuantizeUInt16(Frame.CameraDistance, 1.f));
+		Write<uint16>(Cursor, QuantizeUInt16(Frame.FOV, 100.f));
+		Write<uint8>(Cursor, QuantizeUInt8(Frame.RollPitch, 100.f));
+		Write<uint8>(Cursor, QuantizeUInt8(Frame.RollVolume, 200.f));
+		Write<uint8>(Cursor, Flags | (Frame.bGrounded ? Flag_Grounded : 0));
+	}
+
+	void ReadTail(const uint8*& Cursor, FOMRReplayFrame& OutFrame)
+	{
+		OutFrame.BallRotation = FOMRGhostTrack::UnpackRotation(Read<uint32>(Cursor));
+
+		const int16 VelX = Read<int16>(Cursor);
+		const int16 VelY = Read<int16>(Cursor);
+		const int16 VelZ = Read<int16>(Cursor);
+		OutFrame.BallVelocity = FVector(VelX, VelY, VelZ);
+
+		OutFrame.CameraRotation = FOMRGhostTrack::UnpackRotation(Read<uint32>(Cursor));
+
+		const int16 DirX = Read<int16>(Cursor);
+		const int16 DirY = Read<int16>(Cursor);
+		const int16 DirZ = Read<int16>(Cursor);
+		OutFrame.SmoothedMoveDir = FVector(DirX, DirY, DirZ) / MAX_int16;
+
+		OutFrame.CameraDistance = Read<uint16>(Cursor);
+		OutFrame.FOV = Read<uint16>(Cursor) / 100.f;
+		OutFrame.RollPitch = Read<uint8>(Cursor) / 100.f;
+		OutFrame.RollVolume = Read<uint8>(Cursor) / 200.f;
+		OutFrame.bGrounded = (Read<uint8>(Cursor) & Flag_Grounded) != 0;
+	}
+}
+
+void FOMRReplayRaceState::Apply(const FOMRReplayEvent& Event)
+{
+	switch (Event.Type)
+	{
+	case EOMRReplayEvent::Countdown:
+		Countdown = Event.Value;
+		break;
+
+	case EOMRReplayEvent::CountdownGo:
+		Countdown = 0;
+		break;
+
+	case EOMRReplayEvent::LapStart:
+		Lap = Event.Value;
+		CheckpointIndex = 0;
+		bLapActive = true;
+		LapStartTime = Event.A;
+		break;
+
+	case EOMRReplayEvent::LapComplete:
+		bLapActive = false;
+		if (Event.Flags)
+		{
+			BestLapTime = Event.A;
+		}
+		break;
+
+	case EOMRReplayEvent::Split:
+		CheckpointIndex = Event.Value + 1;
+		break;
+
+	case EOMRReplayEvent::LapClock:
+		CheckpointIndex = Event.Value;
+		LapStartTime = Event.A;
+		break;
+
+	case EOMRReplayEvent::BestLoaded:
+		BestLapTime = Event.A;
+		break;
+
+	case EOMRReplayEvent::Restart:
+	{
+		// Best lap survives a restart
+		const float Best = BestLapTime;
+		*this = FOMRReplayRaceState();
+		BestLapTime = Best;
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+void FOMRSessionReplay::Init(float MaxDuration)
+{
+	Capacity = FMath::CeilToInt(FMath::Max(MaxDuration, 0.f) * FrameRate) + 1;
+
+	const int32 NumKeyframes = (Capacity + KeyframeInterval - 1) / KeyframeInterval;
+
+	Bytes.SetNumUninitialized(NumKeyframes * BlockBytes);
+	KeyframeRaceStates.Reserve(NumKeyframes);
+	KeyframeFirstEvent.Reserve(NumKeyframes);
+
+	// A few per checkpoint and landing, and a teleport per respawn or restart
+	EventCapacity = FMath::Max(FMath::CeilToInt(MaxDuration * EventsPerSecond), 256);
+	TeleportCapacity = FMath::Max(FMath::CeilToInt(MaxDuration * TeleportsPerSecond), 32);
+
+	Events.Reserve(EventCapacity);
+	TeleportLocations.Reserve(TeleportCapacity * 2);
+
+	Reset();
+}
+
+void FOMRSessionReplay::Reset()
+{
+	NumFrames = 0;
+	bTruncated = false;
+
+	KeyframeRaceStates.Reset();
+	KeyframeFirstEvent.Reset();
+	Events.Reset();
+	TeleportLocations.Reset();
+
+	LastBallLocation = FVector::ZeroVector;
+	LastCameraLocation = FVector::ZeroVector;
+	CursorIndex = INDEX_NONE;
+}
+
+int32 FOMRSessionReplay::GetByteOffset(int32 Index)
+{
+	const int32 Block = Index / KeyframeInterval;
+	const int32 InBlock = Index % KeyframeInterval;
+
+	return Block * BlockBytes + (InBlock == 0 ? 0 : KeyframeBytes + (InBlock - 1) * DeltaBytes);
+}
+
+bool FOMRSessionReplay::Record(const FOMRReplayFrame& Frame, const FOMRReplayRaceState& RaceState)
+{
+	if (bTruncated || NumFrames >= Capacity)
+	{
+		bTruncated = true;
+		return false;
+	}
+
+	uint8* Cursor = Bytes.GetData() + GetByteOffset(NumFrames);
+	uint8 Flags = 0;
+
+	if (NumFrames % KeyframeInterval == 0)
+	{
+		const FVector3f Ball(Frame.BallLocation);
+		const FVector3f Camera(Frame.CameraLocation);
+
+		OMRReplay::Write<float>(Cursor, Ball.X);
+		OMRReplay::Write<float>(Cursor, Ball.Y);
+		OMRReplay::Write<float>(Cursor, Ball.Z);
+		OMRReplay::Write<float>(Cursor, Camera.X);
+		OMRReplay::Write<float>(Cursor, Camera.Y);
+		OMRReplay::Write<float>(Cursor, Camera.Z);
+
+		LastBallLocation = FVector(Ball);
+		LastCameraLocation = FVector(Camera);
+
+		KeyframeRaceStates.Add(RaceState);
+		KeyframeFirstEvent.Add(Events.Num());
+	}
+	else
+	{
+		// Against the decoded locations, so quantization error doesn't accumulate
+		const FVector BallDelta = (Frame.BallLocation - LastBallLocation) / LocationStep;
+		const FVector CameraDelta = (Frame.CameraLocation - LastCameraLocation) / LocationStep;
+
+		if (OMRReplay::FitsInt16(BallDelta) && OMRReplay::FitsInt16(CameraDelta))
+		{
+			const int16 BallX = OMRReplay::QuantizeInt16(BallDelta.X);
+			const int16 BallY = OMRReplay::QuantizeInt16(BallDelta.Y);
+			const int16 BallZ = OMRReplay::QuantizeInt16(BallDelta.Z);
+			const int16 CameraX = OMRReplay::QuantizeInt16(CameraDelta.X);
+			const int16 CameraY = OMRReplay::QuantizeInt16(CameraDelta.Y);
+			const int16 CameraZ = OMRReplay::QuantizeInt16(CameraDelta.Z);
+
+			OMRReplay::Write<int16>(Cursor, BallX);
+			OMRReplay::Write<int16>(Cursor, BallY);
+			OMRReplay::Write<int16>(Cursor, BallZ);
+			OMRReplay::Write<int16>(Cursor, CameraX);
+			OMRReplay::Write<int16>(Cursor, CameraY);
+			OMRReplay::Write<int16>(Cursor, CameraZ);
+
+			LastBallLocation += FVector(BallX, BallY, BallZ) * LocationStep;
+			LastCameraLocation += FVector(CameraX, CameraY, CameraZ) * LocationStep;
+		}
+		else
+		{
+			if (TeleportLocations.Num() >= TeleportCapacity * 2)
+			{
+				bTruncated = true;
+				return false;
+			}
+
+			const uint32 Teleport = (uint32)TeleportLocations.Num() / 2;
+
+			TeleportLocations.Add(FVector3f(Frame.BallLocation));
+			TeleportLocations.Add(FVector3f(Frame.CameraLocation));
+
+			OMRReplay::Write<uint32>(Cursor, Teleport);
+			OMRReplay::Write<uint32>(Cursor, 0);
+			OMRReplay::Write<uint32>(Cursor, 0);
+
+			LastBallLocation = FVector(TeleportLocations[Teleport * 2]);
+			LastCameraLocation = FVector(TeleportLocations[Teleport * 2 + 1]);
+
+			Flags |= OMRReplay::Flag_Teleport;
+		}
+	}
+
+	OMRReplay::WriteTail(Cursor, Frame, Flags);
+
+	++NumFrames;
+	return true;
+}
+
+bool FOMRSessionReplay::AddEvent(const FOMRReplayEvent& Event)
+{
+	// Frames after a dropped event would play back with the wrong HUD, stop both together
+	if (bTruncated || Events.Num() >= EventCapacity)
+	{
+		bTruncated = true;
+		return false;
+	}
+
+	Events.Add(Event);
+	return true;
+}
+
+void FOMRSessionReplay::DecodeLocations(int32 Index, FVector& OutBall, FVector& OutCamera) const
+{
+	const int32 KeyIndex = Index - Index % KeyframeInterval;
+
+	int32 From;
+
+	// Continue from the last decoded frame when it's earlier in the same block
+	if (CursorIndex >= KeyIndex && CursorIndex <= Index)
+	{
+		From = CursorIndex;
+		OutBall = CursorBallLocation;
+		OutCamera = CursorCameraLocation;
+	}
+	else
+	{
+		const uint8* Cursor = Bytes.GetData() + GetByteOffset(KeyIndex);
+
+		const float BallX = OMRReplay::Read<float>(Cursor);
+		const float BallY = OMRReplay::Read<float>(Cursor);
+		const float BallZ = OMRReplay::Read<float>(Cursor);
+		const float CameraX = OMRReplay::Read<float>(Cursor);
+		const float CameraY = OMRReplay::Read<float>(Cursor);
+		const float CameraZ = OMRReplay::Read<float>(Cursor);
+
+		From = KeyIndex;
+		OutBall = FVector(BallX, BallY, BallZ);
+		OutCamera = FVector(CameraX, CameraY, CameraZ);
+	}
+
+	for (int32 i = From + 1; i <= Index; ++i)
+	{
+		const uint8* Cursor = Bytes.GetData() + GetByteOffset(i);
+
+		if (Cursor[OMRReplay::LocationBytes + OMRReplay::TailFlagsOffset] & OMRReplay::Flag_Teleport)
+		{
+			const uint32 Teleport = OMRReplay::Read<uint32>(Cursor);
+
+			OutBall = FVector(TeleportLocations[Teleport * 2]);
+			OutCamera = FVector(TeleportLocations[Teleport * 2 + 1]);
+			continue;
+		}
+
+		const int16 BallX = OMRReplay::Read<int16>(Cursor);
+		const int16 BallY = OMRReplay::Read<int16>(Cursor);
+		const int16 BallZ = OMRReplay::Read<int16>(Cursor);
+		const int16 CameraX = OMRReplay::Read<int16>(Cursor);
+		const int16 CameraY = OMRReplay::Read<int16>(Cursor);
+		const int16 CameraZ = OMRReplay::Read<int16>(Cursor);
+
+		OutBall += FVector(BallX, BallY, BallZ) * LocationStep;
+		OutCamera += FVector(CameraX, CameraY, CameraZ) * LocationStep;
+	}
+
+	CursorIndex = Index;
+	CursorBallLocation = OutBall;
+	CursorCameraLocation = OutCamera;
+}
+
+void FOMRSessionReplay::GetFrame(int32 Index, FOMRReplayFrame& OutFrame) const
+{
+	check(Index >= 0 && Index < NumFrames);
+
+	DecodeLocations(Index, OutFrame.BallLocation, OutFrame.CameraLocation);
+
+	const bool bKeyframe = Index % KeyframeInterval == 0;
+	const uint8* Tail = Bytes.GetData() + GetByteOffset(Index) + (bKeyframe ? 6 * sizeof(float) : OMRReplay::LocationBytes);
+
+	OMRReplay::ReadTail(Tail, OutFrame);
+}
+
+bool FOMRSessionReplay::Evaluate(float Time, FOMRReplayFrame& OutFrame) const
+{
+	if (NumFrames == 0) return false;
+
+	const float FrameTime = FMath::Clamp(Time * FrameRate, 0.f, (float)(NumFrames - 1));
+
+	const int32 Index0 = FMath::FloorToInt(FrameTime);
+	const int32 Index1 = FMath::Min(Index0 + 1, NumFrames - 1);
+	const float Alpha = FrameTime - Index0;
+
+	FOMRReplayFrame A;
+	FOMRReplayFrame B;
+	GetFrame(Index0, A);
+	GetFrame(Index1, B);
+
+	// A teleport is shown as a cut, not a flight across the track
+	const uint8* Flags = Bytes.GetData() + GetByteOffset(Index1) + (Index1 % KeyframeInterval == 0 ? 6 * sizeof(float) : OMRReplay::LocationBytes) + OMRReplay::TailFlagsOffset;
+	const float Blend = (*Flags & OMRReplay::Flag_Teleport) ? 0.f : Alpha;
+
+	OutFrame.BallLocation = FMath::Lerp(A.BallLocation, B.BallLocation, (double)Blend);
+	OutFrame.BallRotation = FQuat::Slerp(A.BallRotation, B.BallRotation, Blend);
+	OutFrame.BallVelocity = FMath::Lerp(A.BallVelocity, B.BallVelocity, (double)Blend);
+	OutFrame.bGrounded = Blend < 0.5f ? A.bGrounded : B.bGrounded;
+
+	OutFrame.CameraLocation = FMath::Lerp(A.CameraLocation, B.CameraLocation, (double)Blend);
+	OutFrame.CameraRotation = FQuat::Slerp(A.CameraRotation, B.CameraRotation, Blend);
+	OutFrame.SmoothedMoveDir = FMath::Lerp(A.SmoothedMoveDir, B.SmoothedMoveDir, (double)Blend).GetSafeNormal();
+	OutFrame.CameraDistance = FMath::Lerp(A.CameraDistance, B.CameraDistance, Blend);
+	OutFrame.FOV = FMath::Lerp(A.FOV, B.FOV, Blend);
+
+	OutFrame.RollPitch = FMath::Lerp(A.RollPitch, B.RollPitch, Blend);
+	OutFrame.RollVolume = FMath::Lerp(A.RollVolume, B.RollVolume, Blend);
+
+	return true;
+}
+
+void FOMRSessionReplay::GetRaceState(float Time, FOMRReplayRaceState& OutState) const
+{
+	if (KeyframeRaceStates.Num() == 0)
+	{
+		OutState = FOMRReplayRaceState();
+		return;
+	}
+
+	const int32 Keyframe = FMath::Clamp(FMath::FloorToInt(Time * FrameRate) / KeyframeInterval, 0, KeyframeRaceStates.Num() - 1);
+
+	OutState = KeyframeRaceStates[Keyframe];
+
+	for (int32 Index = KeyframeFirstEvent[Keyframe]; Index < Events.Num() && Events[Index].Time <= Time; ++Index)
+	{
+		OutState.Apply(Events[Index]);
+	}
+}
+
+int32 FOMRSessionReplay::FindFirstEventAfter(float Time) const
+{
+	if (KeyframeFirstEvent.Num() == 0) return Events.Num();
+
+	// A keyframe is recorded a little after its nominal time, so start one keyframe early
+	const int32 Keyframe = FMath::Clamp(FMath::FloorToInt(Time * FrameRate) / KeyframeInterval - 1, 0, KeyframeFirstEvent.Num() - 1);
+
+	int32 Index = KeyframeFirstEvent[Keyframe];
+
+	while (Index < Events.Num() && Events[Index].Time <= Time)
+	{
+		++Index;
+	}
+
+	return Index;
+}
+
+int32 FOMRSessionReplay::GetAllocatedSize() const
+{
+	return Bytes.GetAllocatedSize() + KeyframeRaceStates.GetAllocatedSize() + KeyframeFirstEvent.GetAllocatedSize() +
+		Events.GetAllocatedSize() + TeleportLocations.GetAllocatedSize();
+}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// What the player saw in one frame: ball, camera rig and the rolling sound
+struct FOMRReplayFrame
+{
+	FVector BallLocation = FVector::ZeroVector;
+	FQuat BallRotation = FQuat::Identity;
+	FVector BallVelocity = FVector::ZeroVector;
+	bool bGrounded = false;
+
+	FVector CameraLocation = FVector::ZeroVector;
+	FQuat CameraRotation = FQuat::Identity;
+	FVector SmoothedMoveDir = FVector::ForwardVector;
+	float CameraDistance = 0.f;
+	float FOV = 90.f;
+
+	float RollPitch = 1.f;
+	float RollVolume = 0.f;
+};
+
+enum class EOMRReplayEvent : uint8
+{
+	Countdown,		// Value: number shown
+	CountdownGo,
+	LapStart,		// Value: lap, A: session time of the crossing
+	LapComplete,	// Value: lap, A: lap time, Flags: new best
+	Split,			// Value: checkpoint, A: split time, B: delta to best, Flags: has a best to compare
+	LapClock,		// Value: checkpoint index, A: lap start session time. Rewinds move the lap clock
+	Landing,		// A: volume, B: pitch
+	Respawn,		// Value: checkpoint, INDEX_NONE for the gate
+	Restart,
+	BestLoaded,		// A: saved best lap time, read from disk when the first lap started
+};
+
+struct FOMRReplayEvent
+{
+	// Seconds into the session
+	float Time = 0.f;
+	EOMRReplayEvent Type = EOMRReplayEvent::Restart;
+	uint8 Flags = 0;
+	int32 Value = 0;
+	float A = 0.f;
+	float B = 0.f;
+};
+
+// HUD side of the race, kept on every keyframe and brought forward by events
+struct FOMRReplayRaceState
+{
+	int32 Lap = 0;
+	int32 CheckpointIndex = 0;
+	bool bLapActive = false;
+	float LapStartTime = 0.f;
+	float BestLapTime = -1.f;
+
+	// Countdown number on screen, 0 after GO
+	int32 Countdown = 0;
+
+	void Apply(const FOMRReplayEvent& Event);
+
+	float GetLapTime(float Time) const { return bLapActive ? Time - LapStartTime : 0.f; }
+};
+
+/**
+ * Everything of a play session at FrameRate, for watching it back from any point.
+ *
+ * Frames are stored like FOMRGhostTrack samples, in fixed-size blocks of one keyframe per
+ * second and delta frames after it, so any frame is found without an index and decoded by
+ * walking at most KeyframeInterval - 1 deltas:
+ *   Keyframe (51 bytes): float BallLocation[3] | float CameraLocation[3] | Tail
+ *   Delta    (39 bytes): int16 BallDelta[3] | int16 CameraDelta[3] | Tail
+ *   Tail     (27 bytes): uint32 BallRotation | int16 Velocity[3] | uint32 CameraRotation |
+ *                        int16 MoveDir[3] | uint16 CameraDistance | uint16 FOV | uint8 Pitch |
+ *                        uint8 Volume | uint8 Flags
+ * A delta frame whose jump doesn't fit (respawn, restart) holds an index into
+ * TeleportLocations instead.
+ *
+ * Events (splits, laps, countdown, landings) are kept in time order next to the frames, each
+ * keyframe records the race state and the first event after it.
+ */
+class ONEMORERUN_API FOMRSessionReplay
+{
+public:
+	static constexpr float FrameRate = 30.f;
+	static constexpr int32 KeyframeInterval = 30;
+	static constexpr int32 KeyframeBytes = 51;
+	static constexpr int32 DeltaBytes = 39;
+	static constexpr int32 BlockBytes = KeyframeBytes + (KeyframeInterval - 1) * DeltaBytes;
+	static constexpr float LocationStep = 0.1f;
+
+	static constexpr float EventsPerSecond = 4.f;
+	static constexpr float TeleportsPerSecond = 0.5f;
+
+	// Allocates frames, events and teleports for MaxDuration seconds (~2.3 MB for 30 minutes).
+	// Nothing grows while recording, the recording stops when any of them is full
+	void Init(float MaxDuration);
+	void Reset();
+
+	bool IsInitialized() const { return Capacity > 0; }
+
+	// True while the frame for session time Time hasn't been recorded yet
+	bool WantsFrame(float Time) const { return !bTruncated && NumFrames < Capacity && Time >= NumFrames / FrameRate; }
+
+	// Appends the next frame, RaceState is stored if it lands on a keyframe
+	bool Record(const FOMRReplayFrame& Frame, const FOMRReplayRaceState& RaceState);
+
+	// Times never go backwards. False once the recording is truncated
+	bool AddEvent(const FOMRReplayEvent& Event);
+
+	int32 Num() const { return NumFrames; }
+	bool IsTruncated() const { return bTruncated; }
+	float GetDuration() const { return NumFrames > 1 ? (NumFrames - 1) / FrameRate : 0.f; }
+
+	void GetFrame(int32 Index, FOMRReplayFrame& OutFrame) const;
+
+	// Interpolated frame at Time, clamped to the recording
+	bool Evaluate(float Time, FOMRReplayFrame& OutFrame) const;
+
+	// Race state of the keyframe before Time with the events up to Time applied
+	void GetRaceState(float Time, FOMRReplayRaceState& OutState) const;
+
+	// Events with From < Time <= To, in order
+	template <typename FunctionType>
+	void ForEachEvent(float From, float To, FunctionType&& Function) const
+	{
+		for (int32 Index = FindFirstEventAfter(From); Index < Events.Num() && Events[Index].Time <= To; ++Index)
+		{
+			Function(Events[Index]);
+		}
+	}
+
+	int32 GetAllocatedSize() const;
+
+	static int32 GetByteOffset(int32 Index);
+
+private:
+	int32 FindFirstEventAfter(float Time) const;
+
+	// Walks the location deltas from the keyframe, or on from the last decoded frame
+	void DecodeLocations(int32 Index, FVector& OutBall, FVector& OutCamera) const;
+
+	TArray<uint8> Bytes;
+	int32 Capacity = 0;
+	int32 EventCapacity = 0;
+	int32 TeleportCapacity = 0;
+	int32 NumFrames = 0;
+	bool bTruncated = false;
+
+	// Per keyframe
+	TArray<FOMRReplayRaceState> KeyframeRaceStates;
+	TArray<int32> KeyframeFirstEvent;
+
+	TArray<FOMRReplayEvent> Events;
+
+	// Ball then camera location of every frame that jumped too far for a delta
+	TArray<FVector3f> TeleportLocations;
+
+	// Decoded locations of the last recorded frame, deltas are taken against these
+	FVector LastBallLocation = FVector::ZeroVector;
+	FVector LastCameraLocation = FVector::ZeroVector;
+
+	// Sequential playback walks forward from here instead of the block keyframe
+	mutable int32 CursorIndex = INDEX_NONE;
+	mutable FVector CursorBallLocation = FVector::ZeroVector;
+	mutable FVector CursorCameraLocation = FVector::ZeroVector;
+};
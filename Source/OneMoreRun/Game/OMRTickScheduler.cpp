@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTickScheduler.h"
+#include "../OneMoreRun.h"
+#include "GameFramework/Actor.h"
+#include "Engine/Level.h"
+
+void FOMRTickTask::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (!Work) return;
+
+	if (Scheduler && Scheduler->IsCountdownActive() && !bRunDuringCountdown)
+	{
+		FramesSinceRun = 0;
+		AccumulatedDelta = 0.f;
+		return;
+	}
+
+	AccumulatedDelta += DeltaTime;
+
+	if (++FramesSinceRun < RateDivisor) return;
+
+	{
+		OMR_GAMEPLAY_SCOPE();
+		Work(AccumulatedDelta);
+	}
+
+	FramesSinceRun = 0;
+	AccumulatedDelta = 0.f;
+}
+
+FString FOMRTickTask::DiagnosticMessage()
+{
+	return FString::Printf(TEXT("FOMRTickTask[%s]"), *TaskName.ToString());
+}
+
+FName FOMRTickTask::DiagnosticContext(bool bDetailed)
+{
+	return TaskName;
+}
+
+FOMRTickTask& FOMRTickScheduler::AddTask(FName Name, ETickingGroup TickGroup, TFunction<void(float)> Work, int32 RateDivisor, float MaxRateHz, bool bRunDuringCountdown)
+{
+	TUniquePtr<FOMRTickTask>& Task = Tasks.Add_GetRef(MakeUnique<FOMRTickTask>());
+
+	Task->TaskName = Name;
+	Task->Work = MoveTemp(Work);
+	Task->RateDivisor = FMath::Max(RateDivisor, 1);
+	Task->bRunDuringCountdown = bRunDuringCountdown;
+	Task->Scheduler = this;
+
+	Task->bCanEverTick = true;
+	Task->bStartWithTickEnabled = true;
+	Task->TickGroup = TickGroup;
+	Task->TickInterval = MaxRateHz > 0.f ? 1.f / MaxRateHz : 0.f;
+
+	return *Task;
+}
+
+void FOMRTickScheduler::Register(AActor* Owner)
+{
+	if (!Owner) return;
+
+	for (TUniquePtr<FOMRTickTask>& Task : Tasks)
+	{
+		if (Task->IsTickFunctionRegistered()) continue;
+
+		// Never run ahead of the owner's own tick in the same group
+		Task->AddPrerequisite(Owner, Owner->PrimaryActorTick);
+		Task->RegisterTickFunction(Owner->GetLevel());
+	}
+}
+
+void FOMRTickScheduler::Unregister()
+{
+	for (TUniquePtr<FOMRTickTask>& Task : Tasks)
+	{
+		if (Task->IsTickFunctionRegistered())
+		{
+			Task->UnRegisterTickFunction();
+		}
+	}
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+
+class AActor;
+class FOMRTickScheduler;
+
+/**
+ * One piece of gameplay work ticked as its own FTickFunction, so it can live in the
+ * tick group it needs and run slower than the frame rate.
+ */
+struct ONEMORERUN_API FOMRTickTask : public FTickFunction
+{
+	FName TaskName;
+	TFunction<void(float)> Work;
+
+	// Run every Nth frame, DeltaTime is accumulated across skipped frames
+	int32 RateDivisor = 1;
+
+	bool bRunDuringCountdown = false;
+
+	FOMRTickScheduler* Scheduler = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	virtual FName DiagnosticContext(bool bDetailed) override;
+
+private:
+	int32 FramesSinceRun = 0;
+	float AccumulatedDelta = 0.f;
+};
+
+/**
+ * Owns an actor's extra tick functions. Register/Unregister from RegisterActorTickFunctions.
+ */
+class ONEMORERUN_API FOMRTickScheduler
+{
+public:
+	// MaxRateHz > 0 uses the engine tick interval, RateDivisor skips frames on top of that
+	FOMRTickTask& AddTask(
+		FName Name,
+		ETickingGroup TickGroup,
+		TFunction<void(float)> Work,
+		int32 RateDivisor = 1,
+		float MaxRateHz = 0.f,
+		bool bRunDuringCountdown = false
+	);
+
+	bool HasTasks() const { return Tasks.Num() > 0; }
+
+	void Register(AActor* Owner);
+	void Unregister();
+
+	// While set, only tasks flagged bRunDuringCountdown execute
+	void SetCountdownActive(bool bActive) { bCountdownActive = bActive; }
+	bool IsCountdownActive() const { return bCountdownActive; }
+
+private:
+	TArray<TUniquePtr<FOMRTickTask>> Tasks;
+	bool bCountdownActive = false;
+};
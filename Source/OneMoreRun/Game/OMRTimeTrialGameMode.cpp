@@ -6,6 +6,9 @@
 #include "Kismet/GameplayStatics.h"
 #include "Components/AudioComponent.h"
 #include "Sound/SoundBase.h"
+#include "Sound/SoundWave.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
 
 AOMRTimeTrialGameMode::AOMRTimeTrialGameMode()
 {
@@ -16,9 +19,43 @@ void AOMRTimeTrialGameMode::BeginPlay()
 {
 	Super::BeginPlay();
 
+	if (AOMRTimeTrialGameState* GS = GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->GetRaceEvents().AddListener(
+			FOMRRaceEventListener::CreateUObject(this, &AOMRTimeTrialGameMode::HandleRaceEvents),
+			FOMRRaceEventBus::GetTypeBit(EOMRRaceEvent::Reset));
+	}
+
+	// Nothing is loaded with the map, the first track plays once its async load is done
+	PrefetchNextTrack();
 	PlayNextTrack();
 }
 
+void AOMRTimeTrialGameMode::HandleRaceEvents(TConstArrayView<FOMRRaceEvent> Events)
+{
+	for (const FOMRRaceEvent& Event : Events)
+	{
+		// Several restarts in one frame still restart the music once
+		if (Event.Type == EOMRRaceEvent::Reset)
+		{
+			HandleRaceRestarted();
+			return;
+		}
+	}
+}
+
+void AOMRTimeTrialGameMode::HandleRaceRestarted()
+{
+	UAudioComponent* Current = GetCurrentMusicComponent();
+	if (!bRestartMusicWithRace || !Current || !Current->Sound) return;
+
+	// Same component, no spawn
+	Current->SetVolumeMultiplier(1.0f);
+	Current->Play(0.f);
+
+	ScheduleNextTrack(Current->Sound);
+}
+
 int32 AOMRTimeTrialGameMode::GetRandomTrackIndex()
 {
 	if (LevelMusicTracks.Num() == 0) return -1;
@@ -35,34 +72,127 @@ int32 AOMRTimeTrialGameMode::GetRandomTrackIndex()
 	return NewIndex;;
 }
 
+void AOMRTimeTrialGameMode::PrefetchNextTrack()
+{
+	if (NextTrack || NextTrackHandle.IsValid()) return;
+
+	const int32 Index = GetRandomTrackIndex();
+	if (Index < 0 || LevelMusicTracks[Index].IsNull()) return;
+
+	NextTrackHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		LevelMusicTracks[Index].ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &AOMRTimeTrialGameMode::HandleNextTrackLoaded),
+		FStreamableManager::AsyncLoadLowPriority);
+
+	// Already in memory, the delegate ran before the handle was stored
+	if (NextTrackHandle.IsValid() && NextTrackHandle->HasLoadCompleted() && !NextTrack)
+	{
+		HandleNextTrackLoaded();
+	}
+}
+
+void AOMRTimeTrialGameMode::HandleNextTrackLoaded()
+{
+	if (!NextTrackHandle.IsValid() || !NextTrackHandle->HasLoadCompleted()) return;
+
+	NextTrack = Cast<USoundBase>(NextTrackHandle->GetLoadedAsset());
+
+	// NextTrack holds it from here, the handle would keep it loaded after it's dropped
+	NextTrackHandle->ReleaseHandle();
+	NextTrackHandle.Reset();
+
+#if !UE_BUILD_SHIPPING
+	if (const USoundWave* Wave = Cast<USoundWave>(NextTrack); Wave && !Wave->IsStreaming())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Music %s isn't streamed, the whole track is in memory."), *Wave->GetName());
+	}
+#endif
+
+	if (!NextTrack)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Music track %d failed to load."), LastTrackIndex);
+		bPlayNextTrackWhenLoaded = false;
+		return;
+	}
+
+	if (bPlayNextTrackWhenLoaded)
+	{
+		bPlayNextTrackWhenLoaded = false;
+		PlayNextTrack();
+	}
+}
+
+UAudioComponent* AOMRTimeTrialGameMode::CreateMusicComponent()
+{
+	UAudioComponent* Component = NewObject<UAudioComponent>(this);
+	Component->bAutoActivate = false;
+	Component->bAutoDestroy = false;
+	Component->bAllowSpatialization = false;
+	Component->bIsUISound = true;
+	Component->RegisterComponent();
+
+	Component->OnAudioFinishedNative.AddUObject(this, &AOMRTimeTrialGameMode::HandleMusicFinished);
+
+	return Component;
+}
+
+void AOMRTimeTrialGameMode::HandleMusicFinished(UAudioComponent* Component)
+{
+	// Faded out, let its track unload. The current one ending early is left for the timer
+	if (Component != GetCurrentMusicComponent())
+	{
+		Component->SetSound(nullptr);
+	}
+}
+
 void AOMRTimeTrialGameMode::PlayNextTrack()
 {
-	int32 Index = GetRandomTrackIndex();
-	if (Index < 0) return;
+	if (!NextTrack)
+	{
+		// Still loading, played from HandleNextTrackLoaded
+		bPlayNextTrackWhenLoaded = true;
+		PrefetchNextTrack();
+		return;
+	}
 
-	USoundBase* NewTrack = LevelMusicTracks[Index];
-	if (!NewTrack) return;
+	for (TObjectPtr<UAudioComponent>& Component : MusicComponents)
+	{
+		if (!Component)
+		{
+			Component = CreateMusicComponent();
+		}
+	}
+
+	UAudioComponent* Previous = GetCurrentMusicComponent();
+	const bool bCrossfade = Previous->IsPlaying();
 
-	const float CrossfadeDuration = 10.0f;
+	CurrentMusicComponent ^= 1;
 
-	UAudioComponent* NewComponent = UGameplayStatics::SpawnSound2D(this, NewTrack, 1.f, 1.f, 0.f, nullptr, false);
+	UAudioComponent* Current = GetCurrentMusicComponent();
+	Current->SetSound(NextTrack);
 
-	if (!NewComponent) return;
+	USoundBase* Track = NextTrack;
+	NextTrack = nullptr;
 
 	// first track
-	if (!CurrentMusicComponent)
+	if (!bCrossfade)
 	{
-		NewComponent->SetVolumeMultiplier(1.0f);
+		Current->SetVolumeMultiplier(1.0f);
+		Current->Play(0.f);
 	}
 	else
 	{
-		NewComponent->FadeIn(CrossfadeDuration, 1.0f);
-		CurrentMusicComponent->FadeOut(CrossfadeDuration, 0.f); // 2 second fade out
+		Current->SetVolumeMultiplier(1.0f);
+		Current->FadeIn(CrossfadeDuration, 1.0f);
+		Previous->FadeOut(CrossfadeDuration, 0.f);
 	}
 
-	CurrentMusicComponent = NewComponent;
+	ScheduleNextTrack(Track);
+}
 
-	const float TrackDuration = NewTrack->GetDuration();
+void AOMRTimeTrialGameMode::ScheduleNextTrack(const USoundBase* Track)
+{
+	const float TrackDuration = Track->GetDuration();
 
 	if (TrackDuration > CrossfadeDuration)
 	{
@@ -75,6 +205,23 @@ void AOMRTimeTrialGameMode::PlayNextTrack()
 			TimeUntilNextFade,
 			false
 		);
+
+		// Loaded well before it's needed, never at the crossfade
+		const float TimeUntilPrefetch = TimeUntilNextFade - PrefetchLeadTime;
+
+		if (TimeUntilPrefetch > 0.f)
+		{
+			GetWorld()->GetTimerManager().SetTimer(
+				PrefetchTimerHandle,
+				this,
+				&AOMRTimeTrialGameMode::PrefetchNextTrack,
+				TimeUntilPrefetch,
+				false
+			);
+		}
+		else
+		{
+			PrefetchNextTrack();
+		}
 	}
 }
-
@@ -24,18 +24,43 @@ public:
 	UFUNCTION()
 	int32 GetRandomTrackIndex();
 
+	// Crossfades to the prefetched track, or plays it as soon as it has loaded
 	UFUNCTION()
 	void PlayNextTrack();
 
+	// Soft, only the playing track and the one after it are ever loaded. Music should be set
+	// to stream so each of those is only a few seconds of audio in memory
 	UPROPERTY(EditAnywhere, Category = "Audio")
-	TArray<USoundBase*> LevelMusicTracks;
+	TArray<TSoftObjectPtr<USoundBase>> LevelMusicTracks;
 
-	UPROPERTY()
-	UAudioComponent* CurrentMusicComponent;
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	float CrossfadeDuration = 10.f;
+
+	// How long before the crossfade the next track starts loading
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	float PrefetchLeadTime = 30.f;
+
+	// Playing, or fading in, of the two components below
+	UAudioComponent* GetCurrentMusicComponent() const { return MusicComponents[CurrentMusicComponent]; }
 
 	int32 LastTrackIndex = -1;
 
 	FTimerHandle MusicTimerHandle;
+	FTimerHandle PrefetchTimerHandle;
+
+	// Restarting the race restarts the current track from the top instead of playing on
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	bool bRestartMusicWithRace = false;
+
+	void HandleRaceEvents(TConstArrayView<struct FOMRRaceEvent> Events);
+
+	UFUNCTION()
+	void HandleRaceRestarted();
+
+	void ScheduleNextTrack(const USoundBase* Track);
+
+	// Picks the next track and starts loading it
+	void PrefetchNextTrack();
 
 protected:
 	virtual void BeginPlay() override;
@@ -43,5 +68,24 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "UI")
 	TSubclassOf<UUserWidget> TimeTrialHUDClass;
 
+private:
+	UAudioComponent* CreateMusicComponent();
+	void HandleNextTrackLoaded();
+	void HandleMusicFinished(UAudioComponent* Component);
+
+	// Ping-pong, the idle one takes the next track
+	UPROPERTY(Transient)
+	TObjectPtr<UAudioComponent> MusicComponents[2];
+
+	int32 CurrentMusicComponent = 0;
+
+	UPROPERTY(Transient)
+	TObjectPtr<USoundBase> NextTrack;
+
+	TSharedPtr<struct FStreamableHandle> NextTrackHandle;
+
+	// PlayNextTrack ran before the load finished
+	bool bPlayNextTrackWhenLoaded = false;
+
 
 };
@@ -3,108 +3,619 @@
 
 #include "OMRTimeTrialGameState.h"
 #include "Kismet/GameplayStatics.h"
+#include "EngineUtils.h"
+#include "GameFramework/WorldSettings.h"
 #include "../Track/OMRCheckpoint.h"
+#include "../Track/OMRStartFinishGate.h"
+#include "../Track/OMRCheckpointRegistry.h"
+#include "../Track/OMRTrackData.h"
+#include "../Track/OMRTrackProgress.h"
+#include "../Player/OMRPlayerPawn.h"
+#include "../Player/OMRPlayerController.h"
+#include "OMRGhostFile.h"
+#include "../OneMoreRun.h"
+#include "HAL/FileManager.h"
+#include "ProfilingDebugging/MiscTrace.h"
+
+DECLARE_CYCLE_STAT(TEXT("GameState UpdateLapTimer"), STAT_OMR_UpdateLapTimer, STATGROUP_OMR);
 
 AOMRTimeTrialGameState::AOMRTimeTrialGameState()
 {
+	// Lap timer runs as a decimated task, the actor tick itself has nothing to do
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 void AOMRTimeTrialGameState::BeginPlay()
 {
 	Super::BeginPlay();
 
-	CacheCheckpoints();
+	ConfiguredTotalCheckpoints = TotalCheckpoints;
+
+	// Whatever registered before us, the rest arrives through OnChanged
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		CheckpointRegistryHandle = Registry->OnChanged.AddUObject(this, &AOMRTimeTrialGameState::OnCheckpointRegistryChanged);
+		OnCheckpointRegistryChanged();
+	}
+
+	{
+		LLM_SCOPE_BYTAG(OMR_Ghosts);
+		GhostRecorder.Init(GhostHistoryLaps, GhostMaxLapDuration);
+
+		if (bRecordSession && !IsRunningCommandlet())
+		{
+			SessionReplay.Init(SessionReplayDuration);
+			SessionStartTime = GetWorld()->GetTimeSeconds();
+		}
+	}
+}
+
+void AOMRTimeTrialGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		Registry->OnChanged.Remove(CheckpointRegistryHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AOMRTimeTrialGameState::Tick(float DeltaTime)
+void AOMRTimeTrialGameState::RegisterActorTickFunctions(bool bRegister)
 {
-	Super::Tick(DeltaTime);
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (!TickScheduler.HasTasks())
+		{
+			// After physics, when the pawn holds every step of this frame's path
+			TickScheduler.AddTask(
+				TEXT("OMRTimingLines"),
+				TG_PostPhysics,
+				[this](float DeltaTime) { UpdateTimingLines(); }
+			);
+
+			// After the timing lines, a checkpoint crossed on the way out still counts
+			TickScheduler.AddTask(
+				TEXT("OMRTrackBounds"),
+				TG_PostPhysics,
+				[this](float DeltaTime) { UpdateTrackBounds(); }
+			);
+
+			TickScheduler.AddTask(
+				TEXT("OMRLapProgress"),
+				TG_PostPhysics,
+				[this](float DeltaTime) { UpdateLapProgress(); }
+			);
 
-	UpdateLapTimer(DeltaTime);
+			TickScheduler.AddTask(
+				TEXT("OMRLapTimer"),
+				TG_PostPhysics,
+				[this](float DeltaTime) { UpdateLapTimer(DeltaTime); },
+				1,
+				LapTimerUpdateRate
+			);
 
+			// Every frame, the recorder resamples to its own fixed rate
+			TickScheduler.AddTask(
+				TEXT("OMRGhostRecord"),
+				TG_PostPhysics,
+				[this](float DeltaTime) { RecordGhostFrame(DeltaTime); }
+			);
+
+			// Records at its own frame rate, or drives the pawn while watching
+			TickScheduler.AddTask(
+				TEXT("OMRSessionReplay"),
+				TG_PostPhysics,
+				[this](float DeltaTime)
+				{
+					if (bPlayingSession)
+					{
+						UpdateSessionPlayback(DeltaTime);
+					}
+					else
+					{
+						RecordSessionFrame();
+					}
+				}
+			);
+
+			// Last, everything posted this frame goes out as one batch
+			TickScheduler.AddTask(
+				TEXT("OMRRaceEvents"),
+				TG_PostUpdateWork,
+				[this](float DeltaTime) { RaceEvents.Flush(); },
+				1,
+				0.f,
+				true
+			);
+		}
+
+		TickScheduler.Register(this);
+	}
+	else
+	{
+		TickScheduler.Unregister();
+	}
 }
 
-void AOMRTimeTrialGameState::StartLap()
+void AOMRTimeTrialGameState::StartLap(double StartTime)
 {
 	if (bLapActive)	return;
+
+	if (!bLoadedSavedBest && ShouldPersistLaps())
+	{
+		LoadSavedBest();
+	}
 	
 	bLapActive = true;
+	bCurrentLapRewound = false;
 	CurrentLap++;
-	LapStartTime = GetWorld()->GetTimeSeconds();
+	LapStartTime = (float)StartTime;
+	LapStartRaceTime = StartTime;
+
+	GhostRecorder.BeginLap();
+	RecordGhostFrame(0.f);
+
+	LapProgress.Reset();
+	LapProgressDistance = 0.f;
+
+	CaptureRespawnSnapshot(INDEX_NONE);
+
+	// The saved input log of this lap replays from here
+	if (bHasRespawnSnapshot)
+	{
+		if (AOMRPlayerPawn* Pawn = GetGhostSource())
+		{
+			Pawn->BeginLapInputLog(RespawnSnapshot);
+		}
+	}
+
+	AddReplayEvent(EOMRReplayEvent::LapStart, CurrentLap, (float)(StartTime - SessionStartTime));
+	PostRaceEvent(FOMRRaceEvent::MakeLapStart(CurrentLap));
 
 	// 🔥 Broadcast lap number change
 	OnLapNumberUpdated.Broadcast(CurrentLap);
+	INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+	TRACE_BOOKMARK(TEXT("OMR Lap %d Start"), CurrentLap);
 
 	UE_LOG(LogTemp, Warning, TEXT("Lap %d Started"), CurrentLap);
 }
 
-void AOMRTimeTrialGameState::CompleteLap()
+void AOMRTimeTrialGameState::RestartRace()
+{
+	LLM_SCOPE_BYTAG(OMR_Gameplay);
+
+	// Stopping playback restarts the race itself
+	if (bPlayingSession)
+	{
+		StopSessionPlayback();
+		return;
+	}
+
+	AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (Pawn && Pawn->IsReplayingInput()) return;
+
+	TRACE_BOOKMARK(TEXT("OMR Race Restart"));
+
+	// -------------------------------------------------
+	// 1. Lap and split state as before the first gate crossing
+	// -------------------------------------------------
+	GhostRecorder.AbortLap();
+
+	bLapActive = false;
+	bCurrentLapRewound = false;
+	bRewoundSinceRestart = false;
+	CurrentLap = 0;
+	CurrentLapTime = 0.f;
+	LapStartTime = 0.f;
+	LapStartRaceTime = 0.0;
+	LastGateCrossTime = -1.f;
+	GateBackwardCrossings = 0;
+	LapTimeBroadcastAccumulator = 0.f;
+	LastBroadcastLapTime = 0.f;
+
+	LastLapSplitTimes.Reset();
+	LastCheckpointTransform = FTransform::Identity;
+	bHasRespawnSnapshot = false;
+	RespawnCheckpointIndex = INDEX_NONE;
+
+	bHasLiveDelta = false;
+	LiveDelta = 0.f;
+	PredictedLapTime = 0.f;
+	LapProgress.Reset();
+	LapProgressDistance = 0.f;
+
+	ResetCheckpoints();
+
+	// -------------------------------------------------
+	// 2. Pawn back on the spawn with the countdown running
+	// -------------------------------------------------
+	if (Pawn)
+	{
+		Pawn->RestartRace();
+	}
+
+	// -------------------------------------------------
+	// 3. HUD and music
+	// -------------------------------------------------
+	OnLapNumberUpdated.Broadcast(CurrentLap);
+	OnLapTimeUpdated.Broadcast(0.f);
+	OnRaceRestarted.Broadcast();
+	INC_DWORD_STAT_BY(STAT_OMR_Broadcasts, 3);
+
+	AddReplayEvent(EOMRReplayEvent::Restart);
+	PostRaceEvent(FOMRRaceEvent::MakeReset());
+
+	UE_LOG(LogTemp, Log, TEXT("Race restarted."));
+}
+
+void AOMRTimeTrialGameState::CaptureLapClock(FOMRLapClock& OutClock) const
+{
+	OutClock.Lap = CurrentLap;
+	OutClock.bLapActive = bLapActive;
+	OutClock.CheckpointIndex = CurrentCheckpointIndex;
+	OutClock.LapTime = bLapActive ? (float)(GetWorld()->GetTimeSeconds() - LapStartRaceTime) : 0.f;
+	OutClock.ProgressDistance = LapProgress.Distance;
+	OutClock.GateBackwardCrossings = GateBackwardCrossings;
+}
+
+bool AOMRTimeTrialGameState::RestoreLapClock(const FOMRLapClock& Clock)
+{
+	if (Clock.Lap != CurrentLap || Clock.bLapActive != bLapActive) return false;
+
+	bRewoundSinceRestart = true;
+
+	if (!bLapActive) return true;
+
+	bCurrentLapRewound = true;
+
+	LapStartRaceTime = GetWorld()->GetTimeSeconds() - Clock.LapTime;
+	LapStartTime = (float)LapStartRaceTime;
+
+	LapProgress.Distance = Clock.ProgressDistance;
+	LapProgressDistance = Clock.ProgressDistance;
+
+	GateBackwardCrossings = Clock.GateBackwardCrossings;
+
+	// Checkpoints cleared after the snapshot have to be cleared again
+	if (Clock.CheckpointIndex < CurrentCheckpointIndex)
+	{
+		SplitTimes.SetNum(FMath::Min(Clock.CheckpointIndex, SplitTimes.Num()), EAllowShrinking::No);
+
+		if (const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+		{
+			for (int32 Index = Clock.CheckpointIndex; Index < CurrentCheckpointIndex; ++Index)
+			{
+				if (AOMRCheckpoint* CP = Registry->GetCheckpoint(Index))
+				{
+					CP->ResetCheckpoint();
+				}
+			}
+		}
+
+		CurrentCheckpointIndex = Clock.CheckpointIndex;
+	}
+
+	AddReplayEvent(EOMRReplayEvent::LapClock, CurrentCheckpointIndex, (float)(LapStartRaceTime - SessionStartTime));
+
+	return true;
+}
+
+void AOMRTimeTrialGameState::StartReplayedLap(const FOMRLapClock& Clock)
+{
+	// StartLap counts the lap up
+	bLapActive = false;
+	CurrentLap = Clock.Lap - 1;
+
+	ResetCheckpoints();
+	StartLap(GetWorld()->GetTimeSeconds() - Clock.LapTime);
+
+	LastGateCrossTime = LapStartTime;
+	GateBackwardCrossings = Clock.GateBackwardCrossings;
+
+	LapProgress.Distance = Clock.ProgressDistance;
+	LapProgressDistance = Clock.ProgressDistance;
+}
+
+void AOMRTimeTrialGameState::CompleteLap(double FinishTime)
 {
 	if (!bLapActive) return;
 
-	float Now = GetWorld()->GetTimeSeconds();
-	CurrentLapTime = Now - LapStartTime;
+	CurrentLapTime = (float)(FinishTime - LapStartRaceTime);
 
 	// 🔥 Broadcast final lap time
 	OnLapTimeUpdated.Broadcast(CurrentLapTime);
+	INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+	TRACE_BOOKMARK(TEXT("OMR Lap %d Complete %.3f"), CurrentLap, CurrentLapTime);
 
 	bool bNewBest = false;
 
-	if (BestLapTime < 0.f || CurrentLapTime < BestLapTime)
+	if (bCurrentLapRewound)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Lap %d was rewound, not eligible for best."), CurrentLap);
+	}
+	else if (BestLapTime < 0.f || CurrentLapTime < BestLapTime)
 	{
 		BestLapTime = CurrentLapTime;
 		bNewBest = true;
 	}
 
+	AddReplayEvent(EOMRReplayEvent::LapComplete, CurrentLap, CurrentLapTime, 0.f, bNewBest ? 1 : 0);
+	PostRaceEvent(FOMRRaceEvent::MakeLapComplete(CurrentLap, CurrentLapTime, bNewBest));
+
+	// Last sample lands exactly on the lap time
+	RecordGhostFrame(0.f);
+	GhostRecorder.EndLap(CurrentLapTime, bNewBest);
+
 	bLapActive = false;
 
+	LastLapSplitTimes.Reset();
+	LastLapSplitTimes.Append(SplitTimes);
+
 	UE_LOG(LogTemp, Warning, TEXT("Lap %d Complete - Time: %.2f | Best: %.2f"), CurrentLap, CurrentLapTime, BestLapTime);
 
 	if (bNewBest)
 	{
-		BestSplitTimes = SplitTimes;
+		// Both arrays are reserved for the whole lap, this never reallocates
+		BestSplitTimes.Reset();
+		BestSplitTimes.Append(SplitTimes);
 		UE_LOG(LogTemp, Warning, TEXT("New Best Lap!"));
 		OnBestTimeUpdated.Broadcast(BestLapTime);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+		BuildBestProgressCurve();
+		SaveBestGhost();
 	}
 
+	SaveLapGhost();
+	SaveLapInputLog();
+
 }
 
 void AOMRTimeTrialGameState::UpdateLapTimer(float DeltaTime)
 {
-	if (!bLapActive) return;
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateLapTimer);
+	LLM_SCOPE_BYTAG(OMR_Gameplay);
+
+	if (!bLapActive || (!OnLapTimeUpdated.IsBound() && !OnLiveDeltaUpdated.IsBound())) return;
 
 	const float CurrentTime = GetWorld()->GetTimeSeconds() - LapStartTime;
 
+	const float BroadcastInterval = 1.f / FMath::Max(LapTimerUpdateRate, 1.f);
+
 	LapTimeBroadcastAccumulator += DeltaTime;
 
-	if (LapTimeBroadcastAccumulator >= 0.05f)
+	if (LapTimeBroadcastAccumulator >= BroadcastInterval)
 	{
-		LapTimeBroadcastAccumulator -= 0.05f;
+		LapTimeBroadcastAccumulator = FMath::Fmod(LapTimeBroadcastAccumulator, BroadcastInterval);
 		LastBroadcastLapTime = CurrentTime;
 
 		OnLapTimeUpdated.Broadcast(CurrentTime);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+		if (bHasLiveDelta)
+		{
+			OnLiveDeltaUpdated.Broadcast(LiveDelta, PredictedLapTime);
+			INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		}
+	}
+}
+
+void AOMRTimeTrialGameState::RecordGhostFrame(float DeltaTime)
+{
+	if (!bLapActive || !GhostRecorder.IsRecording()) return;
+
+	FOMRGhostSample Sample;
+	if (GetGhostSample(Sample))
+	{
+		GhostRecorder.Record(GetWorld()->GetTimeSeconds() - LapStartTime, Sample);
+	}
+}
+
+AOMRPlayerPawn* AOMRTimeTrialGameState::GetGhostSource()
+{
+	if (!GhostSource.IsValid())
+	{
+		GhostSource = Cast<AOMRPlayerPawn>(UGameplayStatics::GetPlayerPawn(this, 0));
+	}
+
+	// Validation worlds have no player, the replayed pawn is unpossessed
+	if (!GhostSource.IsValid())
+	{
+		TActorIterator<AOMRPlayerPawn> It(GetWorld());
+		GhostSource = It ? *It : nullptr;
+	}
+
+	return GhostSource.Get();
+}
+
+bool AOMRTimeTrialGameState::GetGhostSample(FOMRGhostSample& OutSample)
+{
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return false;
+
+	const FTransform Transform = Pawn->GetBallTransform();
+
+	OutSample.Location = Transform.GetLocation();
+	OutSample.Rotation = Transform.GetRotation();
+	OutSample.Velocity = Pawn->GetBallVelocity();
+	OutSample.bGrounded = Pawn->IsBallGrounded();
+
+	return true;
+}
+
+FString AOMRTimeTrialGameState::GetTrackName() const
+{
+	return UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+}
+
+void AOMRTimeTrialGameState::LoadSavedBest()
+{
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
+
+	bLoadedSavedBest = true;
+
+	const FString TrackName = GetTrackName();
+
+	FOMRGhostFile File;
+	if (!File.Open(FOMRGhostFile::GetBestGhostPath(TrackName))) return;
+
+	const FOMRGhostFile::FHeader& Header = File.GetHeader();
+
+	// A ghost from another track layout or other handling can't be raced fairly
+	if (Header.TrackId != FOMRGhostFile::MakeTrackId(TrackName) || Header.TuningHash != Pawn->GetTuningHash())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Saved best ghost for %s was recorded with different tuning, ignoring it."), *TrackName);
+		return;
+	}
+
+	if (BestLapTime >= 0.f && BestLapTime <= Header.LapTime) return;
+
+	if (!File.DecodeAll(GhostRecorder.GetBestGhostForLoading())) return;
+
+	BestLapTime = Header.LapTime;
+
+	BestSplitTimes.Reset();
+	BestSplitTimes.Append(File.GetSplitTimes().GetData(), File.GetSplitTimes().Num());
+
+	BuildBestProgressCurve();
+
+	// Keyframes from here on carry it, so playback shows the same best
+	AddReplayEvent(EOMRReplayEvent::BestLoaded, 0, BestLapTime);
+
+	OnBestTimeUpdated.Broadcast(BestLapTime);
+	INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+	UE_LOG(LogTemp, Log, TEXT("Loaded best ghost for %s: %.2f"), *TrackName, BestLapTime);
+}
+
+void AOMRTimeTrialGameState::SaveBestGhost()
+{
+	const FOMRGhostTrack& Ghost = GhostRecorder.GetBestGhost();
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+
+	// A truncated ghost would stop short of the line
+	if (!Pawn || !ShouldPersistLaps() || Ghost.Num() == 0 || Ghost.IsTruncated()) return;
+
+	const FString TrackName = GetTrackName();
+
+	if (!FOMRGhostFile::Write(
+		FOMRGhostFile::GetBestGhostPath(TrackName),
+		Ghost,
+		FOMRGhostFile::MakeTrackId(TrackName),
+		Pawn->GetTuningHash(),
+		BestSplitTimes))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to save best ghost for %s."), *TrackName);
+	}
+}
+
+void AOMRTimeTrialGameState::SaveLapGhost()
+{
+	const FOMRGhostTrack* Ghost = GhostRecorder.GetLap(0);
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+
+	// A rewound lap's time isn't one the player drove. The lap time tells this lap from an
+	// older one when the recorder wasn't recording
+	if (SavedLapGhosts <= 0 || bCurrentLapRewound || !Ghost || Ghost->LapTime != CurrentLapTime) return;
+	if (!Pawn || !ShouldPersistLaps() || Ghost->Num() == 0 || Ghost->IsTruncated()) return;
+
+	const FString TrackName = GetTrackName();
+	const uint32 TrackId = FOMRGhostFile::MakeTrackId(TrackName);
+
+	if (!FOMRGhostFile::Write(
+		FOMRGhostFile::GetLapGhostPath(TrackName, FDateTime::UtcNow().GetTicks()),
+		*Ghost,
+		TrackId,
+		Pawn->GetTuningHash(),
+		LastLapSplitTimes))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to save lap ghost for %s."), *TrackName);
+		return;
+	}
+
+	// Keep the fastest SavedLapGhosts laps of this track, headers only
+	TArray<FOMRGhostFile::FDirectoryEntry> Entries;
+	FOMRGhostFile::ScanDirectory(FOMRGhostFile::GetGhostDirectory(), Entries);
+
+	Entries.RemoveAll([&TrackName, TrackId](const FOMRGhostFile::FDirectoryEntry& Entry)
+	{
+		return Entry.Header.TrackId != TrackId || !FOMRGhostFile::IsLapGhostPath(Entry.Filename, TrackName);
+	});
+
+	if (Entries.Num() <= SavedLapGhosts) return;
+
+	Entries.Sort([](const FOMRGhostFile::FDirectoryEntry& A, const FOMRGhostFile::FDirectoryEntry& B)
+	{
+		return A.Header.LapTime < B.Header.LapTime;
+	});
+
+	for (int32 Index = SavedLapGhosts; Index < Entries.Num(); ++Index)
+	{
+		IFileManager::Get().Delete(*Entries[Index].Filename, false, false, true);
+	}
+}
+
+void AOMRTimeTrialGameState::SaveLapInputLog()
+{
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	// Rewinds aren't in the log, it would no longer replay
+	if (!bSaveLapInputLogs || !Pawn || !ShouldPersistLaps() || bRewoundSinceRestart) return;
+
+	if (Pawn->GetInputLog().IsTruncated())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Lap %d ran past %d input log frames, not saved."), CurrentLap, Pawn->GetInputLog().Num());
+		return;
+	}
+
+	const FString TrackName = GetTrackName();
+	const FString Filename = FOMRInputLog::GetLogDirectory() /
+		FString::Printf(TEXT("%s_Lap%d_%lld.omrinput"), *TrackName, CurrentLap, FDateTime::UtcNow().GetTicks());
+
+	if (!Pawn->GetInputLog().Save(
+		Filename,
+		FOMRGhostFile::MakeTrackId(TrackName),
+		Pawn->GetTuningHash(),
+		CurrentLap,
+		CurrentLapTime,
+		LastLapSplitTimes))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to save input log %s."), *Filename);
 	}
 }
 
+bool AOMRTimeTrialGameState::ShouldPersistLaps()
+{
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	return Pawn && !Pawn->IsReplayingInput() && !IsRunningCommandlet();
+}
+
 void AOMRTimeTrialGameState::HandleStartFinishCross()
 {
 	if (!GetWorld()) return;
 
-	const float Now = GetWorld()->GetTimeSeconds();
+	HandleStartFinishCrossing(GetWorld()->GetTimeSeconds());
+}
 
-	// Cooldown Protection
-	if (Now - LastGateCrossTime < GateCooldown)
+void AOMRTimeTrialGameState::HandleStartFinishCrossing(double CrossTime)
+{
+	// Cooldown Protection, a lap can't be shorter than this either
+	if (LastGateCrossTime >= 0.f && CrossTime - LastGateCrossTime < GateCooldown)
 	{
 		return;
 	}
-	
-	LastGateCrossTime = Now;
+
+	LastGateCrossTime = (float)CrossTime;
 
 	if(!bLapActive)
 	{
 		ResetCheckpoints();
-		StartLap();
+		StartLap(CrossTime);
 		return;
 	}
 	
@@ -119,9 +630,10 @@ void AOMRTimeTrialGameState::HandleStartFinishCross()
 
 	if (bCanFinish)
 	{
-		CompleteLap();
+		// One crossing ends this lap and starts the next at the same instant
+		CompleteLap(CrossTime);
 		ResetCheckpoints();
-		StartLap();
+		StartLap(CrossTime);
 	}
 	else
 	{
@@ -134,6 +646,11 @@ float AOMRTimeTrialGameState::GetDisplayedLaptime() const
 {
 	if (!GetWorld()) return CurrentLapTime;
 
+	if (bPlayingSession)
+	{
+		return PlaybackRaceState.GetLapTime(SessionPlaybackTime);
+	}
+
 	if (bLapActive)
 	{
 		return GetWorld()->GetTimeSeconds() - LapStartTime;
@@ -143,6 +660,13 @@ float AOMRTimeTrialGameState::GetDisplayedLaptime() const
 }
 
 void AOMRTimeTrialGameState::RegisterCheckpointHit(int32 CheckpointIndex, const FTransform& CheckpointTransform)
+{
+	if (!GetWorld()) return;
+
+	RegisterCheckpointCrossing(CheckpointIndex, CheckpointTransform, GetWorld()->GetTimeSeconds());
+}
+
+void AOMRTimeTrialGameState::RegisterCheckpointCrossing(int32 CheckpointIndex, const FTransform& CheckpointTransform, double CrossTime)
 {
 	if (!bLapActive) return;
 
@@ -158,8 +682,7 @@ void AOMRTimeTrialGameState::RegisterCheckpointHit(int32 CheckpointIndex, const
 		return;
 	}
 
-	const float Now = GetWorld()->GetTimeSeconds();
-	const float SplitTime = Now - LapStartTime;
+	const float SplitTime = (float)(CrossTime - LapStartRaceTime);
 
 	SplitTimes.Add(SplitTime);
 
@@ -177,47 +700,600 @@ void AOMRTimeTrialGameState::RegisterCheckpointHit(int32 CheckpointIndex, const
 	if (bHasReference)
 	{
 		OnSplitUpdated.Broadcast(SplitTime, SplitDelta, bIsAhead);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+	}
+
+	TRACE_BOOKMARK(TEXT("OMR Lap %d Checkpoint %d %.3f"), CurrentLap, CheckpointIndex, SplitTime);
+
+	AddReplayEvent(EOMRReplayEvent::Split, CheckpointIndex, SplitTime, SplitDelta, bHasReference ? 1 : 0);
+	PostRaceEvent(FOMRRaceEvent::MakeCheckpoint(CheckpointIndex, SplitTime));
+
+	if (bHasReference)
+	{
+		PostRaceEvent(FOMRRaceEvent::MakeSplit(CheckpointIndex, SplitTime, SplitDelta));
 	}
 
-	// Save respawn transform
 	LastCheckpointTransform = CheckpointTransform;
 
 	UE_LOG(LogTemp, Warning, TEXT("Checkpoint %d Hit | Split: %.2f"), CheckpointIndex, SplitTime);
 
 	CurrentCheckpointIndex++;
+
+	// After the index moved on, respawning here must not ask for this checkpoint again
+	CaptureRespawnSnapshot(CheckpointIndex);
 }
 
 void AOMRTimeTrialGameState::ResetCheckpoints()
 {
 	CurrentCheckpointIndex = 0;
-	SplitTimes.Empty();
+	SplitTimes.Reset();
 
-	for (AOMRCheckpoint* CP : CachedCheckpoints)
+	if (const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
 	{
-		if (IsValid(CP))
+		Registry->ForEachCheckpoint([](AOMRCheckpoint* CP) { CP->ResetCheckpoint(); });
+	}
+}
+
+void AOMRTimeTrialGameState::OnCheckpointRegistryChanged()
+{
+	LLM_SCOPE_BYTAG(OMR_Gameplay);
+
+	const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>();
+	if (!Registry) return;
+
+	TotalCheckpoints = FMath::Max(ConfiguredTotalCheckpoints, Registry->NumCheckpoints());
+
+	if (const UOMRTrackData* TrackData = Registry->GetTrackData())
+	{
+		TotalCheckpoints = FMath::Max(TotalCheckpoints, TrackData->Checkpoints.Num());
+	}
+
+	// One split per checkpoint, sized up front so lap events don't allocate
+	SplitTimes.Reserve(TotalCheckpoints);
+	BestSplitTimes.Reserve(TotalCheckpoints);
+	LastLapSplitTimes.Reserve(TotalCheckpoints);
+
+	bTrackLayoutDirty = true;
+}
+
+void AOMRTimeTrialGameState::BuildTimingLines()
+{
+	TimingLines.Reset();
+
+	const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>();
+	if (!bUseTimingLines || !Registry) return;
+
+	// Baked lines cover checkpoints that haven't streamed in yet
+	if (const UOMRTrackData* TrackData = Registry->GetTrackData())
+	{
+		for (int32 Index = 0; Index < TrackData->Checkpoints.Num(); ++Index)
+		{
+			const FOMRTrackLineData& Line = TrackData->Checkpoints[Index];
+			TimingLines.Add(Line.TriggerTransform, Line.Extent, Index, Line.bFlipCrossingDirection, Line.ActorTransform);
+		}
+
+		const FOMRTrackLineData& Gate = TrackData->Gate;
+		TimingLines.Add(Gate.TriggerTransform, Gate.Extent, INDEX_NONE, Gate.bFlipCrossingDirection, Gate.ActorTransform);
+		return;
+	}
+
+	Registry->ForEachCheckpoint([this](const AOMRCheckpoint* CP)
+	{
+		TimingLines.AddFromBox(CP->Trigger, CP->CheckpointIndex, CP->bFlipCrossingDirection);
+	});
+
+	for (const AOMRStartFinishGate* Gate : Registry->GetGates())
+	{
+		TimingLines.AddFromBox(Gate->GetTrigger(), INDEX_NONE, Gate->bFlipCrossingDirection);
+	}
+}
+
+void AOMRTimeTrialGameState::RefreshTrackLayout()
+{
+	if (!bTrackLayoutDirty) return;
+
+	bTrackLayoutDirty = false;
+
+	BuildTimingLines();
+	BuildTrackBounds();
+	BuildTrackProgress();
+}
+
+void AOMRTimeTrialGameState::UpdateTimingLines()
+{
+	RefreshTrackLayout();
+
+	if (TimingLines.Num() == 0) return;
+
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
+
+	const TConstArrayView<FOMRBallPathSample> Path = Pawn->GetBallPath();
+	if (Path.Num() < 2) return;
+
+	TArray<FOMRTimingCrossing, TInlineAllocator<4>> Crossings;
+	TimingLines.Test(Path, Pawn->GetBallRadius(), Crossings);
+
+	for (const FOMRTimingCrossing& Crossing : Crossings)
+	{
+		const FOMRTimingLine& Line = TimingLines.GetLine(Crossing.LineIndex);
+
+		// Driving back over a line neither starts, finishes nor splits. Backing over the gate
+		// puts the ball behind it again, so the next forward crossing only undoes it
+		if (!Crossing.bForward)
+		{
+			if (Line.CheckpointIndex == INDEX_NONE && bLapActive)
+			{
+				++GateBackwardCrossings;
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("Timing line %d crossed backwards."), Line.CheckpointIndex);
+			continue;
+		}
+
+		if (Line.CheckpointIndex == INDEX_NONE)
+		{
+			if (bLapActive && GateBackwardCrossings > 0)
+			{
+				--GateBackwardCrossings;
+				continue;
+			}
+
+			HandleStartFinishCrossing(Crossing.Time);
+		}
+		else
+		{
+			RegisterCheckpointCrossing(Line.CheckpointIndex, Line.Transform, Crossing.Time);
+		}
+	}
+}
+
+void AOMRTimeTrialGameState::BuildTrackBounds()
+{
+	TrackBounds.Reset();
+
+	const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>();
+
+	if (const UOMRTrackData* TrackData = Registry ? Registry->GetTrackData() : nullptr)
+	{
+		TrackBounds.SetKillZ(TrackData->KillZ);
+
+		for (const FBox& Volume : TrackData->PlayBounds)
+		{
+			TrackBounds.AddVolume(Volume);
+		}
+	}
+	else if (const AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings(); WorldSettings && WorldSettings->bEnableWorldBoundsChecks)
+	{
+		// Uncompiled map, only the world's own kill plane
+		TrackBounds.SetKillZ(WorldSettings->KillZ);
+	}
+}
+
+void AOMRTimeTrialGameState::UpdateTrackBounds()
+{
+	RefreshTrackLayout();
+
+	if (!bEnableOutOfBoundsRespawn || !TrackBounds.IsValid()) return;
+
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn || Pawn->IsRewinding() || Pawn->IsShowingReplay()) return;
+
+	// Every physics step, a fast fall can't skip past the kill plane between frames
+	for (const FOMRBallPathSample& Sample : Pawn->GetBallPath())
+	{
+		if (!TrackBounds.IsInside(Sample.Position))
 		{
-			CP->ResetCheckpoint();
+			TRACE_BOOKMARK(TEXT("OMR Out Of Bounds"));
+			UE_LOG(LogTemp, Log, TEXT("Ball out of bounds at %s."), *Sample.Position.ToCompactString());
+
+			RespawnAtCheckpoint();
+			return;
 		}
 	}
 }
 
-void AOMRTimeTrialGameState::CacheCheckpoints()
+void AOMRTimeTrialGameState::CaptureRespawnSnapshot(int32 CheckpointIndex)
+{
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
+
+	Pawn->CaptureSnapshot(RespawnSnapshot);
+	CaptureLapClock(RespawnSnapshot.LapClock);
+
+	RespawnCheckpointIndex = CheckpointIndex;
+	bHasRespawnSnapshot = true;
+}
+
+void AOMRTimeTrialGameState::RespawnAtCheckpoint()
 {
-	CachedCheckpoints.Empty();
+	LLM_SCOPE_BYTAG(OMR_Gameplay);
 
-	TArray<AActor*> Found;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AOMRCheckpoint::StaticClass(), Found);
+	AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
 
-	for (AActor* A : Found)
+	// Nothing crossed yet this race, start it over
+	if (!bHasRespawnSnapshot || RespawnSnapshot.LapClock.Lap != CurrentLap)
 	{
-		if (AOMRCheckpoint* CP = Cast<AOMRCheckpoint>(A))
+		// A replay can't restart. A recorded lap never got here, so it has diverged, the ball
+		// goes back to the spawn so this doesn't fire again every frame
+		if (Pawn->IsReplayingInput())
 		{
-			CachedCheckpoints.Add(CP);
+			Pawn->MarkReplayDiverged();
+			Pawn->ResetRun();
+			return;
 		}
+
+		RestartRace();
+		return;
+	}
+
+	// Same snapshot every time, a respawn is a teleport and a few copies
+	Pawn->ApplySnapshot(RespawnSnapshot, RespawnSpeedScale);
+
+	// The ball is back on the snapshot's side of the gate
+	GateBackwardCrossings = RespawnSnapshot.LapClock.GateBackwardCrossings;
+
+	if (RespawnClockPolicy == EOMRRespawnClockPolicy::RestoreWithPenalty)
+	{
+		FOMRLapClock Clock = RespawnSnapshot.LapClock;
+		Clock.LapTime += FMath::Max(RespawnPenaltyTime, 0.f);
+		RestoreLapClock(Clock);
 	}
+	else
+	{
+		// Progress only ever moves forward, put it back to the checkpoint by hand
+		LapProgress.Distance = RespawnSnapshot.LapClock.ProgressDistance;
+		LapProgressDistance = LapProgress.Distance;
+	}
+
+	OnBallRespawned.Broadcast(RespawnCheckpointIndex);
+	INC_DWORD_STAT(STAT_OMR_Broadcasts);
 
-	TotalCheckpoints = CachedCheckpoints.Num();
+	AddReplayEvent(EOMRReplayEvent::Respawn, RespawnCheckpointIndex);
+	PostRaceEvent(FOMRRaceEvent::MakeRespawn(RespawnCheckpointIndex));
 
-	UE_LOG(LogTemp, Warning, TEXT("Cached %d checkpoints."), CachedCheckpoints.Num());
+	TRACE_BOOKMARK(TEXT("OMR Respawn %d"), RespawnCheckpointIndex);
 }
 
+void AOMRTimeTrialGameState::BuildTrackProgress()
+{
+	LLM_SCOPE_BYTAG(OMR_Track);
+
+	const UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>();
+	if (!Registry) return;
+
+	TArray<FVector> Points;
+
+	if (const UOMRTrackData* TrackData = Registry->GetTrackData(); TrackData && TrackData->Centerline.Num() >= 2)
+	{
+		Points.Reserve(TrackData->Centerline.Num());
+
+		for (const FVector3f& Point : TrackData->Centerline)
+		{
+			Points.Add(FVector(Point));
+		}
+	}
+	else if (Registry->GetGates().Num() > 0 && Registry->IsValidLayout())
+	{
+		// No baked centerline, straight lines gate -> checkpoints -> gate
+		Points.Add(Registry->GetGates()[0]->GetActorLocation());
+		Registry->ForEachCheckpoint([&Points](const AOMRCheckpoint* CP) { Points.Add(CP->GetActorLocation()); });
+	}
+
+	TrackProgress.Build(Points);
+
+	if (TrackProgress.IsValid())
+	{
+		BestProgressCurve.Init(TrackProgress.GetLength(), ProgressCurveStep);
+		BuildBestProgressCurve();
+
+		UE_LOG(LogTemp, Log, TEXT("Track progress: %.0f cm, %d points, %d KB."),
+			TrackProgress.GetLength(), Points.Num(), TrackProgress.GetAllocatedSize() / 1024);
+	}
+}
+
+void AOMRTimeTrialGameState::BuildBestProgressCurve()
+{
+	BestProgressCurve.Reset();
+
+	const FOMRGhostTrack& Ghost = GhostRecorder.GetBestGhost();
+	if (!TrackProgress.IsValid() || !GhostRecorder.HasBestGhost()) return;
+
+	FOMRLapProgressTracker Tracker;
+	FOMRGhostSample Sample;
+
+	for (int32 Index = 0; Index < Ghost.Num(); ++Index)
+	{
+		Ghost.GetSample(Index, Sample);
+
+		if (Tracker.Update(TrackProgress, Sample.Location))
+		{
+			BestProgressCurve.Advance(Tracker.Distance, Index / FOMRGhostTrack::SampleRate);
+		}
+	}
+}
+
+void AOMRTimeTrialGameState::UpdateLapProgress()
+{
+	RefreshTrackLayout();
+
+	bHasLiveDelta = false;
+
+	if (!bLapActive || !TrackProgress.IsValid()) return;
+
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
+
+	if (!LapProgress.Update(TrackProgress, Pawn->GetBallTransform().GetLocation())) return;
+
+	LapProgressDistance = LapProgress.Distance;
+
+	if (!BestProgressCurve.IsValid()) return;
+
+	const float LapTime = (float)(GetWorld()->GetTimeSeconds() - LapStartRaceTime);
+
+	LiveDelta = LapTime - BestProgressCurve.GetTimeAt(LapProgressDistance);
+	PredictedLapTime = BestLapTime + LiveDelta;
+	bHasLiveDelta = true;
+}
+
+float AOMRTimeTrialGameState::GetSessionTime() const
+{
+	return (float)(GetWorld()->GetTimeSeconds() - SessionStartTime);
+}
+
+void AOMRTimeTrialGameState::AddReplayEvent(EOMRReplayEvent Type, int32 Value, float A, float B, uint8 Flags)
+{
+	if (!SessionReplay.IsInitialized() || bPlayingSession) return;
+
+	FOMRReplayEvent Event;
+	Event.Time = GetSessionTime();
+	Event.Type = Type;
+	Event.Flags = Flags;
+	Event.Value = Value;
+	Event.A = A;
+	Event.B = B;
+
+	SessionRaceState.Apply(Event);
+	SessionReplay.AddEvent(Event);
+}
+
+void AOMRTimeTrialGameState::PostRaceEvent(FOMRRaceEvent Event)
+{
+	Event.WorldTime = GetWorld()->GetTimeSeconds();
+
+	if (Event.Type != EOMRRaceEvent::LapStart && Event.Type != EOMRRaceEvent::LapComplete)
+	{
+		Event.Lap = CurrentLap;
+	}
+
+	RaceEvents.Post(Event);
+}
+
+void AOMRTimeTrialGameState::RecordSessionFrame()
+{
+	if (!SessionReplay.IsInitialized()) return;
+
+	const AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn || Pawn->IsRewinding()) return;
+
+	LLM_SCOPE_BYTAG(OMR_Ghosts);
+
+	// A hitch holds the last frame for the ones it skipped
+	const float Time = GetSessionTime();
+	FOMRReplayFrame Frame;
+	Pawn->CaptureReplayFrame(Frame);
+
+	while (SessionReplay.WantsFrame(Time))
+	{
+		if (!SessionReplay.Record(Frame, SessionRaceState)) break;
+	}
+}
+
+void AOMRTimeTrialGameState::StartSessionPlayback(float Time)
+{
+	if (SessionReplay.Num() < 2) return;
+
+	AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn || Pawn->IsReplayingInput()) return;
+
+	if (!bPlayingSession)
+	{
+		// The lap in progress is abandoned, the race restarts when playback stops
+		GhostRecorder.AbortLap();
+		bLapActive = false;
+
+		Pawn->BeginReplayView();
+
+		bPlayingSession = true;
+		PlaybackStartWorldTime = GetWorld()->GetTimeSeconds();
+
+		TRACE_BOOKMARK(TEXT("OMR Session Playback"));
+	}
+
+	SeekSessionPlayback(Time);
+}
+
+void AOMRTimeTrialGameState::SeekSessionPlayback(float Time)
+{
+	if (!bPlayingSession) return;
+
+	SessionPlaybackTime = FMath::Clamp(Time, 0.f, SessionReplay.GetDuration());
+
+	// Keyframe race state plus the events since, then the HUD is told where it stands
+	SessionReplay.GetRaceState(SessionPlaybackTime, PlaybackRaceState);
+	ShowSessionFrame();
+
+	OnLapNumberUpdated.Broadcast(PlaybackRaceState.Lap);
+	OnLapTimeUpdated.Broadcast(PlaybackRaceState.GetLapTime(SessionPlaybackTime));
+	OnBestTimeUpdated.Broadcast(PlaybackRaceState.BestLapTime);
+	INC_DWORD_STAT_BY(STAT_OMR_Broadcasts, 3);
+
+	LapTimeBroadcastAccumulator = 0.f;
+}
+
+void AOMRTimeTrialGameState::StopSessionPlayback()
+{
+	if (!bPlayingSession) return;
+
+	bPlayingSession = false;
+
+	// Session time carries on from where recording left off
+	SessionStartTime += GetWorld()->GetTimeSeconds() - PlaybackStartWorldTime;
+
+	if (AOMRPlayerPawn* Pawn = GetGhostSource())
+	{
+		Pawn->EndReplayView();
+	}
+
+	OnBestTimeUpdated.Broadcast(BestLapTime);
+	INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+	RestartRace();
+}
+
+void AOMRTimeTrialGameState::UpdateSessionPlayback(float DeltaTime)
+{
+	const float PreviousTime = SessionPlaybackTime;
+	SessionPlaybackTime = FMath::Min(SessionPlaybackTime + DeltaTime, SessionReplay.GetDuration());
+
+	SessionReplay.ForEachEvent(PreviousTime, SessionPlaybackTime, [this](const FOMRReplayEvent& Event)
+	{
+		PlaybackRaceState.Apply(Event);
+		PlayReplayEvent(Event);
+	});
+
+	ShowSessionFrame();
+
+	// Same rate as the live timer
+	const float BroadcastInterval = 1.f / FMath::Max(LapTimerUpdateRate, 1.f);
+
+	LapTimeBroadcastAccumulator += DeltaTime;
+
+	if (PlaybackRaceState.bLapActive && LapTimeBroadcastAccumulator >= BroadcastInterval && OnLapTimeUpdated.IsBound())
+	{
+		LapTimeBroadcastAccumulator = FMath::Fmod(LapTimeBroadcastAccumulator, BroadcastInterval);
+
+		OnLapTimeUpdated.Broadcast(PlaybackRaceState.GetLapTime(SessionPlaybackTime));
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+	}
+}
+
+void AOMRTimeTrialGameState::ShowSessionFrame()
+{
+	AOMRPlayerPawn* Pawn = GetGhostSource();
+	if (!Pawn) return;
+
+	FOMRReplayFrame Frame;
+	if (SessionReplay.Evaluate(SessionPlaybackTime, Frame))
+	{
+		Pawn->ShowReplayFrame(Frame);
+	}
+}
+
+void AOMRTimeTrialGameState::PlayReplayEvent(const FOMRReplayEvent& Event)
+{
+	AOMRPlayerPawn* Pawn = GetGhostSource();
+	AOMRPlayerController* PC = Pawn ? Cast<AOMRPlayerController>(Pawn->GetController()) : nullptr;
+
+	switch (Event.Type)
+	{
+	case EOMRReplayEvent::Countdown:
+		if (PC) PC->OnCountdownChanged(Event.Value);
+		break;
+
+	case EOMRReplayEvent::CountdownGo:
+		if (PC) PC->OnCountdownGo();
+		break;
+
+	case EOMRReplayEvent::LapStart:
+		OnLapNumberUpdated.Broadcast(Event.Value);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		break;
+
+	case EOMRReplayEvent::LapComplete:
+		OnLapTimeUpdated.Broadcast(Event.A);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+
+		if (Event.Flags)
+		{
+			OnBestTimeUpdated.Broadcast(Event.A);
+			INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		}
+		break;
+
+	case EOMRReplayEvent::Split:
+		if (Event.Flags)
+		{
+			OnSplitUpdated.Broadcast(Event.A, Event.B, Event.B < 0.f);
+			INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		}
+		break;
+
+	case EOMRReplayEvent::Landing:
+		if (Pawn) Pawn->PlayLandingSound(Event.A, Event.B);
+		break;
+
+	case EOMRReplayEvent::Respawn:
+		OnBallRespawned.Broadcast(Event.Value);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		break;
+
+	case EOMRReplayEvent::BestLoaded:
+		OnBestTimeUpdated.Broadcast(Event.A);
+		INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		break;
+
+	case EOMRReplayEvent::Restart:
+		OnLapNumberUpdated.Broadcast(0);
+		OnLapTimeUpdated.Broadcast(0.f);
+		OnRaceRestarted.Broadcast();
+		INC_DWORD_STAT_BY(STAT_OMR_Broadcasts, 3);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRRaceRestartCommand(
+	TEXT("OMR.Race.Restart"),
+	TEXT("OMR.Race.Restart - restart the time trial from the countdown without reloading the level"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (AOMRTimeTrialGameState* GS = World ? World->GetGameState<AOMRTimeTrialGameState>() : nullptr)
+		{
+			GS->RestartRace();
+		}
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRReplayPlayCommand(
+	TEXT("OMR.Replay.Play"),
+	TEXT("OMR.Replay.Play [Seconds] - watch the session from Seconds in, seeks if already watching"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		AOMRTimeTrialGameState* GS = World ? World->GetGameState<AOMRTimeTrialGameState>() : nullptr;
+		if (!GS) return;
+
+		const float Time = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.f;
+
+		GS->StartSessionPlayback(Time);
+
+		UE_LOG(LogTemp, Log, TEXT("Session replay at %.1f / %.1f s, %d frames, %d KB."),
+			GS->SessionPlaybackTime, GS->GetSessionDuration(), GS->GetSessionReplay().Num(), GS->GetSessionReplay().GetAllocatedSize() / 1024);
+	})
+);
+
+static FAutoConsoleCommandWithWorldAndArgs GOMRReplayStopCommand(
+	TEXT("OMR.Replay.Stop"),
+	TEXT("OMR.Replay.Stop - stop watching the session and restart the race"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (AOMRTimeTrialGameState* GS = World ? World->GetGameState<AOMRTimeTrialGameState>() : nullptr)
+		{
+			GS->StopSessionPlayback();
+		}
+	})
+);
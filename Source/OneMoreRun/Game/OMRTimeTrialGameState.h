@@ -4,8 +4,28 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameStateBase.h"
+#include "OMRTickScheduler.h"
+#include "OMRGhostRecorder.h"
+#include "OMRSessionReplay.h"
+#include "OMRRaceEvents.h"
+#include "../Track/OMRTimingLines.h"
+#include "../Track/OMRTrackProgress.h"
+#include "../Track/OMRTrackBounds.h"
+#include "../Player/OMRRewindBuffer.h"
 #include "OMRTimeTrialGameState.generated.h"
 
+// What an out of bounds respawn does to the lap clock
+UENUM(BlueprintType)
+enum class EOMRRespawnClockPolicy : uint8
+{
+	// The clock never stops, the time lost falling is the penalty
+	KeepRunning,
+
+	// Clock back to the checkpoint crossing plus RespawnPenaltyTime. Like a rewind, the
+	// lap can't set a best
+	RestoreWithPenalty,
+};
+
 /**
  * 
  */
@@ -17,10 +37,64 @@ class ONEMORERUN_API AOMRTimeTrialGameState : public AGameStateBase
 public:
 	AOMRTimeTrialGameState();
 
-	// Functions
-	void StartLap();
-	void CompleteLap();
+	// Functions, times are on the race clock (world time, or physics step time mapped onto it)
+	void StartLap(double StartTime);
+	void CompleteLap(double FinishTime);
+
+	// "One more run": lap, split, checkpoint and pawn state back to race start and the
+	// countdown restarted, all in place within the frame. Best lap and ghosts are kept
+	UFUNCTION(BlueprintCallable)
+	void RestartRace();
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnRaceRestarted);
+
+	UPROPERTY(BlueprintAssignable)
+	FOnRaceRestarted OnRaceRestarted;
+
+	// Practice rewind: the lap clock and checkpoint progress go back with the ball. A rewound
+	// lap can't set a best, and input logs stop being written until the next restart
+	void CaptureLapClock(FOMRLapClock& OutClock) const;
+	bool RestoreLapClock(const FOMRLapClock& Clock);
+
+	// Input replays start mid-race, on the lap and lap clock the log was recorded from
+	void StartReplayedLap(const FOMRLapClock& Clock);
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bCurrentLapRewound = false;
+
+	bool bRewoundSinceRestart = false;
+
+	// Out of bounds: every physics step of the ball's path is held to the track's kill plane
+	// and play volumes, leaving them respawns the ball where it crossed the last checkpoint
+	UFUNCTION(BlueprintCallable)
+	void RespawnAtCheckpoint();
+
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Respawn")
+	bool bEnableOutOfBoundsRespawn = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Respawn")
+	EOMRRespawnClockPolicy RespawnClockPolicy = EOMRRespawnClockPolicy::KeepRunning;
+
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Respawn", meta = (EditCondition = "RespawnClockPolicy == EOMRRespawnClockPolicy::RestoreWithPenalty"))
+	float RespawnPenaltyTime = 3.f;
+
+	// Share of the crossing speed the ball respawns with, in the direction it had
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Respawn", meta = (ClampMin = "0", ClampMax = "1"))
+	float RespawnSpeedScale = 0.5f;
+
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBallRespawned, int32, CheckpointIndex);
+
+	// INDEX_NONE when respawned on the gate
+	UPROPERTY(BlueprintAssignable)
+	FOnBallRespawned OnBallRespawned;
+
+	// Overlap path
 	void HandleStartFinishCross();
+
+	// Exact crossing, from the timing lines. Both paths are rate limited by GateCooldown, which
+	// is also the shortest lap that can finish
+	void HandleStartFinishCrossing(double CrossTime);
+	void RegisterCheckpointCrossing(int32 CheckpointIndex, const FTransform& CheckpointTransform, double CrossTime);
 		
 	// Lap State
 	UPROPERTY(BlueprintReadOnly)
@@ -29,6 +103,9 @@ public:
 	UPROPERTY(BlueprintReadOnly)
 	float LapStartTime = 0.f;
 
+	// Full precision LapStartTime, lap and split times are measured from this
+	double LapStartRaceTime = 0.0;
+
 	UPROPERTY(BlueprintReadOnly)
 	float CurrentLapTime = 0.f;
 
@@ -44,13 +121,25 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	float GateCooldown = 2.0f;
 
+	// Backward gate crossings during the lap not yet undone by driving forward over it again
+	int32 GateBackwardCrossings = 0;
+
 	UFUNCTION(BlueprintPure)
 	float GetDisplayedLaptime() const;
 
+	// Lap and best as the HUD should show them, from the recording while watching the session
+	UFUNCTION(BlueprintPure)
+	int32 GetDisplayedLap() const { return bPlayingSession ? PlaybackRaceState.Lap : CurrentLap; }
+
+	UFUNCTION(BlueprintPure)
+	float GetDisplayedBestLapTime() const { return bPlayingSession ? PlaybackRaceState.BestLapTime : BestLapTime; }
+
 	// Checkpoint System
 	UPROPERTY(BlueprintReadOnly)
 	int32 CurrentCheckpointIndex = 0.f;
 
+	// Checkpoints to clear per lap, at least what the checkpoint registry holds. Set it for
+	// tracks whose later checkpoints stream in during the lap
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 TotalCheckpoints= 0.f;
 
@@ -60,6 +149,10 @@ public:
 	UPROPERTY(BlueprintReadOnly)
 	TArray<float> BestSplitTimes;
 
+	// Splits of the last completed lap, SplitTimes is already reset for the next one
+	UPROPERTY(BlueprintReadOnly)
+	TArray<float> LastLapSplitTimes;
+
 	UPROPERTY(BlueprintReadOnly)
 	FTransform LastCheckpointTransform;
 
@@ -72,11 +165,12 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void ResetCheckpoints();
 
-	UPROPERTY()
-	TArray<TObjectPtr<class AOMRCheckpoint>> CachedCheckpoints;
+	// Gate and checkpoints are timed by intersecting the ball's swept path with their
+	// trigger planes; their overlap triggers are switched off
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Checkpoints")
+	bool bUseTimingLines = true;
 
-	UFUNCTION()
-	void CacheCheckpoints();
+	FOMRTimingLines TimingLines;
 
 	// UI updates
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnLapTimeUpdated, float, NewTime);
@@ -92,6 +186,11 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnLapNumberUpdated OnLapNumberUpdated;
 
+	// HUD lap time feed rate, the lap timer task ticks no faster than this. Only broadcast to
+	// bound listeners, the native HUD reads GetDisplayedLaptime every frame instead
+	UPROPERTY(EditDefaultsOnly)
+	float LapTimerUpdateRate = 20.f;
+
 	float LapTimeBroadcastAccumulator = 0.f;
 	float LastBroadcastLapTime = 0.f;
 
@@ -102,8 +201,171 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FOnSplitUpdated OnSplitUpdated;
 
+	// Live delta: how far ahead (negative) or behind the best lap the ball is right now
+	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnLiveDeltaUpdated, float, LiveDelta, float, PredictedLapTime);
+
+	// Sent at the HUD feed rate while a best lap exists to compare against
+	UPROPERTY(BlueprintAssignable)
+	FOnLiveDeltaUpdated OnLiveDeltaUpdated;
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bHasLiveDelta = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	float LiveDelta = 0.f;
+
+	UPROPERTY(BlueprintReadOnly)
+	float PredictedLapTime = 0.f;
+
+	// Distance along the track this lap, cm from the gate
+	UPROPERTY(BlueprintReadOnly)
+	float LapProgressDistance = 0.f;
+
+	// Distance index of the current layout, also used for the ghost crowd's gaps
+	const FOMRTrackProgress& GetTrackProgress() const { return TrackProgress; }
+
+	// Resolution of the best lap's time-at-distance curve
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Live Delta")
+	float ProgressCurveStep = 100.f;
+
+	// Ghosts: every lap is recorded, the best one is kept separately
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Ghosts")
+	int32 GhostHistoryLaps = 32;
+
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Ghosts")
+	float GhostMaxLapDuration = 180.f;
+
+	// Completed laps kept in Saved/Ghosts for the ghost crowd, the slowest go first. The
+	// saved best is kept on its own
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Ghosts")
+	int32 SavedLapGhosts = 100;
+
+	const FOMRGhostRecorder& GetGhostRecorder() const { return GhostRecorder; }
+
+	// Session replay: every frame the player saw since BeginPlay, with the HUD and audio events
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Replay")
+	bool bRecordSession = true;
+
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Replay", meta = (EditCondition = "bRecordSession"))
+	float SessionReplayDuration = 1800.f;
+
+	void AddReplayEvent(EOMRReplayEvent Type, int32 Value = 0, float A = 0.f, float B = 0.f, uint8 Flags = 0);
+
+	// Watching the session drops the live lap, the race restarts when playback stops
+	UFUNCTION(BlueprintCallable)
+	void StartSessionPlayback(float Time);
+
+	UFUNCTION(BlueprintCallable)
+	void SeekSessionPlayback(float Time);
+
+	UFUNCTION(BlueprintCallable)
+	void StopSessionPlayback();
+
+	UFUNCTION(BlueprintPure)
+	float GetSessionDuration() const { return SessionReplay.GetDuration(); }
+
+	UPROPERTY(BlueprintReadOnly)
+	bool bPlayingSession = false;
+
+	UPROPERTY(BlueprintReadOnly)
+	float SessionPlaybackTime = 0.f;
+
+	const FOMRSessionReplay& GetSessionReplay() const { return SessionReplay; }
+
+	// Native race events, delivered once per frame at the end of the world tick. The dynamic
+	// delegates above stay for Blueprint, C++ listeners should use this
+	FOMRRaceEventBus& GetRaceEvents() { return RaceEvents; }
+
+	// Stamps the world time and, unless set, the current lap
+	void PostRaceEvent(FOMRRaceEvent Event);
+
+	// Writes the pawn's input log with every completed lap, for UOMRValidateLapsCommandlet
+	UPROPERTY(EditDefaultsOnly, Category = "TimeTrial | Validation")
+	bool bSaveLapInputLogs = true;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
+
+	// Ghost recording
+	void RecordGhostFrame(float DeltaTime);
+	bool GetGhostSample(FOMRGhostSample& OutSample);
+	class AOMRPlayerPawn* GetGhostSource();
+
+	// Saved best lap (Saved/Ghosts), loaded when the first lap starts
+	void LoadSavedBest();
+	void SaveBestGhost();
+	void SaveLapGhost();
+	void SaveLapInputLog();
+
+	// Off in validation and replay worlds
+	bool ShouldPersistLaps();
+
+	FString GetTrackName() const;
+
+	// Checkpoints and gates come and go with streaming, see UOMRCheckpointRegistry
+	void OnCheckpointRegistryChanged();
+
+	int32 ConfiguredTotalCheckpoints = 0;
+	FDelegateHandle CheckpointRegistryHandle;
+
+	// Swept ball path against the gate and checkpoint planes, once per frame after physics
+	void BuildTimingLines();
+	void UpdateTimingLines();
+
+	// Timing lines and progress index, rebuilt after the registry changed
+	void RefreshTrackLayout();
+	bool bTrackLayoutDirty = false;
+
+	// Out of bounds, see FOMRTrackBounds
+	void BuildTrackBounds();
+	void UpdateTrackBounds();
+	void CaptureRespawnSnapshot(int32 CheckpointIndex);
+
+	FOMRTrackBounds TrackBounds;
+
+	// Ball, camera and lap clock as the last gate or checkpoint was crossed
+	FOMRRewindSnapshot RespawnSnapshot;
+	int32 RespawnCheckpointIndex = INDEX_NONE;
+	bool bHasRespawnSnapshot = false;
+
+	// Live delta, see FOMRTrackProgress
+	void BuildTrackProgress();
+	void BuildBestProgressCurve();
+	void UpdateLapProgress();
+
+	FOMRTrackProgress TrackProgress;
+	FOMRLapProgressTracker LapProgress;
+
+	// Best lap's time at each distance, derived from its ghost so saved bests get one too
+	FOMRProgressCurve BestProgressCurve;
+
+	bool bLoadedSavedBest = false;
+
+	// Session replay
+	float GetSessionTime() const;
+	void RecordSessionFrame();
+	void UpdateSessionPlayback(float DeltaTime);
+	void ShowSessionFrame();
+	void PlayReplayEvent(const FOMRReplayEvent& Event);
+
+	FOMRSessionReplay SessionReplay;
+
+	FOMRRaceEventBus RaceEvents;
+
+	// Live race state as the events built it, stored on every keyframe
+	FOMRReplayRaceState SessionRaceState;
+	FOMRReplayRaceState PlaybackRaceState;
+
+	// World time of session time 0, moved on by the time spent watching
+	double SessionStartTime = 0.0;
+	double PlaybackStartWorldTime = 0.0;
+
+	FOMRTickScheduler TickScheduler;
+
+	FOMRGhostRecorder GhostRecorder;
 
-	virtual void Tick(float DeltaTime) override;
+	TWeakObjectPtr<class AOMRPlayerPawn> GhostSource;
 };
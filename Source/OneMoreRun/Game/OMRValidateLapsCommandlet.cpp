@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRValidateLapsCommandlet.h"
+#include "OMRTimeTrialGameState.h"
+#include "OMRGhostFile.h"
+#include "../Player/OMRInputLog.h"
+#include "../Player/OMRPlayerPawn.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+UOMRValidateLapsCommandlet::UOMRValidateLapsCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UOMRValidateLapsCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	const FString* Map = ParamValues.Find(TEXT("Map"));
+	if (!Map)
+	{
+		UE_LOG(LogTemp, Error, TEXT("OMRValidateLaps needs -Map=<package>."));
+		return 1;
+	}
+
+	float Tolerance = 0.05f;
+	if (const FString* ToleranceValue = ParamValues.Find(TEXT("Tolerance")))
+	{
+		Tolerance = FMath::Max(FCString::Atof(**ToleranceValue), 0.f);
+	}
+
+	if (Switches.Contains(TEXT("Worker")))
+	{
+		const FString* LogList = ParamValues.Find(TEXT("LogList"));
+		const FString* Results = ParamValues.Find(TEXT("Results"));
+
+		if (!LogList || !Results)
+		{
+			UE_LOG(LogTemp, Error, TEXT("OMRValidateLaps worker needs -LogList= and -Results=."));
+			return 1;
+		}
+
+		return RunWorker(*Map, *LogList, *Results, Tolerance);
+	}
+
+	const FString* Logs = ParamValues.Find(TEXT("Logs"));
+	const FString LogDirectory = Logs ? *Logs : FOMRInputLog::GetLogDirectory();
+
+	int32 NumWorkers = FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+	if (const FString* WorkersValue = ParamValues.Find(TEXT("Workers")))
+	{
+		NumWorkers = FCString::Atoi(**WorkersValue);
+	}
+
+	return RunCoordinator(*Map, LogDirectory, FMath::Max(NumWorkers, 1), Tolerance);
+}
+
+int32 UOMRValidateLapsCommandlet::RunCoordinator(const FString& Map, const FString& LogDirectory, int32 NumWorkers, float Tolerance)
+{
+	TArray<FString> LogFiles;
+	IFileManager::Get().FindFiles(LogFiles, *(LogDirectory / TEXT("*.omrinput")), true, false);
+
+	if (LogFiles.Num() == 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("No input logs in %s."), *LogDirectory);
+		return 0;
+	}
+
+	NumWorkers = FMath::Min(NumWorkers, LogFiles.Num());
+
+	const FString WorkDirectory = FPaths::ProjectSavedDir() / TEXT("LapValidation");
+	IFileManager::Get().MakeDirectory(*WorkDirectory, true);
+
+	const FString Executable = FPlatformProcess::ExecutablePath();
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+
+	TArray<FProcHandle> Workers;
+	TArray<FString> ResultFiles;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	for (int32 Worker = 0; Worker < NumWorkers; ++Worker)
+	{
+		// Round robin so long and short logs spread evenly
+		TArray<FString> Share;
+		for (int32 i = Worker; i < LogFiles.Num(); i += NumWorkers)
+		{
+			Share.Add(FPaths::ConvertRelativePathToFull(LogDirectory / LogFiles[i]));
+		}
+
+		const FString LogListFile = FPaths::ConvertRelativePathToFull(WorkDirectory / FString::Printf(TEXT("Worker%d.txt"), Worker));
+		const FString ResultsFile = FPaths::ConvertRelativePathToFull(WorkDirectory / FString::Printf(TEXT("Worker%d.csv"), Worker));
+
+		IFileManager::Get().Delete(*ResultsFile, false, true, true);
+
+		if (!FFileHelper::SaveStringArrayToFile(Share, *LogListFile))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not write %s."), *LogListFile);
+			continue;
+		}
+
+		const FString Args = FString::Printf(
+			TEXT("\"%s\" -run=OMRValidateLaps -Worker -Map=%s -LogList=\"%s\" -Results=\"%s\" -Tolerance=%f -nullrhi -nosound -unattended -nopause -nosplash"),
+			*ProjectFile, *Map, *LogListFile, *ResultsFile, Tolerance);
+
+		FProcHandle Handle = FPlatformProcess::CreateProc(*Executable, *Args, false, true, true, nullptr, 0, nullptr, nullptr);
+
+		if (!Handle.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not start validation worker %d."), Worker);
+			continue;
+		}
+
+		Workers.Add(Handle);
+		ResultFiles.Add(ResultsFile);
+	}
+
+	for (FProcHandle& Handle : Workers)
+	{
+		FPlatformProcess::WaitForProc(Handle);
+		FPlatformProcess::CloseProc(Handle);
+	}
+
+	int32 NumValid = 0;
+	int32 NumInvalid = 0;
+	int32 NumReported = 0;
+
+	for (const FString& ResultsFile : ResultFiles)
+	{
+		TArray<FString> Lines;
+		FFileHelper::LoadFileToStringArray(Lines, *ResultsFile);
+
+		for (const FString& Line : Lines)
+		{
+			FResult Result;
+			if (!ParseResult(Line, Result)) continue;
+
+			++NumReported;
+
+			if (Result.bValid)
+			{
+				++NumValid;
+			}
+			else
+			{
+				++NumInvalid;
+				UE_LOG(LogTemp, Warning, TEXT("%s: %s, claimed %.3f, simulated %.3f, worst split off by %.3f"),
+					*FPaths::GetCleanFilename(Result.LogFile),
+					Result.bError ? TEXT("error") : TEXT("mismatch"),
+					Result.ClaimedTime, Result.SimulatedTime, Result.MaxSplitError);
+			}
+		}
+	}
+
+	// Logs a worker never reported on (crash, failed launch) count as failures
+	const int32 NumMissing = LogFiles.Num() - NumReported;
+
+	UE_LOG(LogTemp, Display, TEXT("Validated %d logs with %d workers in %.1f s: %d valid, %d invalid, %d missing."),
+		LogFiles.Num(), Workers.Num(), FPlatformTime::Seconds() - StartTime, NumValid, NumInvalid, NumMissing);
+
+	return NumInvalid == 0 && NumMissing == 0 ? 0 : 1;
+}
+
+int32 UOMRValidateLapsCommandlet::RunWorker(const FString& Map, const FString& LogListFile, const FString& ResultsFile, float Tolerance)
+{
+	TArray<FString> LogFiles;
+	if (!FFileHelper::LoadFileToStringArray(LogFiles, *LogListFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not read %s."), *LogListFile);
+		return 1;
+	}
+
+	TArray<FString> Lines;
+
+	for (const FString& LogFile : LogFiles)
+	{
+		if (LogFile.IsEmpty()) continue;
+
+		FResult Result;
+		ValidateLog(Map, LogFile, Tolerance, Result);
+		Lines.Add(FormatResult(Result));
+	}
+
+	return FFileHelper::SaveStringArrayToFile(Lines, *ResultsFile) ? 0 : 1;
+}
+
+bool UOMRValidateLapsCommandlet::ValidateLog(const FString& Map, const FString& LogFile, float Tolerance, FResult& OutResult)
+{
+	OutResult.LogFile = LogFile;
+	OutResult.bError = true;
+
+	FOMRInputLog Log;
+	if (!Log.Load(LogFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not read input log %s."), *LogFile);
+		return false;
+	}
+
+	const FOMRInputLog::FHeader& Claim = Log.GetClaim();
+	OutResult.ClaimedTime = Claim.LapTime;
+
+	if (Claim.TrackId != FOMRGhostFile::MakeTrackId(FPackageName::GetShortName(Map)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s was recorded on another track."), *LogFile);
+		return false;
+	}
+
+	// Fresh world per log so nothing carries over between runs
+	UPackage* Package = LoadPackage(nullptr, *Map, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load map %s."), *Map);
+		return false;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(true)
+			.SetTransactional(false));
+	}
+
+	World->UpdateWorldComponents(true, false);
+
+	FURL URL;
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+
+	// No player joins, spawn the default pawn where a player would start
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	UClass* PawnClass = GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf<AOMRPlayerPawn>()
+		? GameMode->DefaultPawnClass.Get()
+		: AOMRPlayerPawn::StaticClass();
+
+	AActor* PlayerStart = GameMode ? GameMode->FindPlayerStart(nullptr) : nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AOMRPlayerPawn* Pawn = World->SpawnActor<AOMRPlayerPawn>(
+		PawnClass,
+		PlayerStart ? PlayerStart->GetActorTransform() : FTransform::Identity,
+		SpawnParams
+	);
+
+	AOMRTimeTrialGameState* GameState = World->GetGameState<AOMRTimeTrialGameState>();
+
+	bool bCompleted = false;
+
+	if (Pawn && GameState)
+	{
+		if (Claim.TuningHash != Pawn->GetTuningHash())
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s was recorded with different ball tuning."), *LogFile);
+		}
+		else
+		{
+			Pawn->StartInputReplay(&Log);
+
+			for (int32 Frame = 0; Frame < Log.Num(); ++Frame)
+			{
+				World->Tick(LEVELTICK_All, FOMRInputLog::GetDeltaTime(Log.GetFrame(Frame)));
+
+				// Finishing lap N starts lap N + 1 on the same frame
+				if (GameState->CurrentLap > Claim.LapNumber)
+				{
+					bCompleted = true;
+					break;
+				}
+			}
+
+			OutResult.bError = false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: no time trial game state or player pawn."), *Map);
+	}
+
+	if (bCompleted)
+	{
+		OutResult.SimulatedTime = GameState->CurrentLapTime;
+
+		const TArray<float>& ClaimedSplits = Log.GetClaimedSplitTimes();
+		const TArray<float>& SimulatedSplits = GameState->LastLapSplitTimes;
+
+		bool bSplitsMatch = ClaimedSplits.Num() == SimulatedSplits.Num();
+
+		for (int32 i = 0; bSplitsMatch && i < ClaimedSplits.Num(); ++i)
+		{
+			OutResult.MaxSplitError = FMath::Max(OutResult.MaxSplitError, FMath::Abs(ClaimedSplits[i] - SimulatedSplits[i]));
+		}
+
+		OutResult.bValid =
+			bSplitsMatch &&
+			!Pawn->HasReplayDiverged() &&
+			FMath::Abs(OutResult.SimulatedTime - OutResult.ClaimedTime) <= Tolerance &&
+			OutResult.MaxSplitError <= Tolerance;
+	}
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return OutResult.bValid;
+}
+
+FString UOMRValidateLapsCommandlet::FormatResult(const FResult& Result)
+{
+	return FString::Printf(TEXT("%s,%s,%.4f,%.4f,%.4f"),
+		*Result.LogFile,
+		Result.bError ? TEXT("Error") : (Result.bValid ? TEXT("Valid") : TEXT("Invalid")),
+		Result.ClaimedTime,
+		Result.SimulatedTime,
+		Result.MaxSplitError);
+}
+
+bool UOMRValidateLapsCommandlet::ParseResult(const FString& Line, FResult& OutResult)
+{
+	TArray<FString> Fields;
+	Line.ParseIntoArray(Fields, TEXT(","), false);
+
+	if (Fields.Num() != 5) return false;
+
+	OutResult.LogFile = Fields[0];
+	OutResult.bError = Fields[1] == TEXT("Error");
+	OutResult.bValid = Fields[1] == TEXT("Valid");
+	OutResult.ClaimedTime = FCString::Atof(*Fields[2]);
+	OutResult.SimulatedTime = FCString::Atof(*Fields[3]);
+	OutResult.MaxSplitError = FCString::Atof(*Fields[4]);
+
+	return true;
+}
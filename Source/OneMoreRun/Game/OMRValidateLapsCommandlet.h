@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OMRValidateLapsCommandlet.generated.h"
+
+/**
+ * Re-simulates recorded input logs (FOMRInputLog) headless and checks each reproduces its
+ * claimed lap time and splits.
+ *
+ * UnrealEditor-Cmd OneMoreRun.uproject -run=OMRValidateLaps -Map=/Game/Maps/L_TestGym
+ *     [-Logs=<dir, default Saved/LapLogs>] [-Workers=<cores>] [-Tolerance=0.05] -nullrhi -nosound
+ *
+ * Logs are split across worker processes, each replaying its share in its own game world
+ * with ticks as fast as the CPU allows. Returns non-zero if any log fails or errors.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRValidateLapsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOMRValidateLapsCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FResult
+	{
+		FString LogFile;
+		bool bValid = false;
+		bool bError = false;
+		float ClaimedTime = 0.f;
+		float SimulatedTime = 0.f;
+		float MaxSplitError = 0.f;
+	};
+
+	int32 RunCoordinator(const FString& Map, const FString& LogDirectory, int32 NumWorkers, float Tolerance);
+	int32 RunWorker(const FString& Map, const FString& LogListFile, const FString& ResultsFile, float Tolerance);
+
+	bool ValidateLog(const FString& Map, const FString& LogFile, float Tolerance, FResult& OutResult);
+
+	static FString FormatResult(const FResult& Result);
+	static bool ParseResult(const FString& Line, FResult& OutResult);
+};
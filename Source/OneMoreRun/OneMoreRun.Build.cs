@@ -15,6 +15,7 @@ public class OneMoreRun : ModuleRules
 			"InputCore", 
 			"EnhancedInput",
 			"PhysicsCore",
+			"Chaos",
             "UMG",
 			"Slate",
 			"SlateCore"
@@ -3,4 +3,35 @@
 #include "OneMoreRun.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_STAT(STAT_OMR_GroundSweeps);
+DEFINE_STAT(STAT_OMR_ForcesApplied);
+DEFINE_STAT(STAT_OMR_BodyStateReads);
+DEFINE_STAT(STAT_OMR_Broadcasts);
+
+UE_TRACE_CHANNEL_DEFINE(OMRChannel);
+
+LLM_DEFINE_TAG(OMR_Gameplay);
+LLM_DEFINE_TAG(OMR_Track);
+LLM_DEFINE_TAG(OMR_Crowd);
+LLM_DEFINE_TAG(OMR_Ghosts);
+
+#if WITH_DEV_AUTOMATION_TESTS
+static thread_local int32 GOMRGameplayScopeDepth = 0;
+
+FOMRGameplayScope::FOMRGameplayScope()
+{
+	++GOMRGameplayScopeDepth;
+}
+
+FOMRGameplayScope::~FOMRGameplayScope()
+{
+	--GOMRGameplayScopeDepth;
+}
+
+bool FOMRGameplayScope::IsActive()
+{
+	return GOMRGameplayScopeDepth > 0;
+}
+#endif
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, OneMoreRun, "OneMoreRun" );
@@ -3,4 +3,46 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "HAL/LowLevelMemTracker.h"
 
+// stat OMR / Insights "OMR" channel
+DECLARE_STATS_GROUP(TEXT("OMR"), STATGROUP_OMR, STATCAT_Advanced);
+
+// Per-frame counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ground Sweeps"), STAT_OMR_GroundSweeps, STATGROUP_OMR, ONEMORERUN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Forces Applied"), STAT_OMR_ForcesApplied, STATGROUP_OMR, ONEMORERUN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Body State Reads"), STAT_OMR_BodyStateReads, STATGROUP_OMR, ONEMORERUN_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Delegate Broadcasts"), STAT_OMR_Broadcasts, STATGROUP_OMR, ONEMORERUN_API);
+
+UE_TRACE_CHANNEL_EXTERN(OMRChannel, ONEMORERUN_API);
+
+// Memory tags (-llm, stat LLM / Insights memory): pawn and race state, baked track data, bot crowd, lap ghosts
+LLM_DECLARE_TAG_API(OMR_Gameplay, ONEMORERUN_API);
+LLM_DECLARE_TAG_API(OMR_Track, ONEMORERUN_API);
+LLM_DECLARE_TAG_API(OMR_Crowd, ONEMORERUN_API);
+LLM_DECLARE_TAG_API(OMR_Ghosts, ONEMORERUN_API);
+
+#if WITH_DEV_AUTOMATION_TESTS
+// Marks gameplay work on this thread, so the steady state allocation test counts what
+// gameplay allocates and not what the engine does around it
+struct ONEMORERUN_API FOMRGameplayScope
+{
+	FOMRGameplayScope();
+	~FOMRGameplayScope();
+
+	static bool IsActive();
+};
+
+#define OMR_GAMEPLAY_SCOPE() FOMRGameplayScope ANONYMOUS_VARIABLE(OMRGameplayScope)
+#else
+#define OMR_GAMEPLAY_SCOPE()
+#endif
+
+// Times a gameplay stage in both stat OMR and Insights (enable with -trace=cpu,OMR)
+#define OMR_SCOPED_STAGE(Stat) \
+	OMR_GAMEPLAY_SCOPE(); \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, OMRChannel)
@@ -0,0 +1,310 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRBallCrowd.h"
+#include "OMRGroundProbe.h"
+#include "../Track/OMRTrackSurfaceField.h"
+
+void FOMRBallCrowd::Reset(int32 Capacity)
+{
+	TArray<float>* Arrays[] = {
+		&PosX, &PosY, &PosZ, &VelX, &VelY, &VelZ, &AngX, &AngY, &AngZ,
+		&InputX, &InputY, &SmoothX, &SmoothY, &SmoothZ,
+		&GroundZ, &NormalX, &NormalY, &NormalZ, &RawGrounded,
+		&Grounded, &CoyoteTime, &ConfirmTime
+	};
+
+	for (TArray<float>* Array : Arrays)
+	{
+		Array->Reset(Capacity);
+	}
+}
+
+int32 FOMRBallCrowd::Add(const FVector& Location, const FVector& Velocity)
+{
+	const int32 Index = PosX.Add(Location.X);
+	PosY.Add(Location.Y);
+	PosZ.Add(Location.Z);
+
+	VelX.Add(Velocity.X);
+	VelY.Add(Velocity.Y);
+	VelZ.Add(Velocity.Z);
+
+	AngX.Add(0.f);
+	AngY.Add(0.f);
+	AngZ.Add(0.f);
+
+	InputX.Add(0.f);
+	InputY.Add(0.f);
+	SmoothX.Add(0.f);
+	SmoothY.Add(0.f);
+	SmoothZ.Add(0.f);
+
+	GroundZ.Add(Tuning.FallbackGroundZ);
+	NormalX.Add(0.f);
+	NormalY.Add(0.f);
+	NormalZ.Add(1.f);
+	RawGrounded.Add(0.f);
+
+	Grounded.Add(0.f);
+	CoyoteTime.Add(0.f);
+	ConfirmTime.Add(0.f);
+
+	return Index;
+}
+
+void FOMRBallCrowd::SetInput(int32 Index, float DirX, float DirY)
+{
+	InputX[Index] = DirX;
+	InputY[Index] = DirY;
+}
+
+void FOMRBallCrowd::Step(float DeltaTime, const FOMRTrackSurfaceField* Field)
+{
+	if (DeltaTime <= 0.f || Num() == 0) return;
+
+	UpdateGround(Field);
+	UpdateGroundedTimers(DeltaTime);
+	ApplyMovementForce(DeltaTime);
+	Integrate(DeltaTime);
+	SyncAngularVelocityWithLinear(DeltaTime);
+}
+
+void FOMRBallCrowd::UpdateGround(const FOMRTrackSurfaceField* Field)
+{
+	const int32 Count = Num();
+	const float Radius = Tuning.Ball.Radius * FOMRGroundProbe::RadiusScale;
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		if (Field && Field->IsValid())
+		{
+			FOMRTrackSurfaceField::FSample Sample;
+
+			switch (Field->Lookup(FVector(PosX[i], PosY[i], PosZ[i]), Sample))
+			{
+			case FOMRTrackSurfaceField::ELookup::Hit:
+				GroundZ[i] = Sample.Height;
+				NormalX[i] = Sample.Normal.X;
+				NormalY[i] = Sample.Normal.Y;
+				NormalZ[i] = Sample.Normal.Z;
+				break;
+
+			case FOMRTrackSurfaceField::ELookup::Empty:
+				GroundZ[i] = -UE_BIG_NUMBER;
+				NormalX[i] = 0.f;
+				NormalY[i] = 0.f;
+				NormalZ[i] = 1.f;
+				break;
+
+			default:
+				// No scene queries here: keep last step's ground on edges/overhangs
+				break;
+			}
+		}
+		else
+		{
+			GroundZ[i] = Tuning.FallbackGroundZ;
+		}
+
+		// Same reach as the pawn's ground sweep
+		const float Gap = (PosZ[i] - GroundZ[i]) - Radius / FMath::Max(NormalZ[i], 0.1f);
+		RawGrounded[i] = (Gap <= FOMRGroundProbe::SweepDistance && NormalZ[i] > FOMRGroundProbe::WalkableNormalZ) ? 1.f : 0.f;
+	}
+}
+
+void FOMRBallCrowd::UpdateGroundedTimers(float DeltaTime)
+{
+	const int32 Count = Num();
+	const float CoyoteDuration = Tuning.CoyoteTimeDuration;
+	const float ConfirmDuration = Tuning.GroundConfirmDuration;
+
+	const float* RESTRICT Raw = RawGrounded.GetData();
+	float* RESTRICT Stable = Grounded.GetData();
+	float* RESTRICT Coyote = CoyoteTime.GetData();
+	float* RESTRICT Confirm = ConfirmTime.GetData();
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const bool bRaw = Raw[i] > 0.f;
+
+		Confirm[i] = bRaw ? Confirm[i] + DeltaTime : 0.f;
+		Coyote[i] = bRaw ? CoyoteDuration : FMath::Max(Coyote[i] - DeltaTime, 0.f);
+
+		// Ground after confirm, unground after coyote, otherwise hold
+		const float BecomeGrounded = (bRaw && Confirm[i] >= ConfirmDuration) ? 1.f : Stable[i];
+		Stable[i] = (!bRaw && Coyote[i] <= 0.f) ? 0.f : BecomeGrounded;
+	}
+}
+
+void FOMRBallCrowd::ApplyMovementForce(float DeltaTime)
+{
+	const int32 Count = Num();
+	const FOMRBallTuning& Ball = Tuning.Ball;
+
+	const float InvMass = 1.f / FMath::Max(Tuning.Mass, KINDA_SMALL_NUMBER);
+	const float InterpAlpha = FMath::Clamp(DeltaTime * Ball.InputDirInterpSpeed, 0.f, 1.f);
+	const float InvMaxSpeed = 1.f / FMath::Max(Ball.MaxSpeed, KINDA_SMALL_NUMBER);
+
+	const float* RESTRICT InX = InputX.GetData();
+	const float* RESTRICT InY = InputY.GetData();
+	const float* RESTRICT NX = NormalX.GetData();
+	const float* RESTRICT NY = NormalY.GetData();
+	const float* RESTRICT NZ = NormalZ.GetData();
+	const float* RESTRICT Stable = Grounded.GetData();
+	float* RESTRICT SX = SmoothX.GetData();
+	float* RESTRICT SY = SmoothY.GetData();
+	float* RESTRICT SZ = SmoothZ.GetData();
+	float* RESTRICT VX = VelX.GetData();
+	float* RESTRICT VY = VelY.GetData();
+	float* RESTRICT VZ = VelZ.GetData();
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		const bool bGrounded = Stable[i] > 0.f;
+
+		const float GX = bGrounded ? NX[i] : 0.f;
+		const float GY = bGrounded ? NY[i] : 0.f;
+		const float GZ = bGrounded ? NZ[i] : 1.f;
+
+		// Input flattened onto the ground plane
+		const float InDotN = InX[i] * GX + InY[i] * GY;
+		float DirX = InX[i] - GX * InDotN;
+		float DirY = InY[i] - GY * InDotN;
+		float DirZ = -GZ * InDotN;
+		const float DirSq = DirX * DirX + DirY * DirY + DirZ * DirZ;
+		const float DirInv = DirSq > UE_SMALL_NUMBER ? FMath::InvSqrt(DirSq) : 0.f;
+		DirX *= DirInv;
+		DirY *= DirInv;
+		DirZ *= DirInv;
+
+		// Smooth INPUT intent only
+		SX[i] += (DirX - SX[i]) * InterpAlpha;
+		SY[i] += (DirY - SY[i]) * InterpAlpha;
+		SZ[i] += (DirZ - SZ[i]) * InterpAlpha;
+
+		// Kill micro drift
+		const float SmoothSq = SX[i] * SX[i] + SY[i] * SY[i] + SZ[i] * SZ[i];
+		const float Keep = SmoothSq < 0.001f ? 0.f : 1.f;
+		SX[i] *= Keep;
+		SY[i] *= Keep;
+		SZ[i] *= Keep;
+
+		const float Speed = FMath::Sqrt(VX[i] * VX[i] + VY[i] * VY[i] + VZ[i] * VZ[i]);
+		const float SpeedAlpha = FMath::Clamp(Speed * InvMaxSpeed, 0.f, 1.f);
+		const float VelDotIn = VX[i] * SX[i] + VY[i] * SY[i] + VZ[i] * SZ[i];
+		const bool bBlocked = (Speed >= Ball.MaxSpeed && VelDotIn > 0.f) || Keep == 0.f;
+
+		const float ForceScale = FMath::Lerp(0.35f, 1.0f, SpeedAlpha);
+		const float Steering = 1.f - SpeedAlpha * 0.4f;
+
+		// Grounded: re-project and renormalize, scale by slope. Air: keep steering reduction.
+		const float SmoothDotN = SX[i] * GX + SY[i] * GY + SZ[i] * GZ;
+		float FX = SX[i] - GX * SmoothDotN;
+		float FY = SY[i] - GY * SmoothDotN;
+		float FZ = SZ[i] - GZ * SmoothDotN;
+		const float FSq = FX * FX + FY * FY + FZ * FZ;
+		const float FInv = FSq > UE_SMALL_NUMBER ? FMath::InvSqrt(FSq) : 0.f;
+
+		const float SlopeMultiplier = FMath::Clamp(FMath::Lerp(1.0f, 0.1f, FMath::Clamp((GZ - 0.95f) / (0.65f - 0.95f), 0.f, 1.f)), 0.1f, 1.0f);
+		const float SlopeBoost = FMath::Lerp(1.1f, 1.0f, GZ);
+
+		const float GroundScale = FInv * SlopeMultiplier * SlopeBoost;
+		const float AirScale = Steering * Ball.AirControlMultiplier;
+
+		FX = bGrounded ? FX * GroundScale : SX[i] * AirScale;
+		FY = bGrounded ? FY * GroundScale : SY[i] * AirScale;
+		FZ = bGrounded ? FZ * GroundScale : SZ[i] * AirScale;
+
+		const float Accel = bBlocked ? 0.f : Ball.MoveForce * ForceScale * InvMass * DeltaTime;
+
+		VX[i] += FX * Accel;
+		VY[i] += FY * Accel;
+		VZ[i] += FZ * Accel;
+	}
+}
+
+void FOMRBallCrowd::Integrate(float DeltaTime)
+{
+	const int32 Count = Num();
+	const float Radius = Tuning.Ball.Radius;
+	const float MaxSpeed = Tuning.Ball.MaxSpeed;
+	const float Damping = 1.f / (1.f + Tuning.LinearDamping * DeltaTime);
+	const float GravityStep = Tuning.GravityZ * DeltaTime;
+
+	const float* RESTRICT GZ = GroundZ.GetData();
+	const float* RESTRICT NX = NormalX.GetData();
+	const float* RESTRICT NY = NormalY.GetData();
+	const float* RESTRICT NZ = NormalZ.GetData();
+	float* RESTRICT PX = PosX.GetData();
+	float* RESTRICT PY = PosY.GetData();
+	float* RESTRICT PZ = PosZ.GetData();
+	float* RESTRICT VX = VelX.GetData();
+	float* RESTRICT VY = VelY.GetData();
+	float* RESTRICT VZ = VelZ.GetData();
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		VX[i] *= Damping;
+		VY[i] *= Damping;
+		VZ[i] = (VZ[i] + GravityStep) * Damping;
+
+		// Horizontal clamp, vertical untouched
+		const float HorizontalSq = VX[i] * VX[i] + VY[i] * VY[i];
+		const float Clamp = HorizontalSq > MaxSpeed * MaxSpeed ? MaxSpeed * FMath::InvSqrt(HorizontalSq) : 1.f;
+		VX[i] *= Clamp;
+		VY[i] *= Clamp;
+
+		PX[i] += VX[i] * DeltaTime;
+		PY[i] += VY[i] * DeltaTime;
+		PZ[i] += VZ[i] * DeltaTime;
+
+		// Resting contact: push out along Z, remove velocity into the surface
+		const float Floor = GZ[i] + Radius / FMath::Max(NZ[i], 0.1f);
+		const bool bPenetrating = PZ[i] < Floor;
+		PZ[i] = bPenetrating ? Floor : PZ[i];
+
+		const float IntoSurface = FMath::Min(VX[i] * NX[i] + VY[i] * NY[i] + VZ[i] * NZ[i], 0.f);
+		const float Remove = bPenetrating ? IntoSurface : 0.f;
+		VX[i] -= NX[i] * Remove;
+		VY[i] -= NY[i] * Remove;
+		VZ[i] -= NZ[i] * Remove;
+	}
+}
+
+void FOMRBallCrowd::SyncAngularVelocityWithLinear(float DeltaTime)
+{
+	const int32 Count = Num();
+	const float InvRadius = 1.f / FMath::Max(Tuning.Ball.Radius, KINDA_SMALL_NUMBER);
+	const float InterpAlpha = FMath::Clamp(DeltaTime * Tuning.Ball.AngularVelocityInterpSpeed, 0.f, 1.f);
+
+	const float* RESTRICT Stable = Grounded.GetData();
+	const float* RESTRICT NX = NormalX.GetData();
+	const float* RESTRICT NY = NormalY.GetData();
+	const float* RESTRICT NZ = NormalZ.GetData();
+	const float* RESTRICT VX = VelX.GetData();
+	const float* RESTRICT VY = VelY.GetData();
+	const float* RESTRICT VZ = VelZ.GetData();
+	float* RESTRICT WX = AngX.GetData();
+	float* RESTRICT WY = AngY.GetData();
+	float* RESTRICT WZ = AngZ.GetData();
+
+	for (int32 i = 0; i < Count; ++i)
+	{
+		// Rolling axis = velocity x normal, |axis| * |v| / r = w
+		const float AxisX = VY[i] * NZ[i] - VZ[i] * NY[i];
+		const float AxisY = VZ[i] * NX[i] - VX[i] * NZ[i];
+		const float AxisZ = VX[i] * NY[i] - VY[i] * NX[i];
+
+		const float SpeedSq = VX[i] * VX[i] + VY[i] * VY[i] + VZ[i] * VZ[i];
+		const float AxisSq = AxisX * AxisX + AxisY * AxisY + AxisZ * AxisZ;
+
+		const bool bApply = Stable[i] > 0.f && SpeedSq >= 10.f && AxisSq > UE_SMALL_NUMBER;
+		const float Scale = bApply ? FMath::Sqrt(SpeedSq) * InvRadius * FMath::InvSqrt(AxisSq) : 0.f;
+		const float Alpha = bApply ? InterpAlpha : 0.f;
+
+		WX[i] += (AxisX * Scale - WX[i]) * Alpha;
+		WY[i] += (AxisY * Scale - WY[i]) * Alpha;
+		WZ[i] += (AxisZ * Scale - WZ[i]) * Alpha;
+	}
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OMRBallMovementModel.h"
+
+class FOMRTrackSurfaceField;
+
+/**
+ * Headless simulation of many balls in structure-of-arrays form.
+ * Same force, clamp, slope and rolling rules as FOMRBallMovementModel, but each stage is one
+ * branch-free loop over contiguous float arrays so the compiler can vectorize it.
+ * Bots steer with a world-space direction instead of a camera basis.
+ */
+class ONEMORERUN_API FOMRBallCrowd
+{
+public:
+	struct FTuning
+	{
+		FOMRBallTuning Ball;
+
+		float Mass = 500.f;
+		float GravityZ = -980.f;
+		float LinearDamping = 0.15f;
+
+		float CoyoteTimeDuration = 0.08f;
+		float GroundConfirmDuration = 0.03f;
+
+		// Flat ground used where no surface field is loaded
+		float FallbackGroundZ = 0.f;
+	};
+
+	FTuning Tuning;
+
+	void Reset(int32 Capacity);
+
+	int32 Add(const FVector& Location, const FVector& Velocity = FVector::ZeroVector);
+	int32 Num() const { return PosX.Num(); }
+
+	// World-space steering intent, length <= 1
+	void SetInput(int32 Index, float DirX, float DirY);
+
+	void Step(float DeltaTime, const FOMRTrackSurfaceField* Field);
+
+	FVector GetLocation(int32 Index) const { return FVector(PosX[Index], PosY[Index], PosZ[Index]); }
+	FVector GetVelocity(int32 Index) const { return FVector(VelX[Index], VelY[Index], VelZ[Index]); }
+	FVector GetAngularVelocity(int32 Index) const { return FVector(AngX[Index], AngY[Index], AngZ[Index]); }
+	bool IsGrounded(int32 Index) const { return Grounded[Index] > 0.f; }
+
+private:
+	// Scalar: one surface lookup per ball
+	void UpdateGround(const FOMRTrackSurfaceField* Field);
+
+	// Vectorizable passes
+	void UpdateGroundedTimers(float DeltaTime);
+	void ApplyMovementForce(float DeltaTime);
+	void Integrate(float DeltaTime);
+	void SyncAngularVelocityWithLinear(float DeltaTime);
+
+	TArray<float> PosX, PosY, PosZ;
+	TArray<float> VelX, VelY, VelZ;
+	TArray<float> AngX, AngY, AngZ;
+
+	TArray<float> InputX, InputY;
+	TArray<float> SmoothX, SmoothY, SmoothZ;
+
+	// Ground under each ball, refreshed by UpdateGround
+	TArray<float> GroundZ;
+	TArray<float> NormalX, NormalY, NormalZ;
+	TArray<float> RawGrounded;
+
+	// Coyote/confirm stabilizer, 1.f = grounded
+	TArray<float> Grounded;
+	TArray<float> CoyoteTime;
+	TArray<float> ConfirmTime;
+};
@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRBallMovementModel.h"
+
+void FOMRBallMovementModel::Step(const FOMRBallInput& Input, FOMRBallState& State, float DeltaTime) const
+{
+	State.Force = ComputeMovementForce(Input, State, DeltaTime);
+
+	State.bVelocityClamped = ClampVelocity(State.Velocity);
+
+	State.bAngularVelocityChanged = SyncAngularVelocityWithLinear(
+		Input,
+		State.Velocity,
+		State.AngularVelocity,
+		DeltaTime
+	);
+}
+
+FVector FOMRBallMovementModel::GetMovementInputVector(const FOMRBallInput& Input, const FVector& GroundNormal)
+{
+	// Flatten camera basis onto ground plane
+	const FVector CamForward = FVector::VectorPlaneProject(Input.CameraForward, GroundNormal).GetSafeNormal();
+	const FVector CamRight = FVector::VectorPlaneProject(Input.CameraRight, GroundNormal).GetSafeNormal();
+
+	const FVector InputDir =
+		(CamForward * Input.MoveForwardValue) +
+		(CamRight * Input.MoveRightValue);
+
+	return InputDir.IsNearlyZero() ? FVector::ZeroVector : InputDir.GetSafeNormal();
+}
+
+FVector FOMRBallMovementModel::ComputeMovementForce(const FOMRBallInput& Input, FOMRBallState& State, float DeltaTime) const
+{
+	const FVector GroundNormal = Input.bGrounded
+		? Input.GroundNormal.GetSafeNormal()
+		: FVector::UpVector;
+
+	FVector InputDir = GetMovementInputVector(Input, GroundNormal);
+
+	// Smooth INPUT intent only (not camera direction)
+	State.SmoothedInputDir = FMath::VInterpTo(
+		State.SmoothedInputDir,
+		InputDir,
+		DeltaTime,
+		Tuning.InputDirInterpSpeed
+	);
+
+	// Kill micro drift
+	if (State.SmoothedInputDir.SizeSquared() < 0.001f)
+	{
+		State.SmoothedInputDir = FVector::ZeroVector;
+	}
+
+	InputDir = State.SmoothedInputDir;
+
+	if (InputDir.IsZero()) return FVector::ZeroVector;
+
+	const FVector& Velocity = State.Velocity;
+	const float Speed = Velocity.Size();
+
+	// Speed-based ramp (prevents snap accel)
+	const float SpeedAlpha = FMath::Clamp(Speed / Tuning.MaxSpeed, 0.f, 1.f);
+	if (Speed >= Tuning.MaxSpeed && FVector::DotProduct(Velocity, InputDir) > 0.f) { return FVector::ZeroVector; }
+	const float ForceScale = FMath::Lerp(0.35f, 1.0f, SpeedAlpha);
+	const float SteeringReduction = 1.f - SpeedAlpha * 0.4f;
+	InputDir *= SteeringReduction;
+
+	// Landing damp (temporary force reduction)
+	const float LandingDamp = Input.bLandingDamp ? Tuning.LandingDampMultiplier : 1.0f;
+
+	if (Input.bGrounded)
+	{
+		// Project input onto the ground plane
+		InputDir = FVector::VectorPlaneProject(InputDir, GroundNormal).GetSafeNormal();
+
+		if (InputDir.IsNearlyZero())
+		{
+			return FVector::ZeroVector;
+		}
+
+		const float DownhillFactor =
+			FVector::DotProduct(GroundNormal, FVector::UpVector);
+
+		const float SlopeBoost =
+			FMath::Lerp(1.1f, 1.0f, DownhillFactor);
+
+		const float SlopeMultiplier =
+			GetSlopeForceMultiplier(GroundNormal) * SlopeBoost;
+
+		return InputDir *
+			Tuning.MoveForce *
+			SlopeMultiplier *
+			ForceScale *
+			LandingDamp;
+	}
+
+	// Air / fallback
+	return InputDir * Tuning.MoveForce * Tuning.AirControlMultiplier *
+		ForceScale * LandingDamp;
+}
+
+bool FOMRBallMovementModel::ClampVelocity(FVector& Velocity) const
+{
+	// Separate horizontal and vertical velocity
+	FVector HorizontalVel(Velocity.X, Velocity.Y, 0.f);
+	const float HorizontalSpeed = HorizontalVel.Size();
+
+	if (HorizontalSpeed <= Tuning.MaxSpeed)
+	{
+		return false;
+	}
+
+	HorizontalVel = HorizontalVel.GetSafeNormal() * Tuning.MaxSpeed;
+
+	// Recombine with ORIGINAL vertical velocity
+	Velocity.X = HorizontalVel.X;
+	Velocity.Y = HorizontalVel.Y;
+
+	return true;
+}
+
+float FOMRBallMovementModel::GetSlopeForceMultiplier(const FVector& GroundNormal)
+{
+	// Dot of Ground Normal vs World Up
+	const float SlopeDot = FVector::DotProduct(GroundNormal, FVector::UpVector);
+
+	// Designer tunable curve
+	// 0.0 = full force, 1.0 = no force
+	const float MinSlopeDot = 0.65f;
+	const float MaxSlopeDot = 0.95f;
+
+	return FMath::Clamp(
+		FMath::GetMappedRangeValueClamped(
+			FVector2D(MaxSlopeDot, MinSlopeDot),
+			FVector2D(1.0f, 0.1f),
+			SlopeDot
+		),
+		0.1f,
+		1.0f
+	);
+}
+
+bool FOMRBallMovementModel::SyncAngularVelocityWithLinear(const FOMRBallInput& Input, const FVector& Velocity, FVector& AngularVelocity, float DeltaTime) const
+{
+	if (!Input.bGrounded) return false;
+
+	const FVector GroundNormal = Input.GroundNormal.GetSafeNormal();
+
+	// Ignore tiny motion
+	if (Velocity.SizeSquared() < 10.f)
+	{
+		return false;
+	}
+
+	// Direction of travel along surface
+	const FVector VelocityDir = Velocity.GetSafeNormal();
+
+	// Rolling axis = perpendicular to velocity AND surface normal
+	FVector RotationAxis =
+		FVector::CrossProduct(VelocityDir, GroundNormal);
+
+	if (RotationAxis.IsNearlyZero())
+	{
+		return false;
+	}
+
+	RotationAxis.Normalize();
+
+	// ω = v / r
+	const float AngularSpeed = Velocity.Size() / Tuning.Radius;
+
+	const FVector TargetAngularVelocity =
+		RotationAxis * AngularSpeed;
+
+	AngularVelocity = FMath::VInterpTo(
+		AngularVelocity,
+		TargetAngularVelocity,
+		DeltaTime,
+		Tuning.AngularVelocityInterpSpeed
+	);
+
+	return true;
+}
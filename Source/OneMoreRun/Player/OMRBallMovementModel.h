@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Designer tuning for the rolling ball. Plain data so it can be copied to the
+ * physics thread every frame without touching the pawn.
+ */
+struct ONEMORERUN_API FOMRBallTuning
+{
+	float MoveForce = 300000.f;
+	float MaxSpeed = 1800.f;
+	float AirControlMultiplier = 0.25f;
+	float LandingDampMultiplier = 0.25f;
+	float InputDirInterpSpeed = 12.0f;
+	float AngularVelocityInterpSpeed = 15.0f;
+	float Radius = 50.f;
+};
+
+/**
+ * Everything the game thread knows that the model needs for one step.
+ * Camera basis is captured on the game thread since the camera is not a physics object.
+ */
+struct ONEMORERUN_API FOMRBallInput
+{
+	FVector CameraForward = FVector::ForwardVector;
+	FVector CameraRight = FVector::RightVector;
+
+	float MoveForwardValue = 0.f;
+	float MoveRightValue = 0.f;
+
+	bool bGrounded = false;
+	FVector GroundNormal = FVector::UpVector;
+
+	bool bLandingDamp = false;
+};
+
+/**
+ * Per-ball simulation state. Velocity and AngularVelocity are read from and written
+ * back to the rigid body, SmoothedInputDir is owned by the model.
+ */
+struct ONEMORERUN_API FOMRBallState
+{
+	FVector Velocity = FVector::ZeroVector;
+	FVector AngularVelocity = FVector::ZeroVector;
+	FVector SmoothedInputDir = FVector::ZeroVector;
+
+	// Outputs of the last step
+	FVector Force = FVector::ZeroVector;
+	bool bVelocityClamped = false;
+	bool bAngularVelocityChanged = false;
+};
+
+/**
+ * Frame-rate independent movement model for the ball:
+ * input force, horizontal speed clamp and rolling angular velocity.
+ * Runs on whichever thread owns the body (physics thread when async physics is on).
+ */
+struct ONEMORERUN_API FOMRBallMovementModel
+{
+	FOMRBallTuning Tuning;
+
+	// Advances one fixed step. Fills State.Force and updates velocities in place.
+	void Step(const FOMRBallInput& Input, FOMRBallState& State, float DeltaTime) const;
+
+	FVector ComputeMovementForce(const FOMRBallInput& Input, FOMRBallState& State, float DeltaTime) const;
+	bool ClampVelocity(FVector& Velocity) const;
+	bool SyncAngularVelocityWithLinear(const FOMRBallInput& Input, const FVector& Velocity, FVector& AngularVelocity, float DeltaTime) const;
+
+	static FVector GetMovementInputVector(const FOMRBallInput& Input, const FVector& GroundNormal);
+	static float GetSlopeForceMultiplier(const FVector& GroundNormal);
+};
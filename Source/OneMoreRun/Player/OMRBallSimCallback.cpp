@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRBallSimCallback.h"
+#include "../OneMoreRun.h"
+#include "PhysicsProxy/SingleParticlePhysicsProxy.h"
+
+FName FOMRBallSimCallback::GetFNameForStatId() const
+{
+	const static FLazyName StaticName("FOMRBallSimCallback");
+	return StaticName;
+}
+
+void FOMRBallSimCallback::OnPreSimulate_Internal()
+{
+	if (const FOMRBallSimInput* NewInput = GetConsumerInput_Internal())
+	{
+		Proxy = NewInput->Proxy;
+		Model.Tuning = NewInput->Tuning;
+		LastInput = NewInput->Input;
+		TeleportGeneration = NewInput->TeleportGeneration;
+
+		if (NewInput->bResetState)
+		{
+			State = FOMRBallState();
+			State.SmoothedInputDir = NewInput->ResetSmoothedInputDir;
+		}
+	}
+
+	if (!Proxy) return;
+
+	Chaos::FRigidBodyHandle_Internal* Handle = Proxy->GetPhysicsThreadAPI();
+	if (!Handle) return;
+
+	// Frozen (countdown) or kinematic bodies are left alone
+	if (Handle->ObjectState() != Chaos::EObjectStateType::Dynamic &&
+		Handle->ObjectState() != Chaos::EObjectStateType::Sleeping)
+	{
+		return;
+	}
+
+	const float DeltaTime = GetDeltaTime_Internal();
+	if (DeltaTime <= 0.f) return;
+
+	State.Velocity = Handle->V();
+	State.AngularVelocity = Handle->W();
+
+	Model.Step(LastInput, State, DeltaTime);
+
+	if (!State.Force.IsZero())
+	{
+		if (Handle->ObjectState() == Chaos::EObjectStateType::Sleeping)
+		{
+			Handle->SetObjectState(Chaos::EObjectStateType::Dynamic);
+		}
+
+		Handle->AddForce(State.Force);
+		INC_DWORD_STAT(STAT_OMR_ForcesApplied);
+	}
+
+	if (State.bVelocityClamped)
+	{
+		Handle->SetV(State.Velocity);
+	}
+
+	if (State.bAngularVelocityChanged)
+	{
+		Handle->SetW(State.AngularVelocity);
+	}
+
+	if (FOMRBallSimOutput* Output = GetProducerOutputData_Internal())
+	{
+		Output->State = State;
+		Output->Position = Handle->X();
+		Output->SimTime = GetSimTime_Internal();
+		Output->DeltaTime = DeltaTime;
+		Output->TeleportGeneration = TeleportGeneration;
+	}
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Chaos/SimCallbackObject.h"
+#include "Chaos/SimCallbackInput.h"
+#include "OMRBallMovementModel.h"
+
+namespace Chaos
+{
+	class FSingleParticlePhysicsProxy;
+}
+
+// Posted by the game thread once per frame, consumed by every physics step until replaced
+struct FOMRBallSimInput : public Chaos::FSimCallbackInput
+{
+	Chaos::FSingleParticlePhysicsProxy* Proxy = nullptr;
+
+	FOMRBallTuning Tuning;
+	FOMRBallInput Input;
+
+	// Clears model-owned state on the next step, input smoothing restarts from ResetSmoothedInputDir
+	bool bResetState = false;
+	FVector ResetSmoothedInputDir = FVector::ZeroVector;
+
+	// Bumped by every teleport, copied onto the outputs of the steps that consumed this input
+	uint32 TeleportGeneration = 0;
+
+	void Reset()
+	{
+		Proxy = nullptr;
+		Tuning = FOMRBallTuning();
+		Input = FOMRBallInput();
+		bResetState = false;
+		ResetSmoothedInputDir = FVector::ZeroVector;
+		TeleportGeneration = 0;
+	}
+};
+
+// Produced once per physics step, body values are sampled at the start of the step
+struct FOMRBallSimOutput : public Chaos::FSimCallbackOutput
+{
+	FOMRBallState State;
+
+	FVector Position = FVector::ZeroVector;
+	double SimTime = 0.0;
+	float DeltaTime = 0.f;
+
+	// Of the input this step ran with, older than the game thread's means before a teleport
+	uint32 TeleportGeneration = 0;
+
+	void Reset()
+	{
+		State = FOMRBallState();
+		Position = FVector::ZeroVector;
+		SimTime = 0.0;
+		DeltaTime = 0.f;
+		TeleportGeneration = 0;
+	}
+};
+
+/**
+ * Runs FOMRBallMovementModel inside the Chaos solver before every (sub)step,
+ * so handling is tied to the physics step rate instead of the game frame rate.
+ */
+class FOMRBallSimCallback : public Chaos::TSimCallbackObject<
+	FOMRBallSimInput,
+	FOMRBallSimOutput,
+	Chaos::ESimCallbackOptions::Presimulate>
+{
+public:
+	virtual FName GetFNameForStatId() const override;
+
+private:
+	virtual void OnPreSimulate_Internal() override;
+
+	// Physics-thread copies of the last input, reused on steps with no new input
+	Chaos::FSingleParticlePhysicsProxy* Proxy = nullptr;
+	FOMRBallMovementModel Model;
+	FOMRBallInput LastInput;
+	uint32 TeleportGeneration = 0;
+
+	FOMRBallState State;
+};
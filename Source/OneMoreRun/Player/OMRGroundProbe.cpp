@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRGroundProbe.h"
+#include "../OneMoreRun.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+void FOMRGroundProbe::Init(AActor* InOwner)
+{
+	Owner = InOwner;
+
+	QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(OMRGroundProbe), false, InOwner);
+
+	// Completion runs on the game thread at the start of the next world tick
+	TraceDelegate = FTraceDelegate::CreateWeakLambda(
+		InOwner,
+		[this](const FTraceHandle& Handle, FTraceDatum& Datum)
+		{
+			HandleTraceDone(Handle, Datum);
+		}
+	);
+
+	Reset();
+}
+
+void FOMRGroundProbe::Issue(UWorld* World, const FVector& Location, const FVector& Velocity, float Radius, float PredictTime)
+{
+	if (!World) return;
+
+	// Sweep from where we expect to be when the result is read
+	const FVector Start = Location + Velocity * PredictTime;
+	const FVector End = Start - FVector(0.f, 0.f, SweepDistance);
+
+	INC_DWORD_STAT(STAT_OMR_GroundSweeps);
+
+	PendingOrigin = Start;
+	PendingHandle = World->AsyncSweepByChannel(
+		EAsyncTraceType::Single,
+		Start,
+		End,
+		FQuat::Identity,
+		ECC_WorldStatic,
+		FCollisionShape::MakeSphere(Radius * RadiusScale),
+		QueryParams,
+		FCollisionResponseParams::DefaultResponseParam,
+		&TraceDelegate
+	);
+}
+
+void FOMRGroundProbe::HandleTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	if (Handle != PendingHandle) return;
+
+	PendingHandle.Invalidate();
+
+	bHasResult = true;
+	ResultOrigin = PendingOrigin;
+	bResultHit = false;
+
+	for (const FHitResult& Hit : Datum.OutHits)
+	{
+		if (Hit.bBlockingHit)
+		{
+			ResultHit = Hit;
+			bResultHit = true;
+			break;
+		}
+	}
+}
+
+bool FOMRGroundProbe::ConsumeResult(const FVector& Location, float MaxDrift, bool& bOutWalkable, FHitResult& OutHit)
+{
+	if (!bHasResult) return false;
+
+	bHasResult = false;
+
+	// Prediction missed (hop, impact, teleport), caller should sweep now
+	if (FVector::DistSquared(ResultOrigin, Location) > FMath::Square(MaxDrift))
+	{
+		return false;
+	}
+
+	bOutWalkable = bResultHit && IsWalkable(ResultHit);
+
+	if (bResultHit)
+	{
+		OutHit = ResultHit;
+	}
+
+	return true;
+}
+
+void FOMRGroundProbe::Reset()
+{
+	PendingHandle.Invalidate();
+	bHasResult = false;
+	bResultHit = false;
+}
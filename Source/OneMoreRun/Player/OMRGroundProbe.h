@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "CollisionQueryParams.h"
+#include "WorldCollision.h"
+
+class UWorld;
+class AActor;
+
+/**
+ * Pipelined ground sweep. Each frame the probe issues an AsyncSweepByChannel from where
+ * the ball is predicted to be next frame, and the next frame consumes that result
+ * instead of running a blocking sweep on the game thread.
+ */
+class ONEMORERUN_API FOMRGroundProbe
+{
+public:
+	// Shared with the synchronous sweep so both paths agree
+	static constexpr float SweepDistance = 70.f;
+	static constexpr float RadiusScale = 0.95f;
+	static constexpr float WalkableNormalZ = 0.55f;
+
+	static bool IsWalkable(const FHitResult& Hit) { return Hit.Normal.Z > WalkableNormalZ; }
+
+	void Init(AActor* InOwner);
+
+	// Queue next frame's sweep. PredictTime is how far ahead to extrapolate the origin.
+	void Issue(UWorld* World, const FVector& Location, const FVector& Velocity, float Radius, float PredictTime);
+
+	// True if a completed result exists whose origin is within MaxDrift of Location
+	bool ConsumeResult(const FVector& Location, float MaxDrift, bool& bOutWalkable, FHitResult& OutHit);
+
+	void Reset();
+
+	const FCollisionQueryParams& GetQueryParams() const { return QueryParams; }
+
+private:
+	void HandleTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	TWeakObjectPtr<AActor> Owner;
+	FCollisionQueryParams QueryParams;
+	FTraceDelegate TraceDelegate;
+
+	FTraceHandle PendingHandle;
+	FVector PendingOrigin = FVector::ZeroVector;
+
+	// Last completed sweep
+	bool bHasResult = false;
+	bool bResultHit = false;
+	FVector ResultOrigin = FVector::ZeroVector;
+	FHitResult ResultHit;
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRInputLog.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<FOMRRewindSnapshot>, "LapStart is written as raw bytes");
+
+void FOMRInputLog::Reset(int32 ReserveFrames)
+{
+	Frames.Reset(ReserveFrames);
+	Capacity = ReserveFrames;
+	bTruncated = false;
+	bHasLapStart = false;
+}
+
+void FOMRInputLog::BeginLap(const FOMRRewindSnapshot& InLapStart)
+{
+	Frames.Reset();
+	bTruncated = false;
+
+	LapStart = InLapStart;
+	bHasLapStart = true;
+}
+
+void FOMRInputLog::AddFrame(float DeltaTime, int8 MoveForward, int8 MoveRight, uint8 Flags)
+{
+	if (Frames.Num() >= Capacity)
+	{
+		bTruncated = true;
+		return;
+	}
+
+	FFrame& Frame = Frames.AddDefaulted_GetRef();
+	Frame.DeltaTime = (uint16)FMath::Clamp(FMath::RoundToInt(DeltaTime / DeltaTimeStep), 0, (int32)MAX_uint16);
+	Frame.MoveForward = MoveForward;
+	Frame.MoveRight = MoveRight;
+	Frame.Flags = Flags;
+}
+
+bool FOMRInputLog::Save(const FString& Filename, uint32 TrackId, uint32 TuningHash, int32 LapNumber, float LapTime, TConstArrayView<float> SplitTimes) const
+{
+	if (!bHasLapStart || bTruncated) return false;
+
+	FHeader Header;
+	Header.TrackId = TrackId;
+	Header.TuningHash = TuningHash;
+	Header.NumFrames = Frames.Num();
+	Header.LapNumber = LapNumber;
+	Header.LapTime = LapTime;
+	Header.NumSplits = SplitTimes.Num();
+
+	TArray<uint8> Bytes;
+	Bytes.Reserve(sizeof(FHeader) + sizeof(FOMRRewindSnapshot) + SplitTimes.Num() * sizeof(float) + Frames.Num() * sizeof(FFrame));
+	Bytes.Append(reinterpret_cast<const uint8*>(&Header), sizeof(FHeader));
+	Bytes.Append(reinterpret_cast<const uint8*>(&LapStart), sizeof(FOMRRewindSnapshot));
+	Bytes.Append(reinterpret_cast<const uint8*>(SplitTimes.GetData()), SplitTimes.Num() * sizeof(float));
+	Bytes.Append(reinterpret_cast<const uint8*>(Frames.GetData()), Frames.Num() * sizeof(FFrame));
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
+
+bool FOMRInputLog::Load(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename, FILEREAD_Silent)) return false;
+
+	if (Bytes.Num() < (int32)sizeof(FHeader)) return false;
+
+	FHeader Header;
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(FHeader));
+
+	const int64 ExpectedSize = sizeof(FHeader) + sizeof(FOMRRewindSnapshot) + (int64)Header.NumSplits * sizeof(float) + (int64)Header.NumFrames * sizeof(FFrame);
+
+	if (Header.Magic != Magic ||
+		Header.Version != Version ||
+		Header.NumSplits < 0 ||
+		Header.NumFrames < 0 ||
+		Bytes.Num() != ExpectedSize)
+	{
+		return false;
+	}
+
+	const uint8* Cursor = Bytes.GetData() + sizeof(FHeader);
+
+	FMemory::Memcpy(&LapStart, Cursor, sizeof(FOMRRewindSnapshot));
+	Cursor += sizeof(FOMRRewindSnapshot);
+
+	ClaimedSplitTimes.SetNumUninitialized(Header.NumSplits);
+	FMemory::Memcpy(ClaimedSplitTimes.GetData(), Cursor, Header.NumSplits * sizeof(float));
+	Cursor += Header.NumSplits * sizeof(float);
+
+	Frames.SetNumUninitialized(Header.NumFrames);
+	FMemory::Memcpy(Frames.GetData(), Cursor, Header.NumFrames * sizeof(FFrame));
+
+	bHasLapStart = true;
+	bTruncated = false;
+	Claim = Header;
+
+	return true;
+}
+
+FString FOMRInputLog::GetLogDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("LapLogs");
+}
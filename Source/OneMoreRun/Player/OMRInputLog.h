@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OMRRewindBuffer.h"
+
+/**
+ * Everything the player fed the pawn, one record per game frame, so a lap can be
+ * re-simulated frame for frame (see UOMRValidateLapsCommandlet).
+ *
+ * Each lap starts a new log from the pawn and lap clock at the gate crossing, so a saved
+ * log only holds its own lap. Frames go into storage sized once by Reset, a lap that runs
+ * past it is truncated and not saved.
+ *
+ * File layout (little endian, LapStart as laid out in memory by the same build):
+ *   FHeader | FOMRRewindSnapshot LapStart | float SplitTimes[NumSplits] | FFrame[NumFrames]
+ */
+class ONEMORERUN_API FOMRInputLog
+{
+public:
+	static constexpr uint32 Magic = 0x49524D4F; // 'OMRI'
+	static constexpr uint32 Version = 2;
+
+	// Frame time resolution, uint16 covers frames up to 0.65 s
+	static constexpr float DeltaTimeStep = 1e-5f;
+
+	enum EFrameFlags : uint8
+	{
+		Frame_Hop = 1 << 0,
+		Frame_ResetRun = 1 << 1,
+	};
+
+	struct FFrame
+	{
+		uint16 DeltaTime = 0;
+		int8 MoveForward = 0;
+		int8 MoveRight = 0;
+		uint8 Flags = 0;
+	};
+	static_assert(sizeof(FFrame) == 6, "FFrame is part of the file format");
+
+	// The run being claimed, written by Save
+	struct FHeader
+	{
+		uint32 Magic = FOMRInputLog::Magic;
+		uint32 Version = FOMRInputLog::Version;
+		uint32 TrackId = 0;
+		uint32 TuningHash = 0;
+		int32 NumFrames = 0;
+		int32 LapNumber = 0;
+		float LapTime = 0.f;
+		int32 NumSplits = 0;
+	};
+
+	// Recording, never allocates after Reset
+	void Reset(int32 ReserveFrames);
+	void AddFrame(float DeltaTime, int8 MoveForward, int8 MoveRight, uint8 Flags);
+
+	// Drops the frames so far, the log continues from LapStart
+	void BeginLap(const FOMRRewindSnapshot& InLapStart);
+
+	int32 Num() const { return Frames.Num(); }
+	const FFrame& GetFrame(int32 Index) const { return Frames[Index]; }
+
+	bool HasLapStart() const { return bHasLapStart; }
+	const FOMRRewindSnapshot& GetLapStart() const { return LapStart; }
+	bool IsTruncated() const { return bTruncated; }
+
+	static int8 QuantizeAxis(float Value) { return (int8)FMath::Clamp(FMath::RoundToInt(Value * 127.f), -127, 127); }
+	static float GetAxis(int8 Value) { return Value / 127.f; }
+	static float GetDeltaTime(const FFrame& Frame) { return Frame.DeltaTime * DeltaTimeStep; }
+
+	// Writes the lap start and the frames since together with the claimed lap. False
+	// without a lap start or when truncated
+	bool Save(const FString& Filename, uint32 TrackId, uint32 TuningHash, int32 LapNumber, float LapTime, TConstArrayView<float> SplitTimes) const;
+	bool Load(const FString& Filename);
+
+	// Valid after Load
+	const FHeader& GetClaim() const { return Claim; }
+	const TArray<float>& GetClaimedSplitTimes() const { return ClaimedSplitTimes; }
+
+	// Saved/LapLogs
+	static FString GetLogDirectory();
+
+private:
+	TArray<FFrame> Frames;
+	int32 Capacity = 0;
+	bool bTruncated = false;
+
+	FOMRRewindSnapshot LapStart;
+	bool bHasLapStart = false;
+
+	FHeader Claim;
+	TArray<float> ClaimedSplitTimes;
+};
@@ -28,10 +28,17 @@ void AOMRPlayerController::BeginPlay()
     AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>();
     if (GS)
     {
-        GS->OnLapTimeUpdated.AddDynamic(this, &AOMRPlayerController::HandleLapTimeUpdated);
-        GS->OnBestTimeUpdated.AddDynamic(this, &AOMRPlayerController::HandleBestTimeUpdated);
-        GS->OnLapNumberUpdated.AddDynamic(this, &AOMRPlayerController::HandleLapNumberUpdated);
+        // A pulling HUD reads the continuous values itself, only events are relayed
+        if (!TimeTrialHUD || !TimeTrialHUD->PullsRaceState())
+        {
+            GS->OnLapTimeUpdated.AddDynamic(this, &AOMRPlayerController::HandleLapTimeUpdated);
+            GS->OnBestTimeUpdated.AddDynamic(this, &AOMRPlayerController::HandleBestTimeUpdated);
+            GS->OnLapNumberUpdated.AddDynamic(this, &AOMRPlayerController::HandleLapNumberUpdated);
+            GS->OnLiveDeltaUpdated.AddDynamic(this, &AOMRPlayerController::HandleLiveDeltaUpdated);
+        }
+
         GS->OnSplitUpdated.AddDynamic(this, &AOMRPlayerController::HandleSplitUpdated);
+        GS->OnRaceRestarted.AddDynamic(this, &AOMRPlayerController::HandleRaceRestarted);
     }
 }
 
@@ -54,11 +61,19 @@ void AOMRPlayerController::OnCountdownGo()
 
 }
 
+void AOMRPlayerController::WarmUpHud()
+{
+    if (TimeTrialHUD)
+    {
+        TimeTrialHUD->ForceLayoutPrepass();
+    }
+}
+
 void AOMRPlayerController::HandleLapTimeUpdated(float NewTime)
 {
     if (TimeTrialHUD)
     {
-        TimeTrialHUD->UpdateLapTime(NewTime);
+        TimeTrialHUD->ShowLapTime(NewTime);
     }
 }
 
@@ -66,7 +81,7 @@ void AOMRPlayerController::HandleBestTimeUpdated(float NewBestTime)
 {
     if (TimeTrialHUD)
     {
-        TimeTrialHUD->UpdateBestTime(NewBestTime);
+        TimeTrialHUD->ShowBestTime(NewBestTime);
     }
 }
 
@@ -86,4 +101,18 @@ void AOMRPlayerController::HandleSplitUpdated(float SplitTime, float SplitDelta,
     }
 }
 
+void AOMRPlayerController::HandleLiveDeltaUpdated(float LiveDelta, float PredictedLapTime)
+{
+    if (TimeTrialHUD)
+    {
+        TimeTrialHUD->UpdateLiveDelta(LiveDelta, PredictedLapTime);
+    }
+}
 
+void AOMRPlayerController::HandleRaceRestarted()
+{
+    if (TimeTrialHUD)
+    {
+        TimeTrialHUD->ResetForRaceRestart();
+    }
+}
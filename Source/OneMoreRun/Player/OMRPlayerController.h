@@ -25,6 +25,9 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void OnCountdownGo();
 
+	// Lays the HUD out once before it's needed, part of the countdown warm-up
+	void WarmUpHud();
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -45,4 +48,10 @@ protected:
 
 	UFUNCTION()
 	void HandleSplitUpdated(float SplitTime, float SplitDelta, bool bIsAhead);
+
+	UFUNCTION()
+	void HandleRaceRestarted();
+
+	UFUNCTION()
+	void HandleLiveDeltaUpdated(float LiveDelta, float PredictedLapTime);
 };
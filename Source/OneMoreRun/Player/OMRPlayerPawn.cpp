@@ -2,6 +2,7 @@
 
 
 #include "OMRPlayerPawn.h"
+#include "../OneMoreRun.h"
 
 #include "Components/SphereComponent.h"
 #include "Components/StaticMeshComponent.h"
@@ -9,15 +10,33 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Camera/CameraShakeBase.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "OMRPlayerController.h"
 #include "Components/AudioComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundBase.h"
+#include "OMRBallSimCallback.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
+#include "../Track/OMRTrackSurfaceSubsystem.h"
+#include "../Game/OMRTimeTrialGameState.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pawn Tick"), STAT_OMR_PawnTick, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn SyncActorToPhysics"), STAT_OMR_SyncActorToPhysics, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn UpdateCountdown"), STAT_OMR_UpdateCountdown, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn UpdateGroundedState"), STAT_OMR_UpdateGroundedState, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn UpdateCamera"), STAT_OMR_UpdateCamera, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn UpdateMovement"), STAT_OMR_UpdateMovement, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn UpdateLandingTimers"), STAT_OMR_UpdateLandingTimers, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn PlayBallAudio"), STAT_OMR_PlayBallAudio, STATGROUP_OMR);
+DECLARE_CYCLE_STAT(TEXT("Pawn HandleLanding"), STAT_OMR_HandleLanding, STATGROUP_OMR);
 
 AOMRPlayerPawn::AOMRPlayerPawn()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
 
 	// Root (non-physics)
 	SceneRoot = CreateDefaultSubobject<USceneComponent>(TEXT("SceneRoot"));
@@ -73,6 +92,19 @@ void AOMRPlayerPawn::BeginPlay()
 		}
 	}
 
+	GroundProbe.Init(this);
+
+	{
+		LLM_SCOPE_BYTAG(OMR_Gameplay);
+		InputLog.Reset(InputLogReserveFrames);
+
+		if (bEnableRewind)
+		{
+			RewindBuffer.Init(FMath::CeilToInt(RewindHistoryDuration / FMath::Max(RewindSnapshotInterval, 0.01f)));
+		}
+	}
+	TrackSurface = GetWorld()->GetSubsystem<UOMRTrackSurfaceSubsystem>();
+
 	if (BallPhysicalMaterial)
 	{
 		CollisionSphere->SetPhysMaterialOverride(BallPhysicalMaterial);
@@ -100,16 +132,117 @@ void AOMRPlayerPawn::BeginPlay()
 	CurrentCameraDistance = SpeedCameraMinDistance;
 
 	CurrentFOV = Camera ? Camera->FieldOfView : SpeedCameraFOVMin;
+
+	if (bSimulateMovementOnPhysicsThread)
+	{
+		RegisterBallSimCallback();
+	}
+}
+
+void AOMRPlayerPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterBallSimCallback();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AOMRPlayerPawn::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (!TickScheduler.HasTasks())
+		{
+			BuildTickTasks();
+		}
+
+		TickScheduler.Register(this);
+	}
+	else
+	{
+		TickScheduler.Unregister();
+	}
+}
+
+void AOMRPlayerPawn::BuildTickTasks()
+{
+	// Camera follows the ball after physics has moved it this frame
+	TickScheduler.AddTask(
+		TEXT("OMRPawnCamera"),
+		TG_PostPhysics,
+		[this](float DeltaTime) { UpdateCamera(DeltaTime); },
+		1,
+		0.f,
+		true
+	);
+
+	TickScheduler.AddTask(
+		TEXT("OMRPawnAudio"),
+		TG_PostPhysics,
+		[this](float DeltaTime) { PlayBallAudio(DeltaTime); },
+		1,
+		AudioUpdateRate
+	);
+
+	// Only has work during the first countdown
+	TickScheduler.AddTask(
+		TEXT("OMRPawnWarmup"),
+		TG_PostPhysics,
+		[this](float DeltaTime) { UpdateWarmup(); },
+		1,
+		0.f,
+		true
+	);
+
+	if (bEnableRewind)
+	{
+		TickScheduler.AddTask(
+			TEXT("OMRPawnRewind"),
+			TG_PostPhysics,
+			[this](float DeltaTime) { CaptureRewindSnapshot(); },
+			1,
+			1.f / FMath::Max(RewindSnapshotInterval, 0.01f)
+		);
+	}
 }
 
 void AOMRPlayerPawn::Tick(float DeltaTime)
 {
+	OMR_SCOPED_STAGE(STAT_OMR_PawnTick);
+	LLM_SCOPE_BYTAG(OMR_Gameplay);
+
 	Super::Tick(DeltaTime);
 
+	// Session replay places ball and camera itself
+	if (bShowingReplay) return;
+
+	RecordOrReplayInput(DeltaTime);
+
 	SyncActorToPhysics();
 
+	ConsumeBallSimOutput();
+
+	// Without the physics callback the path is one sample per frame
+	if (!BallSimCallback && !bCountdownActive && CollisionSphere)
+	{
+		AddBallPathSample(CollisionSphere->GetComponentLocation(), GetWorld()->GetTimeSeconds());
+	}
+
 	UpdateCountdown(DeltaTime);
 
+	TickScheduler.SetCountdownActive(bCountdownActive);
+
+	// Ball is frozen until GO, nothing below has work to do
+	if (bCountdownActive) return;
+
+	// Held in place on the scrubbed snapshot until released
+	if (bRewinding)
+	{
+		ScrubRewind(DeltaTime);
+		return;
+	}
+
 	UpdateGroundedState(DeltaTime);
 
 	if(!bWasGrounded && bIsGrounded)
@@ -118,13 +251,11 @@ void AOMRPlayerPawn::Tick(float DeltaTime)
 	}
 
 	bWasGrounded = bIsGrounded;
-	UpdateCamera(DeltaTime);
 
 	UpdateMovement(DeltaTime);
 
 	UpdateLandingTimers(DeltaTime);
 
-	PlayBallAudio();
 	HandleLanding();
 }
 
@@ -132,24 +263,18 @@ void AOMRPlayerPawn::ResetRun()
 {
 	if (!CollisionSphere) return;
 
-	// -------------------------------------------------
-	// 1. Stop physics completely
-	// -------------------------------------------------
-	CollisionSphere->SetPhysicsLinearVelocity(FVector::ZeroVector);
-	CollisionSphere->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+	if (!ReplayLog)
+	{
+		PendingInputFlags |= FOMRInputLog::Frame_ResetRun;
+	}
+
+	bRewinding = false;
+	RewindBuffer.Reset();
 
 	// -------------------------------------------------
-	// 2. Teleport physics body (authoritative)
+	// 1-2. Stop physics completely and teleport the body
 	// -------------------------------------------------
-	CollisionSphere->SetWorldTransform(
-		SpawnTransform,
-		false,
-		nullptr,
-		ETeleportType::TeleportPhysics
-	);
-
-	// Keep actor/root aligned
-	SetActorTransform(SpawnTransform);
+	TeleportBall(SpawnTransform, FVector::ZeroVector, FVector::ZeroVector);
 
 	// -------------------------------------------------
 	// 3. Reset camera vertical state
@@ -177,6 +302,10 @@ void AOMRPlayerPawn::ResetRun()
 
 	SmoothedCameraSpeed = 0.f;
 
+	// Input smoothing lives in the movement model
+	BallState = FOMRBallState();
+	ResetSmoothedInputDir = FVector::ZeroVector;
+
 	// -------------------------------------------------
 	// 5. Clear transient gameplay state
 	// -------------------------------------------------
@@ -185,8 +314,381 @@ void AOMRPlayerPawn::ResetRun()
 	TimeSinceUngrounded = 0.f;
 }
 
+void AOMRPlayerPawn::TeleportBall(const FTransform& Transform, const FVector& LinearVelocity, const FVector& AngularVelocity)
+{
+	// Steps already queued ran from the old position
+	BallTeleportGeneration++;
+
+	// Stop physics completely
+	CollisionSphere->SetPhysicsLinearVelocity(FVector::ZeroVector);
+	CollisionSphere->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+
+	// Teleport physics body (authoritative)
+	CollisionSphere->SetWorldTransform(
+		Transform,
+		false,
+		nullptr,
+		ETeleportType::TeleportPhysics
+	);
+
+	// Keep actor/root aligned
+	SetActorTransform(Transform);
+
+	if (!LinearVelocity.IsZero() || !AngularVelocity.IsZero())
+	{
+		CollisionSphere->SetPhysicsLinearVelocity(LinearVelocity);
+		CollisionSphere->SetPhysicsAngularVelocityInRadians(AngularVelocity);
+	}
+
+	// Pending probe was issued from the old position
+	GroundProbe.Reset();
+
+	// Never sweep timing lines across the teleport
+	BallPath.Reset();
+	bHasContactGround = false;
+
+	bResetBallSimState = true;
+}
+
+void AOMRPlayerPawn::BeginRewind()
+{
+	if (!bEnableRewind || ReplayLog || bCountdownActive || bRewinding || bShowingReplay || RewindBuffer.Num() == 0) return;
+
+	// Scrubbing stops at the lap boundary, the lap clock can't go back across the gate
+	const AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>();
+
+	RewindMaxAgo = 0;
+
+	if (GS)
+	{
+		while (RewindMaxAgo + 1 < RewindBuffer.Num())
+		{
+			const FOMRLapClock& Clock = RewindBuffer.Get(RewindMaxAgo + 1).LapClock;
+			if (Clock.Lap != GS->CurrentLap || Clock.bLapActive != GS->bLapActive) break;
+
+			++RewindMaxAgo;
+		}
+	}
+	else
+	{
+		RewindMaxAgo = RewindBuffer.Num() - 1;
+	}
+
+	bRewinding = true;
+	RewindCursor = 0.f;
+	MoveForwardValue = 0.f;
+	MoveRightValue = 0.f;
+
+	ApplyRewindSnapshot(RewindBuffer.Get(0), false);
+}
+
+void AOMRPlayerPawn::ScrubRewind(float DeltaTime)
+{
+	RewindCursor = FMath::Min(RewindCursor + DeltaTime * RewindScrubRate / FMath::Max(RewindSnapshotInterval, 0.01f), (float)RewindMaxAgo);
+
+	const int32 Ago = FMath::FloorToInt(RewindCursor);
+
+	// Re-applied every frame, physics would otherwise let the held ball drift
+	ApplyRewindSnapshot(RewindBuffer.Get(Ago), false);
+}
+
+void AOMRPlayerPawn::EndRewind()
+{
+	if (!bRewinding) return;
+
+	bRewinding = false;
+
+	const int32 Ago = FMath::FloorToInt(RewindCursor);
+
+	ApplyRewindSnapshot(RewindBuffer.Get(Ago), true);
+
+	// History after the resume point is gone, the newest snapshot is where play resumes
+	RewindBuffer.Truncate(Ago);
+}
+
+void AOMRPlayerPawn::CaptureRewindSnapshot()
+{
+	if (!RewindBuffer.IsInitialized() || bRewinding || bShowingReplay || bCountdownActive || !CollisionSphere) return;
+
+	FOMRRewindSnapshot& Snapshot = RewindBuffer.Add();
+
+	CaptureSnapshot(Snapshot);
+
+	if (const AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->CaptureLapClock(Snapshot.LapClock);
+	}
+}
+
+void AOMRPlayerPawn::CaptureSnapshot(FOMRRewindSnapshot& Snapshot) const
+{
+	if (!CollisionSphere) return;
+
+	const FTransform BallTransform = CollisionSphere->GetComponentTransform();
+
+	Snapshot.Location = FVector3f(BallTransform.GetLocation());
+	Snapshot.Rotation = FQuat4f(BallTransform.GetRotation());
+	Snapshot.LinearVelocity = FVector3f(ReadBallVelocity());
+	Snapshot.AngularVelocity = FVector3f(CollisionSphere->GetPhysicsAngularVelocityInRadians());
+	Snapshot.SmoothedInputDir = FVector3f(BallState.SmoothedInputDir);
+
+	Snapshot.GroundedCoyoteTime = GroundedCoyoteTime;
+	Snapshot.GroundedConfirmTime = GroundedConfirmTime;
+	Snapshot.PostImpactGraceTime = PostImpactGraceTime;
+	Snapshot.LandingDampTimeRemaining = LandingDampTimeRemaining;
+	Snapshot.LandingCameraLockTime = LandingCameraLockTime;
+	Snapshot.TimeSinceUngrounded = TimeSinceUngrounded;
+	Snapshot.bGroundedStable = bGroundedStable;
+	Snapshot.bWasGrounded = bWasGrounded;
+	Snapshot.bCanHop = bCanHop;
+
+	Snapshot.CameraRootLocation = CameraRoot ? FVector3f(CameraRoot->GetComponentLocation()) : FVector3f::ZeroVector;
+	Snapshot.SmoothedMoveDir = FVector3f(SmoothedMoveDir);
+	Snapshot.CameraVerticalAnchorZ = CameraVerticalAnchorZ;
+	Snapshot.SmoothedCameraZ = SmoothedCameraZ;
+	Snapshot.SmoothedCameraSpeed = SmoothedCameraSpeed;
+	Snapshot.CurrentCameraDistance = CurrentCameraDistance;
+	Snapshot.CurrentFOV = CurrentFOV;
+}
+
+void AOMRPlayerPawn::ApplyRewindSnapshot(const FOMRRewindSnapshot& Snapshot, bool bResume)
+{
+	// Held snapshots are shown at rest, the resumed one gets its velocity back
+	ApplySnapshot(Snapshot, bResume ? 1.f : 0.f);
+
+	if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->RestoreLapClock(Snapshot.LapClock);
+	}
+}
+
+void AOMRPlayerPawn::ApplySnapshot(const FOMRRewindSnapshot& Snapshot, float VelocityScale)
+{
+	if (!CollisionSphere) return;
+
+	TeleportBall(
+		FTransform(FQuat(Snapshot.Rotation), FVector(Snapshot.Location)),
+		FVector(Snapshot.LinearVelocity) * VelocityScale,
+		FVector(Snapshot.AngularVelocity) * VelocityScale);
+
+	BallState = FOMRBallState();
+	BallState.Velocity = FVector(Snapshot.LinearVelocity) * VelocityScale;
+	BallState.SmoothedInputDir = FVector(Snapshot.SmoothedInputDir);
+	ResetSmoothedInputDir = BallState.SmoothedInputDir;
+
+	GroundedCoyoteTime = Snapshot.GroundedCoyoteTime;
+	GroundedConfirmTime = Snapshot.GroundedConfirmTime;
+	PostImpactGraceTime = Snapshot.PostImpactGraceTime;
+	LandingDampTimeRemaining = Snapshot.LandingDampTimeRemaining;
+	LandingCameraLockTime = Snapshot.LandingCameraLockTime;
+	TimeSinceUngrounded = Snapshot.TimeSinceUngrounded;
+	bGroundedStable = Snapshot.bGroundedStable;
+	bIsGrounded = Snapshot.bGroundedStable;
+	bWasGrounded = Snapshot.bWasGrounded;
+	bCanHop = Snapshot.bCanHop;
+
+	if (CameraRoot)
+	{
+		CameraRoot->SetWorldLocation(FVector(Snapshot.CameraRootLocation));
+	}
+
+	SmoothedMoveDir = FVector(Snapshot.SmoothedMoveDir);
+	CameraVerticalAnchorZ = Snapshot.CameraVerticalAnchorZ;
+	SmoothedCameraZ = Snapshot.SmoothedCameraZ;
+	SmoothedCameraSpeed = Snapshot.SmoothedCameraSpeed;
+	CurrentCameraDistance = Snapshot.CurrentCameraDistance;
+	CurrentFOV = Snapshot.CurrentFOV;
+
+	if (Camera)
+	{
+		Camera->SetFieldOfView(CurrentFOV);
+	}
+}
+
+void AOMRPlayerPawn::CaptureReplayFrame(FOMRReplayFrame& OutFrame) const
+{
+	if (!CollisionSphere) return;
+
+	const FTransform BallTransform = CollisionSphere->GetComponentTransform();
+
+	OutFrame.BallLocation = BallTransform.GetLocation();
+	OutFrame.BallRotation = BallTransform.GetRotation();
+	OutFrame.BallVelocity = ReadBallVelocity();
+	OutFrame.bGrounded = bIsGrounded;
+
+	OutFrame.CameraLocation = CameraRoot ? CameraRoot->GetComponentLocation() : BallTransform.GetLocation();
+	OutFrame.CameraRotation = Camera ? Camera->GetComponentQuat() : FQuat::Identity;
+	OutFrame.SmoothedMoveDir = SmoothedMoveDir;
+	OutFrame.CameraDistance = CurrentCameraDistance;
+	OutFrame.FOV = CurrentFOV;
+
+	OutFrame.RollPitch = SmoothedPitch;
+	OutFrame.RollVolume = SmoothedVolume;
+}
+
+void AOMRPlayerPawn::BeginReplayView()
+{
+	if (bShowingReplay || !CollisionSphere) return;
+
+	bShowingReplay = true;
+	bRewinding = false;
+	MoveForwardValue = 0.f;
+	MoveRightValue = 0.f;
+
+	CollisionSphere->SetSimulatePhysics(false);
+	BallPath.Reset();
+}
+
+void AOMRPlayerPawn::ShowReplayFrame(const FOMRReplayFrame& Frame)
+{
+	if (!bShowingReplay || !CollisionSphere) return;
+
+	const FTransform BallTransform(Frame.BallRotation, Frame.BallLocation);
+
+	CollisionSphere->SetWorldTransform(BallTransform, false, nullptr, ETeleportType::TeleportPhysics);
+	SetActorTransform(BallTransform);
+
+	// Timing lines never see replayed movement
+	BallPath.Reset();
+
+	bIsGrounded = Frame.bGrounded;
+	SmoothedMoveDir = Frame.SmoothedMoveDir;
+	CurrentCameraDistance = Frame.CameraDistance;
+	CurrentFOV = Frame.FOV;
+
+	if (CameraRoot)
+	{
+		CameraRoot->SetWorldLocation(Frame.CameraLocation);
+	}
+
+	if (Camera)
+	{
+		Camera->SetWorldRotation(Frame.CameraRotation);
+		Camera->SetFieldOfView(CurrentFOV);
+	}
+
+	SmoothedPitch = Frame.RollPitch;
+	SmoothedVolume = Frame.RollVolume;
+
+	if (RollAudio)
+	{
+		RollAudio->SetPitchMultiplier(SmoothedPitch);
+		RollAudio->SetVolumeMultiplier(SmoothedVolume);
+	}
+}
+
+void AOMRPlayerPawn::EndReplayView()
+{
+	bShowingReplay = false;
+}
+
+void AOMRPlayerPawn::RequestRestartRace()
+{
+	if (ReplayLog) return;
+
+	if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->RestartRace();
+	}
+}
+
+void AOMRPlayerPawn::CaptureRaceStartSnapshot()
+{
+	RaceStartSnapshot.CameraRootTransform = CameraRoot ? CameraRoot->GetComponentTransform() : FTransform::Identity;
+	RaceStartSnapshot.CameraVerticalAnchorZ = CameraVerticalAnchorZ;
+	RaceStartSnapshot.SmoothedCameraZ = SmoothedCameraZ;
+	RaceStartSnapshot.SmoothedMoveDir = SmoothedMoveDir;
+	RaceStartSnapshot.CurrentCameraDistance = CurrentCameraDistance;
+	RaceStartSnapshot.CurrentFOV = CurrentFOV;
+	RaceStartSnapshot.SmoothedPitch = SmoothedPitch;
+	RaceStartSnapshot.SmoothedVolume = SmoothedVolume;
+
+	bHasRaceStartSnapshot = true;
+}
+
+void AOMRPlayerPawn::RestartRace()
+{
+	if (!CollisionSphere || ReplayLog) return;
+
+	// -------------------------------------------------
+	// 1. Ball back on the spawn, frozen until GO
+	// -------------------------------------------------
+	EndWarmup();
+	ResetRun();
+
+	CollisionSphere->SetSimulatePhysics(false);
+	CollisionSphere->SetPhysicsLinearVelocity(FVector::ZeroVector);
+	CollisionSphere->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+
+	// -------------------------------------------------
+	// 2. Countdown from the top
+	// -------------------------------------------------
+	CountdownTimeRemaining = CountdownDuration;
+	bCountdownActive = true;
+	LastBroadcastCountdown = -1;
+	GoDisplayTimeRemaining = 0.f;
+	bWasShowingGO = false;
+	TickScheduler.SetCountdownActive(true);
+
+	// -------------------------------------------------
+	// 3. Grounding state machine and input
+	// -------------------------------------------------
+	bIsGrounded = false;
+	bRawGrounded = false;
+	bGroundedStable = false;
+	bWasGrounded = true;
+	GroundedCoyoteTime = 0.f;
+	GroundedConfirmTime = 0.f;
+	PostImpactGraceTime = 0.f;
+	GroundingDisagreeFrames = 0;
+	CachedGroundHit = FHitResult();
+
+	bCanHop = true;
+	LastHopTime = -1.f;
+	MoveForwardValue = 0.f;
+	MoveRightValue = 0.f;
+
+	// Nothing before the first gate crossing is saved. Keeps the storage
+	InputLog.Reset(InputLogReserveFrames);
+	PendingInputFlags = 0;
+
+	// -------------------------------------------------
+	// 4. Camera and audio as they were on GO
+	// -------------------------------------------------
+	if (bHasRaceStartSnapshot)
+	{
+		if (CameraRoot)
+		{
+			CameraRoot->SetWorldTransform(RaceStartSnapshot.CameraRootTransform);
+		}
+
+		CameraVerticalAnchorZ = RaceStartSnapshot.CameraVerticalAnchorZ;
+		SmoothedCameraZ = RaceStartSnapshot.SmoothedCameraZ;
+		SmoothedMoveDir = RaceStartSnapshot.SmoothedMoveDir;
+		CurrentCameraDistance = RaceStartSnapshot.CurrentCameraDistance;
+		CurrentFOV = RaceStartSnapshot.CurrentFOV;
+		SmoothedPitch = RaceStartSnapshot.SmoothedPitch;
+		SmoothedVolume = RaceStartSnapshot.SmoothedVolume;
+
+		if (Camera)
+		{
+			Camera->SetFieldOfView(CurrentFOV);
+		}
+
+		if (RollAudio)
+		{
+			RollAudio->SetPitchMultiplier(SmoothedPitch);
+			RollAudio->SetVolumeMultiplier(SmoothedVolume);
+		}
+	}
+
+	AirAlpha = 0.f;
+}
+
 void AOMRPlayerPawn::UpdateCountdown(float DeltaTime)
 {
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateCountdown);
+
 	if (!bCountdownActive)
 		return;
 
@@ -199,6 +701,20 @@ void AOMRPlayerPawn::UpdateCountdown(float DeltaTime)
 		if (AOMRPlayerController* PC = Cast<AOMRPlayerController>(GetController()))
 		{
 			PC->OnCountdownGo();
+			INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		}
+
+		if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+		{
+			GS->AddReplayEvent(EOMRReplayEvent::CountdownGo);
+			GS->PostRaceEvent(FOMRRaceEvent::MakeCountdownTick(0));
+		}
+
+		EndWarmup();
+
+		if (!bHasRaceStartSnapshot)
+		{
+			CaptureRaceStartSnapshot();
 		}
 
 		StartRacePhysics();
@@ -214,8 +730,192 @@ void AOMRPlayerPawn::UpdateCountdown(float DeltaTime)
 		if (AOMRPlayerController* PC = Cast<AOMRPlayerController>(GetController()))
 		{
 			PC->OnCountdownChanged(CurrentCount);
+			INC_DWORD_STAT(STAT_OMR_Broadcasts);
+		}
+
+		if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+		{
+			GS->AddReplayEvent(EOMRReplayEvent::Countdown, CurrentCount);
+			GS->PostRaceEvent(FOMRRaceEvent::MakeCountdownTick(CurrentCount));
+		}
+	}
+}
+
+void AOMRPlayerPawn::UpdateWarmup()
+{
+	if (WarmupStage == EOMRWarmupStage::Done) return;
+
+	if (!bWarmUpDuringCountdown || !bCountdownActive || !CollisionSphere)
+	{
+		EndWarmup();
+		return;
+	}
+
+	// Stages evenly over the countdown, done with half a second to spare
+	const int32 NumStages = (int32)EOMRWarmupStage::Done;
+	const float Interval = FMath::Max(CountdownDuration - 0.5f, 0.f) / NumStages;
+	const float Elapsed = CountdownDuration - CountdownTimeRemaining;
+
+	// An awake ball goes back to sleep as soon as the solver has stepped it
+	if (bWarmupPhysicsAwake)
+	{
+		if (!bWarmupPhysicsStepped && ++WarmupPhysicsAwakeFrames < WarmupPhysicsMaxFrames) return;
+	}
+	else if (Elapsed < (int32)WarmupStage * Interval)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	RunWarmupStage(WarmupStage);
+
+	WarmupStageMs[(int32)WarmupStage] = (float)((FPlatformTime::Seconds() - StartTime) * 1000.0);
+	WarmupStage = (EOMRWarmupStage)((int32)WarmupStage + 1);
+
+	if (WarmupStage != EOMRWarmupStage::Done) return;
+
+	static const TCHAR* StageNames[] = { TEXT("ground queries"), TEXT("movement model"), TEXT("physics wake"),
+		TEXT("physics sleep"), TEXT("roll audio"), TEXT("landing sound"), TEXT("camera shake"), TEXT("HUD") };
+	static_assert(UE_ARRAY_COUNT(StageNames) == (int32)EOMRWarmupStage::Done, "One name per warm-up stage");
+
+	TStringBuilder<256> Report;
+	float TotalMs = 0.f;
+
+	for (int32 Stage = 0; Stage < NumStages; ++Stage)
+	{
+		Report.Appendf(TEXT("%s %.2f ms, "), StageNames[Stage], WarmupStageMs[Stage]);
+		TotalMs += WarmupStageMs[Stage];
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Countdown warm-up: %stotal %.2f ms."), Report.ToString(), TotalMs);
+
+	TRACE_BOOKMARK(TEXT("OMR Warm-up Done"));
+}
+
+void AOMRPlayerPawn::RunWarmupStage(EOMRWarmupStage Stage)
+{
+	switch (Stage)
+	{
+	case EOMRWarmupStage::GroundQueries:
+	{
+		// First blocking sweep and the baked surface lookup, results thrown away
+		FHitResult Hit;
+		GetGroundHit(Hit);
+
+		bool bWalkable = false;
+		GetSurfaceFieldHit(CollisionSphere->GetComponentLocation(), bWalkable, Hit);
+		break;
+	}
+
+	case EOMRWarmupStage::MovementModel:
+	{
+		// On a scratch state, the ball's own is untouched
+		FOMRBallMovementModel Model;
+		Model.Tuning = MakeBallTuning();
+
+		FOMRBallState Scratch;
+		Model.Step(MakeBallInput(), Scratch, 1.f / 60.f);
+		break;
+	}
+
+	case EOMRWarmupStage::PhysicsWake:
+		if (!bWarmUpPhysics) break;
+
+		WarmupBallTransform = CollisionSphere->GetComponentTransform();
+		bWarmupGravity = CollisionSphere->IsGravityEnabled();
+
+		CollisionSphere->SetEnableGravity(false);
+		CollisionSphere->SetSimulatePhysics(true);
+		CollisionSphere->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		CollisionSphere->SetPhysicsAngularVelocityInRadians(FVector::ZeroVector);
+
+		bWarmupPhysicsAwake = true;
+		bWarmupPhysicsStepped = false;
+		WarmupPhysicsAwakeFrames = 0;
+
+		// Sim outputs with the new generation were stepped after the wake, no input is posted
+		// during the countdown otherwise
+		BallTeleportGeneration++;
+
+		if (BallSimCallback)
+		{
+			if (FOMRBallSimInput* SimInput = BallSimCallback->GetProducerInputData_External())
+			{
+				SimInput->Proxy = CollisionSphere->GetBodyInstance()->GetPhysicsActorHandle();
+				SimInput->Tuning = MakeBallTuning();
+				SimInput->Input = FOMRBallInput();
+				SimInput->bResetState = true;
+				SimInput->ResetSmoothedInputDir = FVector::ZeroVector;
+				SimInput->TeleportGeneration = BallTeleportGeneration;
+			}
+		}
+		break;
+
+	case EOMRWarmupStage::PhysicsSleep:
+		if (!bWarmupPhysicsAwake) break;
+
+		bWarmupPhysicsAwake = false;
+
+		CollisionSphere->SetSimulatePhysics(false);
+		CollisionSphere->SetEnableGravity(bWarmupGravity);
+		TeleportBall(WarmupBallTransform, FVector::ZeroVector, FVector::ZeroVector);
+		break;
+
+	case EOMRWarmupStage::RollAudio:
+		if (!RollAudio) break;
+
+		if (RollAudio->Sound)
+		{
+			UGameplayStatics::PrimeSound(RollAudio->Sound);
+		}
+
+		if (!RollAudio->IsPlaying())
+		{
+			RollAudio->Play();
 		}
+		break;
+
+	case EOMRWarmupStage::LandingSound:
+		if (LandingSound)
+		{
+			UGameplayStatics::PrimeSound(LandingSound);
+		}
+		break;
+
+	case EOMRWarmupStage::CameraShake:
+	{
+		// Started too small to see and stopped at once, the instance goes to the shake pool
+		APlayerController* PC = Cast<APlayerController>(GetController());
+		if (!PC || !PC->PlayerCameraManager || !LandingShakeClass) break;
+
+		if (UCameraShakeBase* Shake = PC->PlayerCameraManager->StartCameraShake(LandingShakeClass, KINDA_SMALL_NUMBER))
+		{
+			PC->PlayerCameraManager->StopCameraShake(Shake, true);
+		}
+		break;
 	}
+
+	case EOMRWarmupStage::Hud:
+		if (AOMRPlayerController* PC = Cast<AOMRPlayerController>(GetController()))
+		{
+			PC->WarmUpHud();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void AOMRPlayerPawn::EndWarmup()
+{
+	if (bWarmupPhysicsAwake)
+	{
+		RunWarmupStage(EOMRWarmupStage::PhysicsSleep);
+	}
+
+	WarmupStage = EOMRWarmupStage::Done;
 }
 
 void AOMRPlayerPawn::SnapToGround()
@@ -227,15 +927,14 @@ void AOMRPlayerPawn::SnapToGround()
 
 	FHitResult Hit;
 
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
+	INC_DWORD_STAT(STAT_OMR_GroundSweeps);
 
 	bool bHit = GetWorld()->LineTraceSingleByChannel(
 		Hit,
 		Start,
 		End,
 		ECC_WorldStatic,
-		Params
+		GroundProbe.GetQueryParams()
 	);
 
 	if (bHit)
@@ -262,6 +961,17 @@ void AOMRPlayerPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 		EIC->BindAction(IA_MoveRight, ETriggerEvent::Completed, this, &AOMRPlayerPawn::MoveRight);
 
 		EIC->BindAction(IA_Hop, ETriggerEvent::Started, this, &AOMRPlayerPawn::Hop);
+
+		if (IA_Rewind)
+		{
+			EIC->BindAction(IA_Rewind, ETriggerEvent::Started, this, &AOMRPlayerPawn::BeginRewind);
+			EIC->BindAction(IA_Rewind, ETriggerEvent::Completed, this, &AOMRPlayerPawn::EndRewind);
+		}
+
+		if (IA_Restart)
+		{
+			EIC->BindAction(IA_Restart, ETriggerEvent::Started, this, &AOMRPlayerPawn::RequestRestartRace);
+		}
 	}
 
 }
@@ -280,8 +990,7 @@ void AOMRPlayerPawn::MoveRight(const FInputActionValue& Value)
 
 bool AOMRPlayerPawn::IsGrounded() const
 {
-	FHitResult Hit;
-	return GetGroundHit(Hit);
+	return bRawGrounded;
 }
 
 bool AOMRPlayerPawn::GetGroundHit(FHitResult& OutHit) const
@@ -289,303 +998,227 @@ bool AOMRPlayerPawn::GetGroundHit(FHitResult& OutHit) const
 	const FVector Start = CollisionSphere->GetComponentLocation();
 
 	// Sweep down a bit further than your old trace
-	const float SweepDistance = 70.f;
+	const float SweepDistance = FOMRGroundProbe::SweepDistance;
 
 	// Slightly smaller than actual radius to avoid snagging edges
-	const float Radius = CollisionSphere->GetScaledSphereRadius() * 0.95f;
+	const float Radius = CollisionSphere->GetScaledSphereRadius() * FOMRGroundProbe::RadiusScale;
 
 	const FVector End = Start - FVector(0.f, 0.f, SweepDistance);
 
-	FCollisionQueryParams Params;
-	Params.AddIgnoredActor(this);
-
-	FCollisionShape Shape = FCollisionShape::MakeSphere(Radius);
-
-	const bool bHit = GetWorld()->SweepSingleByChannel(
-		OutHit,
-		Start,
-		End,
-		FQuat::Identity,
-		ECC_WorldStatic, // IMPORTANT: don't use Visibility here
-		Shape,
-		Params
-	);
-
-	if (!bHit) return false;
-
-	// Filter: only accept walkable-ish surfaces
-	return OutHit.Normal.Z > 0.55f;
-}
-
-bool AOMRPlayerPawn::UpdateGroundedState(float DeltaTime)
-{
-	FHitResult Hit;
-	// -------------------------------------------------
-	// 1. Raw grounding check (sphere sweep)
-	// -------------------------------------------------
-	const bool bRawGrounded = GetGroundHit(Hit);
-
-	// -------------------------------------------------
-	// 2. Stabilize grounded state (confirm + coyote)
-	// -------------------------------------------------
-	if (bRawGrounded)
-	{
-		CachedGroundHit = Hit;
-
-		// Build confidence that we are grounded
-		GroundedConfirmTime += DeltaTime;
-
-		// Reset coyote timer every grounded frame
-		GroundedCoyoteTime = CoyoteTimeDuration;
-
-		// Only switch to grounded after confirm duration
-		if (!bGroundedStable && GroundedConfirmTime >= GroundConfirmDuration)
-		{
-			bGroundedStable = true;
-		}
-	}
-	else
-	{
-		// Lost raw ground contact
-		GroundedConfirmTime = 0.f;
-
-		// Count down coyote time
-		GroundedCoyoteTime = FMath::Max(
-			GroundedCoyoteTime - DeltaTime,
-			0.f
-		);
-
-		// Only unground after coyote expires
-		if (bGroundedStable && GroundedCoyoteTime <= 0.f)
-		{
-			bGroundedStable = false;
-		}
-	}
-	bIsGrounded = bGroundedStable;
-
-	return bIsGrounded;
-
-}
-
-FVector AOMRPlayerPawn::GetMovementInputVector(const FVector& GroundNormal) const
-{
-	if (!Camera)
-	{
-		return FVector::ZeroVector;
-	}
-
-	// Camera basis
-	FVector CamForward = Camera->GetForwardVector();
-	FVector CamRight = Camera->GetRightVector();
+	FCollisionShape Shape = FCollisionShape::MakeSphere(Radius);
+
+	INC_DWORD_STAT(STAT_OMR_GroundSweeps);
 
-	// Flatten onto ground plane
-	CamForward = FVector::VectorPlaneProject(CamForward, GroundNormal).GetSafeNormal();
-	CamRight = FVector::VectorPlaneProject(CamRight, GroundNormal).GetSafeNormal();
+	const bool bHit = GetWorld()->SweepSingleByChannel(
+		OutHit,
+		Start,
+		End,
+		FQuat::Identity,
+		ECC_WorldStatic, // IMPORTANT: don't use Visibility here
+		Shape,
+		GroundProbe.GetQueryParams() // built once in BeginPlay, ignores this actor
+	);
 
-	FVector InputDir =
-		(CamForward * MoveForwardValue) +
-		(CamRight * MoveRightValue);
+	if (!bHit) return false;
 
-	return InputDir.IsNearlyZero() ? FVector::ZeroVector : InputDir.GetSafeNormal();
+	// Filter: only accept walkable-ish surfaces
+	return FOMRGroundProbe::IsWalkable(OutHit);
 }
 
-void AOMRPlayerPawn::ApplyMovementForce(float DeltaTime)
+bool AOMRPlayerPawn::GetSurfaceFieldHit(const FVector& Location, bool& bOutWalkable, FHitResult& OutHit) const
 {
-	if (!CollisionSphere) return;
+	if (!TrackSurface || !TrackSurface->HasField()) return false;
 
-	FVector GroundNormal = FVector::UpVector;
+	FOMRTrackSurfaceField::FSample Sample;
 
-	if (bIsGrounded && CachedGroundHit.IsValidBlockingHit())
+	switch (TrackSurface->Lookup(Location, Sample))
 	{
-		GroundNormal = CachedGroundHit.ImpactNormal;
+	case FOMRTrackSurfaceField::ELookup::Fallback:
+		return false;
+
+	case FOMRTrackSurfaceField::ELookup::Empty:
+		bOutWalkable = false;
+		return true;
+
+	default:
+		break;
 	}
-	GroundNormal = GroundNormal.GetSafeNormal();
 
-	FVector InputDir = GetMovementInputVector(GroundNormal);
+	// Below the baked top surface (tunnel, fell through): only a real query knows
+	if (Location.Z < Sample.Height) return false;
 
-	// Smooth INPUT intent only (not camera direction)
-	SmoothedInputDir = FMath::VInterpTo(
-		SmoothedInputDir,
-		InputDir,
-		GetWorld()->GetDeltaSeconds(),
-		InputDirInterpSpeed
-	);
+	// Vertical distance the shrunk sphere would travel before touching the surface plane
+	const float Radius = CollisionSphere->GetScaledSphereRadius() * FOMRGroundProbe::RadiusScale;
+	const float Gap = (Location.Z - Sample.Height) - Radius / FMath::Max(Sample.Normal.Z, 0.1f);
 
-	// Kill micro drift
-	if (SmoothedInputDir.SizeSquared() < 0.001f)
+	if (Gap > FOMRGroundProbe::SweepDistance)
 	{
-		SmoothedInputDir = FVector::ZeroVector;
+		bOutWalkable = false;
+		return true;
 	}
 
-	InputDir = SmoothedInputDir;
+	// Same shape of result the sweep would have produced
+	OutHit = FHitResult();
+	OutHit.bBlockingHit = true;
+	OutHit.Location = Location - FVector(0.f, 0.f, FMath::Max(Gap, 0.f));
+	OutHit.ImpactPoint = OutHit.Location - Sample.Normal * Radius;
+	OutHit.Normal = Sample.Normal;
+	OutHit.ImpactNormal = Sample.Normal;
 
-	if (InputDir.IsZero()) return;
-
-	const FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
-	const float Speed = Velocity.Size();
+	bOutWalkable = FOMRGroundProbe::IsWalkable(OutHit);
+	return true;
+}
 
-	// Speed-based ramp (prevents snap accel)
-	const float SpeedAlpha = FMath::Clamp(Speed / MaxSpeed, 0.f, 1.f);
-	if (Speed >= MaxSpeed && FVector::DotProduct(Velocity, InputDir) > 0.f) { return; }
-	const float ForceScale = FMath::Lerp(0.35f, 1.0f, SpeedAlpha);
-	const float SteeringReduction = 1.f - SpeedAlpha * 0.4f;
-	InputDir *= SteeringReduction;
+bool AOMRPlayerPawn::ConsumeContactGround(FHitResult& OutHit)
+{
+	const bool bWalkable = bHasContactGround;
 
-	// Landing damp (temporary force reduction)
-	float LandingDamp = 1.0f;
-	if (LandingDampTimeRemaining > 0.f)
+	if (bWalkable)
 	{
-		LandingDamp = LandingDampMultiplier; // e.g. 0.25
+		OutHit = ContactGroundHit;
 	}
 
-	float ControlMultiplier = bIsGrounded ? 1.0f : AirControlMultiplier;
+	bHasContactGround = false;
+	return bWalkable;
+}
 
-	if (bIsGrounded)
-	{
-		// Project input onto the ground plane
-		InputDir = FVector::VectorPlaneProject(InputDir, GroundNormal).GetSafeNormal();
+void AOMRPlayerPawn::CompareGroundingWithSweep(bool bProbeGrounded, const FHitResult& ProbeHit)
+{
+	FHitResult SweepHit;
+	const bool bSweepGrounded = GetGroundHit(SweepHit);
+
+	const bool bAgree =
+		bSweepGrounded == bProbeGrounded &&
+		(!bSweepGrounded || FVector::DotProduct(SweepHit.ImpactNormal, ProbeHit.ImpactNormal) > 0.98f);
 
-		if (InputDir.IsNearlyZero())
+	if (!bAgree)
+	{
+		if (GroundingDisagreeFrames++ == 0)
 		{
-			return;
+			UE_LOG(LogTemp, Warning, TEXT("Grounding %s disagrees with sweep at %s: probe %d (N %s) sweep %d (N %s)"),
+				*UEnum::GetValueAsString(GroundingMode),
+				*CollisionSphere->GetComponentLocation().ToCompactString(),
+				bProbeGrounded, *ProbeHit.ImpactNormal.ToCompactString(),
+				bSweepGrounded, *SweepHit.ImpactNormal.ToCompactString());
 		}
-
-		const float DownhillFactor =
-			FVector::DotProduct(GroundNormal, FVector::UpVector);
-
-		const float SlopeBoost =
-			FMath::Lerp(1.1f, 1.0f, DownhillFactor);
-
-		const float SlopeMultiplier =
-			GetSlopeForceMultiplier(GroundNormal) * SlopeBoost;
-		CollisionSphere->AddForce(
-			InputDir *
-			MoveForce *
-			SlopeMultiplier *
-			ForceScale *
-			LandingDamp
-		);
-
-		return; // grounded force applied
 	}
+	else if (GroundingDisagreeFrames > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Grounding %s agrees with sweep again after %d frames at %s"),
+			*UEnum::GetValueAsString(GroundingMode),
+			GroundingDisagreeFrames,
+			*CollisionSphere->GetComponentLocation().ToCompactString());
 
-	// Air / fallback
-	CollisionSphere->AddForce(
-		InputDir * MoveForce * ControlMultiplier *
-		ForceScale * LandingDamp
-	);
+		GroundingDisagreeFrames = 0;
+	}
 }
 
-void AOMRPlayerPawn::ClampVelocity()
+bool AOMRPlayerPawn::ProbeGround(float DeltaTime, FHitResult& OutHit)
 {
-	if (!CollisionSphere) return;
-
-	FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
-
-
-	// Separate horizontal and vertical velocity
-	FVector HorizontalVel(Velocity.X, Velocity.Y, 0.f);
-	const float HorizontalSpeed = HorizontalVel.Size();
-
-	if (HorizontalSpeed > MaxSpeed)
+	if (GroundingMode == EOMRGroundingMode::Contacts)
 	{
-		HorizontalVel = HorizontalVel.GetSafeNormal() * MaxSpeed;
+		return ConsumeContactGround(OutHit);
+	}
 
-		// Recombine with ORIGINAL vertical velocity
-		Velocity.X = HorizontalVel.X;
-		Velocity.Y = HorizontalVel.Y;
+	if (GroundingMode == EOMRGroundingMode::SurfaceField)
+	{
+		bool bWalkable = false;
+		if (GetSurfaceFieldHit(CollisionSphere->GetComponentLocation(), bWalkable, OutHit))
+		{
+			return bWalkable;
+		}
 
-		CollisionSphere->SetPhysicsLinearVelocity(Velocity);
+		return GetGroundHit(OutHit);
 	}
-}
 
-float AOMRPlayerPawn::GetSlopeForceMultiplier(const FVector& GroundNormal) const
-{
-	// Dot of Ground Normal vs World Up
-	const float SlopeDot = FVector::DotProduct(GroundNormal, FVector::UpVector);
+	if (GroundingMode != EOMRGroundingMode::AsyncProbe)
+	{
+		return GetGroundHit(OutHit);
+	}
 
-	// convert to slope steepness (0 =  flat, 1 = vertical)
-	const float Steepness = 1.0f - SlopeDot;
+	const FVector Location = CollisionSphere->GetComponentLocation();
 
-	// Designer tunable curve
-	// 0.0 = full force, 1.0 = no force
-	const float MinSlopeDot = 0.65f;
-	const float MaxSlopeDot = 0.95f;
+	// Last frame's sweep, or a blocking one if the prediction missed
+	bool bWalkable = false;
+	if (!GroundProbe.ConsumeResult(Location, GroundProbeMaxDrift, bWalkable, OutHit))
+	{
+		bWalkable = GetGroundHit(OutHit);
+	}
 
-	return FMath::Clamp(
-		FMath::GetMappedRangeValueClamped(
-			FVector2D(MaxSlopeDot, MinSlopeDot),
-			FVector2D(1.0f, 0.1f),
-			SlopeDot
-		),
-		0.1f,
-		1.0f
+	// Assume next frame is as long as this one
+	GroundProbe.Issue(
+		GetWorld(),
+		Location,
+		ReadBallVelocity(),
+		CollisionSphere->GetScaledSphereRadius(),
+		DeltaTime
 	);
+
+	return bWalkable;
 }
 
-void AOMRPlayerPawn::SyncAngularVelocityWithLinear()
+bool AOMRPlayerPawn::UpdateGroundedState(float DeltaTime)
 {
-	if (!CollisionSphere) return;
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateGroundedState);
 
-	if (!bIsGrounded) return;
-	
-	FVector GroundNormal = FVector::UpVector;
+	FHitResult Hit;
+	// -------------------------------------------------
+	// 1. Raw grounding check (sphere sweep, possibly from last frame)
+	// -------------------------------------------------
+	bRawGrounded = ProbeGround(DeltaTime, Hit);
 
-	if (CachedGroundHit.IsValidBlockingHit())
+	if (bCompareGroundingModes && GroundingMode != EOMRGroundingMode::Sweep)
 	{
-		GroundNormal = CachedGroundHit.ImpactNormal.GetSafeNormal();
+		CompareGroundingWithSweep(bRawGrounded, Hit);
 	}
-	const FVector LinearVelocity =
-		CollisionSphere->GetPhysicsLinearVelocity();
 
-	// Ignore tiny motion
-	if (LinearVelocity.SizeSquared() < 10.f)
+	// -------------------------------------------------
+	// 2. Stabilize grounded state (confirm + coyote)
+	// -------------------------------------------------
+	if (bRawGrounded)
 	{
-		return;
-	}
-
-	const float Radius = CollisionSphere->GetScaledSphereRadius();
+		CachedGroundHit = Hit;
 
-	// Direction of travel along surface
-	const FVector VelocityDir = LinearVelocity.GetSafeNormal();
+		// Build confidence that we are grounded
+		GroundedConfirmTime += DeltaTime;
 
-	// Rolling axis = perpendicular to velocity AND surface normal
-	FVector RotationAxis =
-		FVector::CrossProduct(VelocityDir, GroundNormal);
+		// Reset coyote timer every grounded frame
+		GroundedCoyoteTime = CoyoteTimeDuration;
 
-	if (RotationAxis.IsNearlyZero())
-	{
-		return;
+		// Only switch to grounded after confirm duration
+		if (!bGroundedStable && GroundedConfirmTime >= GroundConfirmDuration)
+		{
+			bGroundedStable = true;
+		}
 	}
+	else
+	{
+		// Lost raw ground contact
+		GroundedConfirmTime = 0.f;
 
-	RotationAxis.Normalize();
-
-	// ω = v / r
-	const float AngularSpeed = LinearVelocity.Size() / Radius;
-
-	const FVector TargetAngularVelocity =
-		RotationAxis * AngularSpeed;
+		// Count down coyote time
+		GroundedCoyoteTime = FMath::Max(
+			GroundedCoyoteTime - DeltaTime,
+			0.f
+		);
 
-	const FVector CurrentAngularVelocity =
-		CollisionSphere->GetPhysicsAngularVelocityInRadians();
+		// Only unground after coyote expires
+		if (bGroundedStable && GroundedCoyoteTime <= 0.f)
+		{
+			bGroundedStable = false;
+		}
+	}
+	bIsGrounded = bGroundedStable;
 
-	const FVector NewAngularVelocity =
-		FMath::VInterpTo(
-			CurrentAngularVelocity,
-			TargetAngularVelocity,
-			GetWorld()->GetDeltaSeconds(),
-			15.f
-		);
+	return bIsGrounded;
 
-	CollisionSphere->SetPhysicsAngularVelocityInRadians(
-		NewAngularVelocity,
-		false // DO NOT add to existing
-	);
 }
 
 void AOMRPlayerPawn::UpdateCamera(float DeltaTime)
 {
-	if (!CollisionSphere || !CameraRoot || !Camera) return;
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateCamera);
+
+	if (!CollisionSphere || !CameraRoot || !Camera || bShowingReplay) return;
 
 	if (bIsGrounded)
 	{
@@ -615,7 +1248,7 @@ void AOMRPlayerPawn::UpdateCamera(float DeltaTime)
 		GroundNormal = CachedGroundHit.ImpactNormal.GetSafeNormal();
 	}
 
-	const FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
+	const FVector Velocity = ReadBallVelocity();
 	const FVector HorizontalVel(Velocity.X, Velocity.Y, 0.f);
 	const float RawSpeed = HorizontalVel.Size();
 
@@ -835,8 +1468,100 @@ void AOMRPlayerPawn::UpdateCamera(float DeltaTime)
 		Camera->SetFieldOfView(CurrentFOV);
 }
 
+FVector AOMRPlayerPawn::ReadBallVelocity() const
+{
+	INC_DWORD_STAT(STAT_OMR_BodyStateReads);
+	return CollisionSphere->GetPhysicsLinearVelocity();
+}
+
+FTransform AOMRPlayerPawn::GetBallTransform() const
+{
+	return CollisionSphere ? CollisionSphere->GetComponentTransform() : GetActorTransform();
+}
+
+void AOMRPlayerPawn::StartInputReplay(const FOMRInputLog* Log)
+{
+	ReplayLog = Log;
+	ReplayFrame = 0;
+	bReplayDiverged = false;
+
+	MoveForwardValue = 0.f;
+	MoveRightValue = 0.f;
+
+	if (!Log || !Log->HasLapStart() || !CollisionSphere) return;
+
+	// Straight to the gate crossing the log starts at, no countdown
+	EndWarmup();
+	bCountdownActive = false;
+	TickScheduler.SetCountdownActive(false);
+	CollisionSphere->SetSimulatePhysics(true);
+
+	ApplySnapshot(Log->GetLapStart(), 1.f);
+
+	if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+	{
+		GS->StartReplayedLap(Log->GetLapStart().LapClock);
+	}
+}
+
+void AOMRPlayerPawn::BeginLapInputLog(const FOMRRewindSnapshot& LapStart)
+{
+	if (ReplayLog) return;
+
+	InputLog.BeginLap(LapStart);
+}
+
+void AOMRPlayerPawn::RecordOrReplayInput(float DeltaTime)
+{
+	if (ReplayLog)
+	{
+		if (ReplayFrame >= ReplayLog->Num())
+		{
+			MoveForwardValue = 0.f;
+			MoveRightValue = 0.f;
+			return;
+		}
+
+		const FOMRInputLog::FFrame& Frame = ReplayLog->GetFrame(ReplayFrame++);
+
+		MoveForwardValue = FOMRInputLog::GetAxis(Frame.MoveForward);
+		MoveRightValue = FOMRInputLog::GetAxis(Frame.MoveRight);
+
+		// Same order as live play: input callbacks run before the pawn ticks
+		if (Frame.Flags & FOMRInputLog::Frame_ResetRun)
+		{
+			ResetRun();
+		}
+
+		if (Frame.Flags & FOMRInputLog::Frame_Hop)
+		{
+			Hop();
+		}
+
+		return;
+	}
+
+	const int8 Forward = FOMRInputLog::QuantizeAxis(MoveForwardValue);
+	const int8 Right = FOMRInputLog::QuantizeAxis(MoveRightValue);
+
+	// Play on exactly the values a replay will see
+	MoveForwardValue = FOMRInputLog::GetAxis(Forward);
+	MoveRightValue = FOMRInputLog::GetAxis(Right);
+
+	InputLog.AddFrame(DeltaTime, Forward, Right, PendingInputFlags);
+	PendingInputFlags = 0;
+}
+
+uint32 AOMRPlayerPawn::GetTuningHash() const
+{
+	const FOMRBallTuning Tuning = MakeBallTuning();
+	return FCrc::MemCrc32(&HopImpulse, sizeof(HopImpulse), FCrc::MemCrc32(&Tuning, sizeof(Tuning)));
+}
+
 void AOMRPlayerPawn::SyncActorToPhysics()
 {
+	OMR_SCOPED_STAGE(STAT_OMR_SyncActorToPhysics);
+
 	if (!CollisionSphere) return;
 	SetActorLocation(CollisionSphere->GetComponentLocation());
 }
@@ -860,15 +1585,198 @@ void AOMRPlayerPawn::StartRacePhysics()
 
 void AOMRPlayerPawn::UpdateMovement(float DeltaTime)
 {
-	ApplyMovementForce(DeltaTime);
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateMovement);
+
+	if (!CollisionSphere) return;
+
+	const FOMRBallInput Input = MakeBallInput();
+
+	if (!BallSimCallback)
+	{
+		StepMovementOnGameThread(Input, DeltaTime);
+		return;
+	}
+
+	// Physics thread owns the body; just hand over this frame's intent
+	if (FOMRBallSimInput* SimInput = BallSimCallback->GetProducerInputData_External())
+	{
+		SimInput->Proxy = CollisionSphere->GetBodyInstance()->GetPhysicsActorHandle();
+		SimInput->Tuning = MakeBallTuning();
+		SimInput->Input = Input;
+		SimInput->bResetState = bResetBallSimState;
+		SimInput->ResetSmoothedInputDir = ResetSmoothedInputDir;
+		SimInput->TeleportGeneration = BallTeleportGeneration;
+
+		bResetBallSimState = false;
+	}
+}
+
+FOMRBallTuning AOMRPlayerPawn::MakeBallTuning() const
+{
+	FOMRBallTuning Tuning;
+	Tuning.MoveForce = MoveForce;
+	Tuning.MaxSpeed = MaxSpeed;
+	Tuning.AirControlMultiplier = AirControlMultiplier;
+	Tuning.LandingDampMultiplier = LandingDampMultiplier;
+	Tuning.InputDirInterpSpeed = InputDirInterpSpeed;
+
+	if (CollisionSphere)
+	{
+		Tuning.Radius = CollisionSphere->GetScaledSphereRadius();
+	}
+
+	return Tuning;
+}
+
+FOMRBallInput AOMRPlayerPawn::MakeBallInput() const
+{
+	FOMRBallInput Input;
+
+	// No camera = no input basis
+	if (Camera)
+	{
+		Input.CameraForward = Camera->GetForwardVector();
+		Input.CameraRight = Camera->GetRightVector();
+		Input.MoveForwardValue = MoveForwardValue;
+		Input.MoveRightValue = MoveRightValue;
+	}
+
+	Input.bGrounded = bIsGrounded;
+
+	if (bIsGrounded && CachedGroundHit.IsValidBlockingHit())
+	{
+		Input.GroundNormal = CachedGroundHit.ImpactNormal;
+	}
+
+	Input.bLandingDamp = LandingDampTimeRemaining > 0.f;
+
+	return Input;
+}
+
+void AOMRPlayerPawn::RegisterBallSimCallback()
+{
+	if (BallSimCallback) return;
+
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+
+	if (!PhysScene || !PhysScene->GetSolver())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("No physics solver, ball movement runs on the game thread."));
+		return;
+	}
+
+	BallSimCallback = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FOMRBallSimCallback>();
+}
+
+void AOMRPlayerPawn::UnregisterBallSimCallback()
+{
+	if (!BallSimCallback) return;
 
-	ClampVelocity();
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
 
-	SyncAngularVelocityWithLinear();
+	if (PhysScene && PhysScene->GetSolver())
+	{
+		PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(BallSimCallback);
+	}
+
+	BallSimCallback = nullptr;
+}
+
+void AOMRPlayerPawn::ConsumeBallSimOutput()
+{
+	// Carry the previous frame's last sample over as the start of this frame's path
+	if (BallPath.Num() > 1)
+	{
+		BallPath.RemoveAt(0, BallPath.Num() - 1, EAllowShrinking::No);
+	}
+
+	if (!BallSimCallback) return;
+
+	// Model state: only the newest step matters, older ones are already reflected in the body.
+	// Positions: every step, for the swept path.
+	while (Chaos::TSimCallbackOutputHandle<FOMRBallSimOutput> Output = BallSimCallback->PopOutputData_External())
+	{
+		// Stepped before the last teleport reached the physics thread
+		if (Output->TeleportGeneration != BallTeleportGeneration) continue;
+
+		// Stepped after the warm-up wake
+		if (bWarmupPhysicsAwake)
+		{
+			bWarmupPhysicsStepped = true;
+		}
+
+		BallState = Output->State;
+
+		if (!bHasSimClockOffset)
+		{
+			SimClockOffset = GetWorld()->GetTimeSeconds() - Output->SimTime;
+			bHasSimClockOffset = true;
+		}
+
+		AddBallPathSample(Output->Position, Output->SimTime + SimClockOffset);
+	}
+}
+
+void AOMRPlayerPawn::AddBallPathSample(const FVector& Position, double Time)
+{
+	if (BallPath.Num() > 0)
+	{
+		const FOMRBallPathSample& Last = BallPath.Last();
+
+		if (Time <= Last.Time || FVector::DistSquared(Last.Position, Position) > FMath::Square(BallPathBreakDistance))
+		{
+			BallPath.Reset();
+		}
+	}
+
+	FOMRBallPathSample& Sample = BallPath.AddDefaulted_GetRef();
+	Sample.Position = Position;
+	Sample.Time = Time;
+}
+
+float AOMRPlayerPawn::GetBallRadius() const
+{
+	return CollisionSphere ? CollisionSphere->GetScaledSphereRadius() : 0.f;
+}
+
+void AOMRPlayerPawn::StepMovementOnGameThread(const FOMRBallInput& Input, float DeltaTime)
+{
+	if (!CollisionSphere->IsSimulatingPhysics()) return;
+
+	BallModel.Tuning = MakeBallTuning();
+
+	BallState.Velocity = ReadBallVelocity();
+	BallState.AngularVelocity = CollisionSphere->GetPhysicsAngularVelocityInRadians();
+	INC_DWORD_STAT(STAT_OMR_BodyStateReads);
+
+	BallModel.Step(Input, BallState, DeltaTime);
+
+	if (!BallState.Force.IsZero())
+	{
+		CollisionSphere->AddForce(BallState.Force);
+		INC_DWORD_STAT(STAT_OMR_ForcesApplied);
+	}
+
+	if (BallState.bVelocityClamped)
+	{
+		CollisionSphere->SetPhysicsLinearVelocity(BallState.Velocity);
+	}
+
+	if (BallState.bAngularVelocityChanged)
+	{
+		CollisionSphere->SetPhysicsAngularVelocityInRadians(
+			BallState.AngularVelocity,
+			false // DO NOT add to existing
+		);
+	}
 }
 
 void AOMRPlayerPawn::UpdateLandingTimers(float DeltaTime)
 {
+	OMR_SCOPED_STAGE(STAT_OMR_UpdateLandingTimers);
+
 	LandingDampTimeRemaining = FMath::Max(LandingDampTimeRemaining - DeltaTime, 0.f);
 	LandingCameraLockTime = FMath::Max(LandingCameraLockTime - DeltaTime, 0.f);
 }
@@ -877,7 +1785,15 @@ void AOMRPlayerPawn::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPr
 {
 	if (!CollisionSphere) return;
 
-	const FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
+	// ---- CONTACT GROUNDING (same walkable rule as the sweep) ----
+	if (FOMRGroundProbe::IsWalkable(Hit) &&
+		(!bHasContactGround || Hit.Normal.Z > ContactGroundHit.Normal.Z))
+	{
+		ContactGroundHit = Hit;
+		bHasContactGround = true;
+	}
+
+	const FVector Velocity = ReadBallVelocity();
 
 	// ---- HIGH-SPEED GROUND BOUNCE ASSIST ----
 	const bool bGroundHit = (Hit.Normal.Z > 0.7f);
@@ -902,6 +1818,7 @@ void AOMRPlayerPawn::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPr
 			FVector::UpVector * Speed * AssistStrength;
 
 		CollisionSphere->AddImpulse(UpAssist, NAME_None, true);
+		INC_DWORD_STAT(STAT_OMR_ForcesApplied);
 	}
 
 	// ---- LANDING DAMP (not grace lockout) ----
@@ -916,7 +1833,13 @@ void AOMRPlayerPawn::Hop()
 {
 	if (!CollisionSphere) return;
 
-	if (!bCanHop) return;
+	// Record the press, the replay runs the same checks below
+	if (!ReplayLog)
+	{
+		PendingInputFlags |= FOMRInputLog::Frame_Hop;
+	}
+
+	if (!bCanHop || bRewinding) return;
 
 	if (!bIsGrounded) return;
 
@@ -928,7 +1851,7 @@ void AOMRPlayerPawn::Hop()
 	bCanHop = false;
 	LastHopTime = CurrentTime;
 
-	FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
+	FVector Velocity = ReadBallVelocity();
 
 	// kill downward velocity only
 	if (Velocity.Z < 0.f)
@@ -942,15 +1865,16 @@ void AOMRPlayerPawn::Hop()
 		NAME_None,
 		true
 	);
+	INC_DWORD_STAT(STAT_OMR_ForcesApplied);
 }
 
-void AOMRPlayerPawn::PlayBallAudio()
+void AOMRPlayerPawn::PlayBallAudio(float DeltaTime)
 {
-	if (!RollAudio || MaxSpeed <= 0.f) return;
+	OMR_SCOPED_STAGE(STAT_OMR_PlayBallAudio);
 
-	const float DeltaTime = GetWorld()->GetDeltaSeconds();
+	if (!RollAudio || MaxSpeed <= 0.f || bShowingReplay) return;
 
-	float Speed = CollisionSphere->GetPhysicsLinearVelocity().Size();
+	float Speed = ReadBallVelocity().Size();
 	float NormalizedSpeed = FMath::Clamp(Speed / MaxSpeed, 0.f, 1.f);
 
 	float SpeedAlpha = FMath::Pow(NormalizedSpeed, 1.3f);
@@ -977,9 +1901,11 @@ void AOMRPlayerPawn::PlayBallAudio()
 
 void AOMRPlayerPawn::HandleLanding()
 {
+	OMR_SCOPED_STAGE(STAT_OMR_HandleLanding);
+
 	if (!bWasGrounded && bIsGrounded)
 	{
-		const FVector Velocity = CollisionSphere->GetPhysicsLinearVelocity();
+		const FVector Velocity = ReadBallVelocity();
 		const float VerticalSpeed = FMath::Abs(Velocity.Z);
 
 		if (VerticalSpeed > 300.f)
@@ -989,13 +1915,13 @@ void AOMRPlayerPawn::HandleLanding()
 			float Volume = FMath::Lerp(0.3f, 1.0f, ImpactAlpha);
 			float Pitch = FMath::Lerp(0.9f, 1.2f, ImpactAlpha);
 
-			UGameplayStatics::PlaySoundAtLocation(
-				this,
-				LandingSound,
-				GetActorLocation(),
-				Volume,
-				Pitch
-			);
+			PlayLandingSound(Volume, Pitch);
+
+			if (AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>())
+			{
+				GS->AddReplayEvent(EOMRReplayEvent::Landing, 0, Volume, Pitch);
+				GS->PostRaceEvent(FOMRRaceEvent::MakeLanding(VerticalSpeed));
+			}
 			
 			float ShakeClass = ImpactAlpha;
 			
@@ -1009,3 +1935,14 @@ void AOMRPlayerPawn::HandleLanding()
 
 	bWasGrounded = bIsGrounded;
 }
+
+void AOMRPlayerPawn::PlayLandingSound(float Volume, float Pitch)
+{
+	UGameplayStatics::PlaySoundAtLocation(
+		this,
+		LandingSound,
+		GetActorLocation(),
+		Volume,
+		Pitch
+	);
+}
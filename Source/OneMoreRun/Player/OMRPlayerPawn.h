@@ -6,6 +6,12 @@
 #include "GameFramework/Pawn.h"
 #include "InputActionValue.h"
 #include "InputMappingContext.h"
+#include "OMRBallMovementModel.h"
+#include "OMRGroundProbe.h"
+#include "OMRInputLog.h"
+#include "OMRRewindBuffer.h"
+#include "../Game/OMRTickScheduler.h"
+#include "../Track/OMRTimingLines.h"
 #include "OMRPlayerPawn.generated.h"
 
 class USphereComponent;
@@ -14,6 +20,36 @@ class UCameraComponent;
 class USceneComponent;
 class UAudioComponent;
 class USoundBase;
+class FOMRBallSimCallback;
+class UOMRTrackSurfaceSubsystem;
+struct FOMRReplayFrame;
+
+UENUM()
+enum class EOMRGroundingMode : uint8
+{
+	// Blocking sphere sweep every tick
+	Sweep,
+	// Sweep issued one frame ahead, result consumed next frame
+	AsyncProbe,
+	// Baked track surface, blocking sweep only on edges and overhangs
+	SurfaceField,
+	// Walkable solver contacts reported to OnHit during the last physics step
+	Contacts
+};
+
+// First-use costs paid during the countdown, one stage per frame, in this order
+enum class EOMRWarmupStage : uint8
+{
+	GroundQueries,
+	MovementModel,
+	PhysicsWake,
+	PhysicsSleep,
+	RollAudio,
+	LandingSound,
+	CameraShake,
+	Hud,
+	Done
+};
 
 UCLASS()
 class ONEMORERUN_API AOMRPlayerPawn : public APawn
@@ -25,6 +61,8 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
 	virtual void SetupPlayerInputComponent(UInputComponent* PlayerInputComponent) override;
 
 
@@ -34,7 +72,6 @@ protected:
 
 
 	// Behaviour
-	void ApplyMovementForce(float DeltaTime);
 	virtual bool IsGrounded() const;
 
 
@@ -42,17 +79,63 @@ protected:
 	bool GetGroundHit(FHitResult& OutHit) const;
 	// Grounding
 	bool UpdateGroundedState(float DeltaTime);
+	bool ProbeGround(float DeltaTime, FHitResult& OutHit);
+	bool GetSurfaceFieldHit(const FVector& Location, bool& bOutWalkable, FHitResult& OutHit) const;
+	bool ConsumeContactGround(FHitResult& OutHit);
+	void CompareGroundingWithSweep(bool bProbeGrounded, const FHitResult& ProbeHit);
 
-	FVector GetMovementInputVector(const FVector& GroundNormal) const;
-	void ClampVelocity();
-	float GetSlopeForceMultiplier(const FVector& GroundNormal) const;
-	void SyncAngularVelocityWithLinear();
 	void UpdateCamera(float DeltaTime);
 	void SyncActorToPhysics();
+	FVector ReadBallVelocity() const;
 	void StartRacePhysics();
 	void UpdateMovement(float DeltaTime);
 	void UpdateLandingTimers(float DeltaTime);
 
+	// Movement model (see FOMRBallMovementModel)
+	FOMRBallTuning MakeBallTuning() const;
+	FOMRBallInput MakeBallInput() const;
+	void RegisterBallSimCallback();
+	void UnregisterBallSimCallback();
+	void ConsumeBallSimOutput();
+	void StepMovementOnGameThread(const FOMRBallInput& Input, float DeltaTime);
+
+	// Swept path for timing lines
+	void AddBallPathSample(const FVector& Position, double Time);
+
+	TArray<FOMRBallPathSample, TInlineAllocator<16>> BallPath;
+
+	// Maps physics sim time onto the world clock, captured from the first step output
+	double SimClockOffset = 0.0;
+	bool bHasSimClockOffset = false;
+
+	// Longer segments are teleports (reset, respawn) and break the path
+	UPROPERTY(EditAnywhere, Category = "Timing")
+	float BallPathBreakDistance = 1000.f;
+
+	// Input log
+	void RecordOrReplayInput(float DeltaTime);
+
+	FOMRInputLog InputLog;
+
+	// Flags for the frame being recorded (hop pressed, run reset)
+	uint8 PendingInputFlags = 0;
+
+	// Frames one lap can record, a longer lap isn't saved
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	int32 InputLogReserveFrames = 60 * 60 * 10;
+
+	const FOMRInputLog* ReplayLog = nullptr;
+	int32 ReplayFrame = 0;
+	bool bReplayDiverged = false;
+
+	// Tick scheduling: the actor tick runs pre-physics movement, everything else is a task
+	void BuildTickTasks();
+
+	FOMRTickScheduler TickScheduler;
+
+	UPROPERTY(EditAnywhere, Category = "Tick", meta = (ClampMin = "1.0"))
+	float AudioUpdateRate = 30.f;
+
 	// Bonus Flavour
 	UFUNCTION()
 		void OnHit(
@@ -83,6 +166,19 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Input")
 	UInputAction* IA_Hop;
 
+	// Optional, restarts the whole race (see AOMRTimeTrialGameState::RestartRace)
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	UInputAction* IA_Restart;
+
+	void RequestRestartRace();
+
+	// Practice rewind, held to scrub back, released to resume
+	UPROPERTY(EditDefaultsOnly, Category = "Input")
+	UInputAction* IA_Rewind;
+
+	void BeginRewind();
+	void EndRewind();
+
 	bool bCanHop = true;
 
 
@@ -96,6 +192,25 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Movement")
 	float AirControlMultiplier = 0.25f;
 
+	// Runs the movement model inside the Chaos solver at the fixed async physics step.
+	// Falls back to one model step per game frame when no physics scene is available.
+	UPROPERTY(EditAnywhere, Category = "Movement|Physics")
+	bool bSimulateMovementOnPhysicsThread = true;
+
+	FOMRBallSimCallback* BallSimCallback = nullptr;
+
+	// Game-thread model (fallback path) and latest state read back from physics
+	FOMRBallMovementModel BallModel;
+	FOMRBallState BallState;
+
+	bool bResetBallSimState = false;
+
+	// Sent with bResetBallSimState, a rewind resumes with the input smoothing it had
+	FVector ResetSmoothedInputDir = FVector::ZeroVector;
+
+	// Bumped by TeleportBall, sim outputs from before the teleport are dropped
+	uint32 BallTeleportGeneration = 0;
+
 	UPROPERTY(EditAnywhere, Category = "Movement|Hop")
 	float HopImpulse = 400, f;
 
@@ -109,6 +224,31 @@ protected:
 	bool bIsGrounded = false;
 	FHitResult CachedGroundHit;
 
+	// Unstabilized result of the last ground probe, answers IsGrounded()
+	bool bRawGrounded = false;
+
+	UPROPERTY(EditAnywhere, Category = "Movement|Grounding")
+	EOMRGroundingMode GroundingMode = EOMRGroundingMode::AsyncProbe;
+
+	// How far the ball may stray from the predicted probe origin before the result is discarded
+	UPROPERTY(EditAnywhere, Category = "Movement|Grounding")
+	float GroundProbeMaxDrift = 12.f;
+
+	FOMRGroundProbe GroundProbe;
+
+	UPROPERTY()
+	UOMRTrackSurfaceSubsystem* TrackSurface;
+
+	// Most upright walkable contact since the last grounding update
+	bool bHasContactGround = false;
+	FHitResult ContactGroundHit;
+
+	// Also runs the blocking sweep and logs where GroundingMode disagrees with it
+	UPROPERTY(EditAnywhere, Category = "Movement|Grounding")
+	bool bCompareGroundingModes = false;
+
+	int32 GroundingDisagreeFrames = 0;
+
 	// Grounding stability
 	bool bGroundedStable = false;
 	float GroundedCoyoteTime = 0.f;
@@ -214,9 +354,7 @@ protected:
 	float CurrentCameraDistance = 0.f;
 
 
-	// Smoothed player input (NOT camera)
-	FVector SmoothedInputDir = FVector::ZeroVector;
-
+	// Smoothed player input (NOT camera), state lives in BallState.SmoothedInputDir
 	UPROPERTY(EditAnywhere, Category = "Movement|Input")
 	float InputDirInterpSpeed = 12.0f;
 
@@ -242,6 +380,55 @@ protected:
 
 	FTransform SpawnTransform;
 
+	// Camera and audio as they were on GO, what a restarted race goes back to
+	struct FRaceStartSnapshot
+	{
+		FTransform CameraRootTransform;
+		float CameraVerticalAnchorZ = 0.f;
+		float SmoothedCameraZ = 0.f;
+		FVector SmoothedMoveDir = FVector::ForwardVector;
+		float CurrentCameraDistance = 0.f;
+		float CurrentFOV = 0.f;
+		float SmoothedPitch = 1.f;
+		float SmoothedVolume = 0.f;
+	};
+
+	FRaceStartSnapshot RaceStartSnapshot;
+	bool bHasRaceStartSnapshot = false;
+
+	void CaptureRaceStartSnapshot();
+
+	// Authoritative ball teleport shared by ResetRun and rewind, drops everything tied to the old position
+	void TeleportBall(const FTransform& Transform, const FVector& LinearVelocity, const FVector& AngularVelocity);
+
+	// Practice rewind: snapshots every RewindSnapshotInterval, RewindHistoryDuration kept
+	UPROPERTY(EditAnywhere, Category = "Practice")
+	bool bEnableRewind = false;
+
+	UPROPERTY(EditAnywhere, Category = "Practice", meta = (EditCondition = "bEnableRewind"))
+	float RewindSnapshotInterval = 0.1f;
+
+	UPROPERTY(EditAnywhere, Category = "Practice", meta = (EditCondition = "bEnableRewind"))
+	float RewindHistoryDuration = 30.f;
+
+	// Seconds of history scrubbed per second held
+	UPROPERTY(EditAnywhere, Category = "Practice", meta = (EditCondition = "bEnableRewind"))
+	float RewindScrubRate = 3.f;
+
+	FOMRRewindBuffer RewindBuffer;
+	bool bRewinding = false;
+
+	// Snapshots back from the newest, and how far back is still the same lap
+	float RewindCursor = 0.f;
+	int32 RewindMaxAgo = 0;
+
+	// Driven by the game state's session replay, simulation and input are off
+	bool bShowingReplay = false;
+
+	void CaptureRewindSnapshot();
+	void ScrubRewind(float DeltaTime);
+	void ApplyRewindSnapshot(const FOMRRewindSnapshot& Snapshot, bool bResume);
+
 
 	// Countdown
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Countdown")
@@ -257,6 +444,35 @@ protected:
 	UFUNCTION()
 	void UpdateCountdown(float DeltaTime);
 
+	// Runs the first frames' one-off costs (first sweeps, first solver step, audio, camera
+	// shake, HUD layout) spread over the first countdown after BeginPlay, and logs what each took
+	UPROPERTY(EditAnywhere, Category = "Countdown")
+	bool bWarmUpDuringCountdown = true;
+
+	// Wakes the frozen ball without gravity until the solver has stepped it, then puts it back
+	// exactly. Async physics can go a frame without a step, so the ball stays awake until a sim
+	// output from after the wake comes back, WarmupPhysicsMaxFrames frames at most
+	UPROPERTY(EditAnywhere, Category = "Countdown", meta = (EditCondition = "bWarmUpDuringCountdown"))
+	bool bWarmUpPhysics = true;
+
+	UPROPERTY(EditAnywhere, Category = "Countdown", meta = (EditCondition = "bWarmUpPhysics", ClampMin = "1"))
+	int32 WarmupPhysicsMaxFrames = 8;
+
+	void UpdateWarmup();
+	void RunWarmupStage(EOMRWarmupStage Stage);
+
+	// Skips what's left, the ball is put back if it was awake. Called at GO and on restart
+	void EndWarmup();
+
+	EOMRWarmupStage WarmupStage = EOMRWarmupStage::GroundQueries;
+	float WarmupStageMs[(int32)EOMRWarmupStage::Done] = {};
+
+	bool bWarmupPhysicsAwake = false;
+	bool bWarmupPhysicsStepped = false;
+	int32 WarmupPhysicsAwakeFrames = 0;
+	bool bWarmupGravity = true;
+	FTransform WarmupBallTransform;
+
 	float GoDisplayTimeRemaining = 0.f;
 
 	UPROPERTY(EditAnywhere, Category = "Countdown")
@@ -274,7 +490,7 @@ protected:
 	UAudioComponent* RollAudio;
 
 	UFUNCTION()
-	void PlayBallAudio();
+	void PlayBallAudio(float DeltaTime);
 
 	float SmoothedPitch;
 	float SmoothedVolume;
@@ -295,4 +511,52 @@ protected:
 public:	
 	virtual void Tick(float DeltaTime) override;
 
+	// Ball state for recorders and timing
+	FTransform GetBallTransform() const;
+	FVector GetBallVelocity() const { return ReadBallVelocity(); }
+	bool IsBallGrounded() const { return bIsGrounded; }
+	bool IsRewinding() const { return bRewinding; }
+
+	// Ball, grounding and camera state, the lap clock is left to the game state. Applying
+	// teleports the ball with the snapshot's velocities times VelocityScale
+	void CaptureSnapshot(FOMRRewindSnapshot& OutSnapshot) const;
+	void ApplySnapshot(const FOMRRewindSnapshot& Snapshot, float VelocityScale);
+
+	// Session replay: the frame the player sees, and showing recorded frames in its place.
+	// EndReplayView leaves physics off, the race restart turns it back on at GO
+	void CaptureReplayFrame(FOMRReplayFrame& OutFrame) const;
+	void BeginReplayView();
+	void ShowReplayFrame(const FOMRReplayFrame& Frame);
+	void EndReplayView();
+	bool IsShowingReplay() const { return bShowingReplay; }
+
+	void PlayLandingSound(float Volume, float Pitch);
+
+	// Identifies the handling a ghost was recorded with
+	uint32 GetTuningHash() const;
+
+	// Input recorded since the current lap started, replayable by the lap validator
+	const FOMRInputLog& GetInputLog() const { return InputLog; }
+
+	// Called by AOMRTimeTrialGameState::StartLap with the pawn and lap clock at the crossing
+	void BeginLapInputLog(const FOMRRewindSnapshot& LapStart);
+
+	// Back to the state at BeginPlay with the countdown running, in place and without
+	// allocating. Called by AOMRTimeTrialGameState::RestartRace
+	void RestartRace();
+
+	// Drives the pawn from Log instead of player input, Log must outlive the replay. Skips
+	// the countdown and starts the lap where the log's lap started
+	void StartInputReplay(const FOMRInputLog* Log);
+	bool IsReplayingInput() const { return ReplayLog != nullptr; }
+	bool HasReplayDiverged() const { return bReplayDiverged; }
+
+	// The game state hit something the recording can't contain, e.g. a restart
+	void MarkReplayDiverged() { bReplayDiverged = true; }
+
+	// Ball centre at every physics step consumed this frame, led by the last sample of the
+	// previous frame so consecutive frames chain into one swept path
+	TConstArrayView<FOMRBallPathSample> GetBallPath() const { return BallPath; }
+	float GetBallRadius() const;
+
 };
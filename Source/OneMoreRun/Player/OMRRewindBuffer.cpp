@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRRewindBuffer.h"
+
+void FOMRRewindBuffer::Init(int32 Capacity)
+{
+	Snapshots.SetNum(FMath::Max(Capacity, 1));
+	Reset();
+}
+
+FOMRRewindSnapshot& FOMRRewindBuffer::Add()
+{
+	check(IsInitialized());
+
+	FOMRRewindSnapshot& Snapshot = Snapshots[Head];
+
+	Head = (Head + 1) % Snapshots.Num();
+	Count = FMath::Min(Count + 1, Snapshots.Num());
+
+	return Snapshot;
+}
+
+const FOMRRewindSnapshot& FOMRRewindBuffer::Get(int32 Ago) const
+{
+	check(Ago >= 0 && Ago < Count);
+
+	return Snapshots[(Head - 1 - Ago + Snapshots.Num()) % Snapshots.Num()];
+}
+
+void FOMRRewindBuffer::Truncate(int32 Ago)
+{
+	Ago = FMath::Clamp(Ago, 0, Count);
+
+	Head = (Head - Ago + Snapshots.Num()) % Snapshots.Num();
+	Count -= Ago;
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Where the lap stood when a snapshot was taken, see AOMRTimeTrialGameState::RestoreLapClock
+struct FOMRLapClock
+{
+	int32 Lap = 0;
+	int32 CheckpointIndex = 0;
+	float LapTime = 0.f;
+	float ProgressDistance = 0.f;
+	bool bLapActive = false;
+
+	// Whether the ball was behind the gate, see AOMRTimeTrialGameState::GateBackwardCrossings
+	int32 GateBackwardCrossings = 0;
+};
+
+/**
+ * Everything needed to put the ball back at one instant of a run: body, grounding and
+ * landing timers, camera smoothing and the lap clock. Single precision throughout.
+ */
+struct FOMRRewindSnapshot
+{
+	// Body
+	FVector3f Location = FVector3f::ZeroVector;
+	FQuat4f Rotation = FQuat4f::Identity;
+	FVector3f LinearVelocity = FVector3f::ZeroVector;
+	FVector3f AngularVelocity = FVector3f::ZeroVector;
+	FVector3f SmoothedInputDir = FVector3f::ZeroVector;
+
+	// Grounding state machine and landing
+	float GroundedCoyoteTime = 0.f;
+	float GroundedConfirmTime = 0.f;
+	float PostImpactGraceTime = 0.f;
+	float LandingDampTimeRemaining = 0.f;
+	float LandingCameraLockTime = 0.f;
+	float TimeSinceUngrounded = 0.f;
+	bool bGroundedStable = false;
+	bool bWasGrounded = false;
+	bool bCanHop = false;
+
+	// Camera smoothing
+	FVector3f CameraRootLocation = FVector3f::ZeroVector;
+	FVector3f SmoothedMoveDir = FVector3f::ForwardVector;
+	float CameraVerticalAnchorZ = 0.f;
+	float SmoothedCameraZ = 0.f;
+	float SmoothedCameraSpeed = 0.f;
+	float CurrentCameraDistance = 0.f;
+	float CurrentFOV = 0.f;
+
+	FOMRLapClock LapClock;
+};
+
+/**
+ * Fixed-capacity ring of rewind snapshots, the oldest is overwritten once full. Sized once
+ * by Init, Add and Truncate never allocate.
+ */
+class ONEMORERUN_API FOMRRewindBuffer
+{
+public:
+	void Init(int32 Capacity);
+	void Reset() { Head = 0; Count = 0; }
+
+	bool IsInitialized() const { return Snapshots.Num() > 0; }
+
+	// Slot for the next snapshot, fill it in place
+	FOMRRewindSnapshot& Add();
+
+	int32 Num() const { return Count; }
+
+	// 0 is the most recent snapshot
+	const FOMRRewindSnapshot& Get(int32 Ago) const;
+
+	// Drops the Ago most recent snapshots, play resumes from the one before them
+	void Truncate(int32 Ago);
+
+	int32 GetAllocatedSize() const { return Snapshots.GetAllocatedSize(); }
+
+private:
+	TArray<FOMRRewindSnapshot> Snapshots;
+
+	// Next write slot
+	int32 Head = 0;
+	int32 Count = 0;
+};
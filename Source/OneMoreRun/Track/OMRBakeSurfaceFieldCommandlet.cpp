@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRBakeSurfaceFieldCommandlet.h"
+#include "OMRTrackSurfaceField.h"
+#include "../Player/OMRGroundProbe.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "UObject/Package.h"
+
+UOMRBakeSurfaceFieldCommandlet::UOMRBakeSurfaceFieldCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UOMRBakeSurfaceFieldCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	float CellSize = 50.f;
+	if (const FString* CellSizeValue = ParamValues.Find(TEXT("CellSize")))
+	{
+		CellSize = FMath::Max(FCString::Atof(**CellSizeValue), 5.f);
+	}
+
+	TArray<FString> PackageNames;
+
+	if (const FString* Map = ParamValues.Find(TEXT("Map")))
+	{
+		PackageNames.Add(*Map);
+	}
+	else
+	{
+		TArray<FString> MapFiles;
+		IFileManager::Get().FindFilesRecursive(MapFiles, *(FPaths::ProjectContentDir() / TEXT("Maps")), TEXT("*.umap"), true, false);
+
+		for (const FString& MapFile : MapFiles)
+		{
+			FString PackageName;
+			if (FPackageName::TryConvertFilenameToLongPackageName(MapFile, PackageName))
+			{
+				PackageNames.Add(PackageName);
+			}
+		}
+	}
+
+	int32 NumFailed = 0;
+
+	for (const FString& PackageName : PackageNames)
+	{
+		if (!BakeMap(PackageName, CellSize))
+		{
+			++NumFailed;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Baked %d surface fields, %d failed."), PackageNames.Num() - NumFailed, NumFailed);
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+bool UOMRBakeSurfaceFieldCommandlet::BakeMap(const FString& PackageName, float CellSize)
+{
+	UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load map %s."), *PackageName);
+		return false;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(true)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false));
+	}
+
+	World->UpdateWorldComponents(true, false);
+
+	// -------------------------------------------------
+	// 1. Bounds of everything the ground sweep can hit
+	// -------------------------------------------------
+	FBox Bounds(ForceInit);
+
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		if (It->IsA<APawn>()) continue;
+
+		It->ForEachComponent<UPrimitiveComponent>(false, [&Bounds](UPrimitiveComponent* Primitive)
+		{
+			if (Primitive->IsCollisionEnabled() &&
+				Primitive->GetCollisionResponseToChannel(ECC_WorldStatic) == ECR_Block)
+			{
+				Bounds += Primitive->Bounds.GetBox();
+			}
+		});
+	}
+
+	const FString MapName = FPackageName::GetShortName(PackageName);
+	bool bSuccess = false;
+
+	const int64 NumCellsX = Bounds.IsValid ? FMath::CeilToInt64(Bounds.GetSize().X / CellSize) : 0;
+	const int64 NumCellsY = Bounds.IsValid ? FMath::CeilToInt64(Bounds.GetSize().Y / CellSize) : 0;
+
+	if (NumCellsX <= 0 || NumCellsY <= 0 || NumCellsX * NumCellsY > 64 * 1024 * 1024)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s: no collision to bake or bounds too large (%lld x %lld cells)."), *MapName, NumCellsX, NumCellsY);
+	}
+	else
+	{
+		// -------------------------------------------------
+		// 2. Column traces: top surface + overhang check
+		// -------------------------------------------------
+		TArray<FOMRTrackSurfaceField::FBakeCell> Cells;
+		Cells.SetNum((int32)(NumCellsX * NumCellsY));
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(OMRBakeSurfaceField), false);
+		QueryParams.bReturnPhysicalMaterial = true;
+
+		const double TopZ = Bounds.Max.Z + 100.0;
+		const double BottomZ = Bounds.Min.Z - 100.0;
+
+		// Anything lower than this under the top surface could hold the ball
+		const float OverhangClearance = 100.f;
+
+		for (int32 Y = 0; Y < NumCellsY; ++Y)
+		{
+			for (int32 X = 0; X < NumCellsX; ++X)
+			{
+				const double WorldX = Bounds.Min.X + (X + 0.5) * CellSize;
+				const double WorldY = Bounds.Min.Y + (Y + 0.5) * CellSize;
+
+				FHitResult Hit;
+				if (!World->LineTraceSingleByChannel(Hit, FVector(WorldX, WorldY, TopZ), FVector(WorldX, WorldY, BottomZ), ECC_WorldStatic, QueryParams))
+				{
+					continue;
+				}
+
+				FOMRTrackSurfaceField::FBakeCell& Cell = Cells[Y * NumCellsX + X];
+				Cell.Height = Hit.ImpactPoint.Z;
+				Cell.Normal = FVector3f(Hit.ImpactNormal);
+				Cell.SurfaceType = Hit.PhysMaterial.IsValid() ? (uint8)Hit.PhysMaterial->SurfaceType : 0;
+				Cell.Flags = FOMRTrackSurfaceField::Cell_Valid;
+
+				// Walls and steep tops are left to the sweep
+				if (Hit.ImpactNormal.Z <= FOMRGroundProbe::WalkableNormalZ)
+				{
+					Cell.Flags |= FOMRTrackSurfaceField::Cell_Edge;
+				}
+
+				FHitResult LowerHit;
+				const FVector LowerStart(WorldX, WorldY, Hit.ImpactPoint.Z - OverhangClearance);
+				if (World->LineTraceSingleByChannel(LowerHit, LowerStart, FVector(WorldX, WorldY, BottomZ), ECC_WorldStatic, QueryParams) &&
+					LowerHit.ImpactNormal.Z > FOMRGroundProbe::WalkableNormalZ)
+				{
+					Cell.Flags |= FOMRTrackSurfaceField::Cell_Overhang;
+				}
+			}
+		}
+
+		// -------------------------------------------------
+		// 3. Edges: holes and steps the plane fit can't describe
+		// -------------------------------------------------
+		const float MaxStep = 20.f;
+
+		for (int32 Y = 0; Y < NumCellsY; ++Y)
+		{
+			for (int32 X = 0; X < NumCellsX; ++X)
+			{
+				FOMRTrackSurfaceField::FBakeCell& Cell = Cells[Y * NumCellsX + X];
+				if (!(Cell.Flags & FOMRTrackSurfaceField::Cell_Valid)) continue;
+
+				const FIntPoint Neighbours[] = { {X - 1, Y}, {X + 1, Y}, {X, Y - 1}, {X, Y + 1} };
+
+				for (const FIntPoint& N : Neighbours)
+				{
+					const bool bInside = N.X >= 0 && N.Y >= 0 && N.X < NumCellsX && N.Y < NumCellsY;
+					const FOMRTrackSurfaceField::FBakeCell* Other = bInside ? &Cells[N.Y * NumCellsX + N.X] : nullptr;
+
+					if (!Other || !(Other->Flags & FOMRTrackSurfaceField::Cell_Valid))
+					{
+						Cell.Flags |= FOMRTrackSurfaceField::Cell_Edge;
+						break;
+					}
+
+					// Height the neighbour should have if this cell's plane continued
+					const float DX = (N.X - X) * CellSize;
+					const float DY = (N.Y - Y) * CellSize;
+					const float Expected = Cell.Height - (Cell.Normal.X * DX + Cell.Normal.Y * DY) / FMath::Max(Cell.Normal.Z, 0.1f);
+
+					if (FMath::Abs(Other->Height - Expected) > MaxStep)
+					{
+						Cell.Flags |= FOMRTrackSurfaceField::Cell_Edge;
+						break;
+					}
+				}
+			}
+		}
+
+		const FString Filename = FOMRTrackSurfaceField::GetFieldPath(MapName);
+
+		bSuccess = FOMRTrackSurfaceField::Write(Filename, Bounds.Min.X, Bounds.Min.Y, CellSize, (int32)NumCellsX, (int32)NumCellsY, Cells);
+
+		if (bSuccess)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%s: baked %lld x %lld cells to %s."), *MapName, NumCellsX, NumCellsY, *Filename);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: failed to write %s."), *MapName, *Filename);
+		}
+	}
+
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return bSuccess;
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OMRBakeSurfaceFieldCommandlet.generated.h"
+
+/**
+ * Rasterizes the walkable WorldStatic collision of track maps into a FOMRTrackSurfaceField.
+ *
+ * UnrealEditor-Cmd OneMoreRun.uproject -run=OMRBakeSurfaceField [-Map=/Game/Maps/L_TestGym] [-CellSize=50]
+ *
+ * Without -Map every map under /Game/Maps is baked. Returns non-zero if any map failed.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRBakeSurfaceFieldCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOMRBakeSurfaceFieldCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool BakeMap(const FString& PackageName, float CellSize);
+};
@@ -3,6 +3,7 @@
 
 #include "OMRCheckpoint.h"
 #include "../Game/OMRTimeTrialGameState.h"
+#include "OMRCheckpointRegistry.h"
 #include "../Player/OMRPlayerPawn.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
@@ -33,12 +34,38 @@ AOMRCheckpoint::AOMRCheckpoint()
 void AOMRCheckpoint::BeginPlay()
 {
 	Super::BeginPlay();
+
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		Registry->RegisterCheckpoint(this);
+	}
+
+	const AOMRTimeTrialGameState* GS = GetWorld() ? GetWorld()->GetGameState<AOMRTimeTrialGameState>() : nullptr;
+	bTimedByLine = GS && GS->bUseTimingLines;
+
+	if (bTimedByLine)
+	{
+		Trigger->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Trigger->SetGenerateOverlapEvents(false);
+		return;
+	}
+
 	Trigger->OnComponentBeginOverlap.AddDynamic(this, &AOMRCheckpoint::OnTriggerBeginOverlap);
 }
 
+void AOMRCheckpoint::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		Registry->UnregisterCheckpoint(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AOMRCheckpoint::ResetCheckpoint()
 {
-	if (!Trigger) return;
+	if (!Trigger || bTimedByLine) return;
 
 	Trigger->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
 	Trigger->SetGenerateOverlapEvents(true);
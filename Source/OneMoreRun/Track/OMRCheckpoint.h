@@ -30,11 +30,19 @@ public:
 	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category = "Checkpoint")
 	int32 CheckpointIndex = 0;
 
+	// Forward through the timing line is the trigger's +X; flip if the checkpoint faces against the racing line
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "Checkpoint")
+	bool bFlipCrossingDirection = false;
+
 	UFUNCTION(BlueprintCallable, Category = "Checkpoint")
 	void ResetCheckpoint();
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Game state times this checkpoint from its timing line, the trigger stays off
+	bool bTimedByLine = false;
 
 	UFUNCTION()
 	void OnTriggerBeginOverlap(
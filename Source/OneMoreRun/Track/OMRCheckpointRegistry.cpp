@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRCheckpointRegistry.h"
+#include "OMRCheckpoint.h"
+#include "OMRStartFinishGate.h"
+#include "OMRTrackData.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "../OneMoreRun.h"
+
+void UOMRCheckpointRegistry::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LLM_SCOPE_BYTAG(OMR_Track);
+
+	const FString MapName = UWorld::RemovePIEPrefix(InWorld.GetMapName());
+
+	TrackData = UOMRTrackData::LoadForMap(MapName);
+
+	ValidateTrackData();
+
+	if (TrackData)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Loaded track data for %s: %d checkpoints."), *MapName, TrackData->Checkpoints.Num());
+		OnChanged.Broadcast();
+	}
+}
+
+void UOMRCheckpointRegistry::RegisterCheckpoint(AOMRCheckpoint* Checkpoint)
+{
+	if (!Checkpoint) return;
+
+	const int32 Index = Checkpoint->CheckpointIndex;
+	if (Index < 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s has negative CheckpointIndex %d, ignored."), *Checkpoint->GetName(), Index);
+		return;
+	}
+
+	LLM_SCOPE_BYTAG(OMR_Track);
+
+	if (Index >= Checkpoints.Num())
+	{
+		Checkpoints.SetNum(Index + 1);
+	}
+
+	if (Checkpoints[Index] == Checkpoint || Duplicates.Contains(Checkpoint)) return;
+
+	if (Checkpoints[Index])
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s duplicates CheckpointIndex %d of %s."),
+			*Checkpoint->GetName(), Index, *Checkpoints[Index]->GetName());
+
+		Duplicates.Add(Checkpoint);
+	}
+	else
+	{
+		Checkpoints[Index] = Checkpoint;
+		NumFilled++;
+	}
+
+	if (NumGaps() > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Checkpoint registry: %d of %d indices filled."), NumFilled, Checkpoints.Num());
+	}
+
+	ValidateTrackData();
+
+	OnChanged.Broadcast();
+}
+
+void UOMRCheckpointRegistry::UnregisterCheckpoint(AOMRCheckpoint* Checkpoint)
+{
+	if (!Checkpoint) return;
+
+	if (Duplicates.RemoveSingleSwap(Checkpoint) > 0)
+	{
+		OnChanged.Broadcast();
+		return;
+	}
+
+	const int32 Index = Checkpoints.Find(Checkpoint);
+	if (Index == INDEX_NONE) return;
+
+	Checkpoints[Index] = nullptr;
+	NumFilled--;
+
+	// A duplicate with the same index takes the slot over
+	const int32 DuplicateIndex = Duplicates.IndexOfByPredicate([Index](const AOMRCheckpoint* Duplicate)
+	{
+		return Duplicate && Duplicate->CheckpointIndex == Index;
+	});
+
+	if (DuplicateIndex != INDEX_NONE)
+	{
+		Checkpoints[Index] = Duplicates[DuplicateIndex];
+		Duplicates.RemoveAtSwap(DuplicateIndex);
+		NumFilled++;
+	}
+
+	TrimTrailingGaps();
+
+	OnChanged.Broadcast();
+}
+
+void UOMRCheckpointRegistry::RegisterGate(AOMRStartFinishGate* Gate)
+{
+	if (!Gate || Gates.Contains(Gate)) return;
+
+	Gates.Add(Gate);
+
+	if (Gates.Num() > 1)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%d start/finish gates registered."), Gates.Num());
+	}
+
+	ValidateTrackData();
+
+	OnChanged.Broadcast();
+}
+
+void UOMRCheckpointRegistry::UnregisterGate(AOMRStartFinishGate* Gate)
+{
+	if (Gates.RemoveSingleSwap(Gate) > 0)
+	{
+		OnChanged.Broadcast();
+	}
+}
+
+AOMRCheckpoint* UOMRCheckpointRegistry::GetCheckpoint(int32 CheckpointIndex) const
+{
+	return Checkpoints.IsValidIndex(CheckpointIndex) ? Checkpoints[CheckpointIndex].Get() : nullptr;
+}
+
+void UOMRCheckpointRegistry::TrimTrailingGaps()
+{
+	int32 NewNum = Checkpoints.Num();
+	while (NewNum > 0 && !Checkpoints[NewNum - 1])
+	{
+		NewNum--;
+	}
+
+	Checkpoints.SetNum(NewNum, EAllowShrinking::No);
+}
+
+void UOMRCheckpointRegistry::ValidateTrackData()
+{
+	if (!TrackData) return;
+
+	FString Mismatch;
+
+	// Also catches assets baked before the hash existed
+	if (TrackData->LayoutHash != UOMRTrackData::HashLayout(TrackData->Gate, TrackData->Checkpoints))
+	{
+		Mismatch = TEXT("layout hash");
+	}
+
+	for (int32 Index = 0; Mismatch.IsEmpty() && Index < Checkpoints.Num(); ++Index)
+	{
+		const AOMRCheckpoint* CP = Checkpoints[Index];
+
+		if (CP && !TrackData->MatchesLine(Index, UOMRTrackData::MakeLineData(CP->Trigger, CP, CP->bFlipCrossingDirection)))
+		{
+			Mismatch = CP->GetName();
+		}
+	}
+
+	for (const AOMRStartFinishGate* Gate : Gates)
+	{
+		if (Mismatch.IsEmpty() && !TrackData->MatchesLine(INDEX_NONE, UOMRTrackData::MakeLineData(Gate->GetTrigger(), Gate, Gate->bFlipCrossingDirection)))
+		{
+			Mismatch = Gate->GetName();
+		}
+	}
+
+	if (Mismatch.IsEmpty()) return;
+
+	UE_LOG(LogTemp, Warning, TEXT("%s is out of date (%s differs), timing from the placed checkpoints. Rerun OMRCompileTracks."),
+		*TrackData->GetName(), *Mismatch);
+
+	TrackData = nullptr;
+}
+
+bool UOMRCheckpointRegistry::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OMRCheckpointRegistry.generated.h"
+
+class AOMRCheckpoint;
+class AOMRStartFinishGate;
+class UOMRTrackData;
+
+/**
+ * Checkpoints and gates of the current track, registered by the actors themselves on
+ * BeginPlay/EndPlay so checkpoints in levels streamed in later are picked up.
+ *
+ * Checkpoints are kept in CheckpointIndex order, one slot per index. Missing indices and
+ * duplicates are tracked as actors come and go, IsValidLayout says whether the track
+ * can currently be raced as placed.
+ *
+ * Also holds the map's baked UOMRTrackData, which describes every checkpoint whether
+ * its level is loaded or not. It is dropped as soon as a registered checkpoint or gate
+ * doesn't match it, so a map edited since the last bake is timed as placed.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRCheckpointRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Null if the map was never compiled (see UOMRCompileTracksCommandlet) or changed since
+	const UOMRTrackData* GetTrackData() const { return TrackData; }
+
+	DECLARE_MULTICAST_DELEGATE(FOnChanged);
+
+	// Any checkpoint or gate added or removed
+	FOnChanged OnChanged;
+
+	void RegisterCheckpoint(AOMRCheckpoint* Checkpoint);
+	void UnregisterCheckpoint(AOMRCheckpoint* Checkpoint);
+
+	void RegisterGate(AOMRStartFinishGate* Gate);
+	void UnregisterGate(AOMRStartFinishGate* Gate);
+
+	// Highest registered index + 1, including any gaps
+	int32 NumCheckpoints() const { return Checkpoints.Num(); }
+
+	// Null for an index nothing has registered (yet)
+	AOMRCheckpoint* GetCheckpoint(int32 CheckpointIndex) const;
+
+	TConstArrayView<TObjectPtr<AOMRStartFinishGate>> GetGates() const { return Gates; }
+
+	int32 NumGaps() const { return Checkpoints.Num() - NumFilled; }
+	int32 NumDuplicates() const { return Duplicates.Num(); }
+	bool IsValidLayout() const { return NumGaps() == 0 && Duplicates.Num() == 0; }
+
+	template <typename FunctionType>
+	void ForEachCheckpoint(FunctionType&& Function) const
+	{
+		for (AOMRCheckpoint* Checkpoint : Checkpoints)
+		{
+			if (Checkpoint)
+			{
+				Function(Checkpoint);
+			}
+		}
+	}
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void TrimTrailingGaps();
+
+	// Drops TrackData if it doesn't match the registered actors
+	void ValidateTrackData();
+
+	UPROPERTY()
+	TArray<TObjectPtr<AOMRCheckpoint>> Checkpoints;
+
+	// Second and later checkpoints claiming a taken index, promoted if the slot frees up
+	UPROPERTY()
+	TArray<TObjectPtr<AOMRCheckpoint>> Duplicates;
+
+	UPROPERTY()
+	TArray<TObjectPtr<AOMRStartFinishGate>> Gates;
+
+	int32 NumFilled = 0;
+
+	UPROPERTY()
+	TObjectPtr<UOMRTrackData> TrackData;
+};
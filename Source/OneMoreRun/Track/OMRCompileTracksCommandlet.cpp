@@ -0,0 +1,417 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRCompileTracksCommandlet.h"
+#include "OMRTrackData.h"
+#include "OMRCheckpoint.h"
+#include "OMRStartFinishGate.h"
+#include "OMRTrackBounds.h"
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/Volume.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/FileManager.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace
+{
+	const FName PlayBoundsTag(TEXT("OMRPlayBounds"));
+
+	FVector GetLineNormal(const FOMRTrackLineData& Line)
+	{
+		return Line.TriggerTransform.GetUnitAxis(EAxis::X) * (Line.bFlipCrossingDirection ? -1.0 : 1.0);
+	}
+
+	// Uniform Catmull-Rom between P1 and P2
+	FVector CatmullRom(const FVector& P0, const FVector& P1, const FVector& P2, const FVector& P3, double T)
+	{
+		const double T2 = T * T;
+		const double T3 = T2 * T;
+
+		return 0.5 * ((2.0 * P1) +
+			(P2 - P0) * T +
+			(2.0 * P0 - 5.0 * P1 + 4.0 * P2 - P3) * T2 +
+			(3.0 * P1 - P0 - 3.0 * P2 + P3) * T3);
+	}
+}
+
+UOMRCompileTracksCommandlet::UOMRCompileTracksCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UOMRCompileTracksCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	float CenterlineSpacing = 200.f;
+	if (const FString* SpacingValue = ParamValues.Find(TEXT("CenterlineSpacing")))
+	{
+		CenterlineSpacing = FMath::Max(FCString::Atof(**SpacingValue), 10.f);
+	}
+
+	float KillZDepth = 2000.f;
+	if (const FString* DepthValue = ParamValues.Find(TEXT("KillZDepth")))
+	{
+		KillZDepth = FMath::Max(FCString::Atof(**DepthValue), 0.f);
+	}
+
+	TArray<FString> PackageNames;
+
+	if (const FString* Map = ParamValues.Find(TEXT("Map")))
+	{
+		PackageNames.Add(*Map);
+	}
+	else
+	{
+		TArray<FString> MapFiles;
+		IFileManager::Get().FindFilesRecursive(MapFiles, *(FPaths::ProjectContentDir() / TEXT("Maps")), TEXT("*.umap"), true, false);
+
+		for (const FString& MapFile : MapFiles)
+		{
+			FString PackageName;
+			if (FPackageName::TryConvertFilenameToLongPackageName(MapFile, PackageName))
+			{
+				PackageNames.Add(PackageName);
+			}
+		}
+	}
+
+	int32 NumFailed = 0;
+
+	for (const FString& PackageName : PackageNames)
+	{
+		if (!CompileMap(PackageName, CenterlineSpacing, KillZDepth))
+		{
+			++NumFailed;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Compiled %d tracks, %d failed."), PackageNames.Num() - NumFailed, NumFailed);
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+bool UOMRCompileTracksCommandlet::CompileMap(const FString& PackageName, float CenterlineSpacing, float KillZDepth)
+{
+	UPackage* Package = LoadPackage(nullptr, *PackageName, LOAD_None);
+	UWorld* World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not load map %s."), *PackageName);
+		return false;
+	}
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Editor;
+
+	if (!World->bIsWorldInitialized)
+	{
+		World->InitWorld(UWorld::InitializationValues()
+			.AllowAudioPlayback(false)
+			.CreatePhysicsScene(false)
+			.RequiresHitProxies(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.ShouldSimulatePhysics(false));
+	}
+
+	World->UpdateWorldComponents(true, false);
+
+	const FString MapName = FPackageName::GetShortName(PackageName);
+
+	TArray<FString> Errors;
+
+	// -------------------------------------------------
+	// 1. Gate, spawn and checkpoints as placed
+	// -------------------------------------------------
+	TArray<const AOMRStartFinishGate*> Gates;
+	for (TActorIterator<AOMRStartFinishGate> It(World); It; ++It)
+	{
+		Gates.Add(*It);
+	}
+
+	TArray<const APlayerStart*> Spawns;
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Spawns.Add(*It);
+	}
+
+	TArray<const AOMRCheckpoint*> Checkpoints;
+	for (TActorIterator<AOMRCheckpoint> It(World); It; ++It)
+	{
+		const int32 Index = It->CheckpointIndex;
+
+		if (Index < 0)
+		{
+			Errors.Add(FString::Printf(TEXT("%s has negative CheckpointIndex %d."), *It->GetActorNameOrLabel(), Index));
+			continue;
+		}
+
+		if (Index >= Checkpoints.Num())
+		{
+			Checkpoints.SetNumZeroed(Index + 1);
+		}
+
+		if (Checkpoints[Index])
+		{
+			Errors.Add(FString::Printf(TEXT("%s and %s share CheckpointIndex %d."),
+				*Checkpoints[Index]->GetActorNameOrLabel(), *It->GetActorNameOrLabel(), Index));
+			continue;
+		}
+
+		Checkpoints[Index] = *It;
+	}
+
+	if (Gates.Num() != 1)
+	{
+		Errors.Add(FString::Printf(TEXT("Expected one start/finish gate, found %d."), Gates.Num()));
+	}
+
+	if (Spawns.Num() == 0)
+	{
+		Errors.Add(TEXT("No PlayerStart."));
+	}
+	else if (Spawns.Num() > 1)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s: %d PlayerStarts, using %s."), *MapName, Spawns.Num(), *Spawns[0]->GetActorNameOrLabel());
+	}
+
+	for (int32 Index = 0; Index < Checkpoints.Num(); ++Index)
+	{
+		if (!Checkpoints[Index])
+		{
+			Errors.Add(FString::Printf(TEXT("No checkpoint with CheckpointIndex %d."), Index));
+		}
+	}
+
+	UOMRTrackData* Data = nullptr;
+
+	if (Errors.Num() == 0)
+	{
+		Data = NewObject<UOMRTrackData>(GetTransientPackage());
+
+		Data->Gate = UOMRTrackData::MakeLineData(Gates[0]->GetTrigger(), Gates[0], Gates[0]->bFlipCrossingDirection);
+		Data->SpawnTransform = Spawns[0]->GetActorTransform();
+
+		for (const AOMRCheckpoint* CP : Checkpoints)
+		{
+			Data->Checkpoints.Add(UOMRTrackData::MakeLineData(CP->Trigger, CP, CP->bFlipCrossingDirection));
+		}
+
+		Data->LayoutHash = UOMRTrackData::HashLayout(Data->Gate, Data->Checkpoints);
+
+		// -------------------------------------------------
+		// 2. Racing line through the timing lines, in lap order
+		// -------------------------------------------------
+		TArray<FVector> Points;
+		TArray<FVector> Normals;
+
+		Points.Add(Data->Gate.TriggerTransform.GetLocation());
+		Normals.Add(GetLineNormal(Data->Gate));
+
+		for (const FOMRTrackLineData& Line : Data->Checkpoints)
+		{
+			Points.Add(Line.TriggerTransform.GetLocation());
+			Normals.Add(GetLineNormal(Line));
+		}
+
+		const int32 NumPoints = Points.Num();
+
+		if (NumPoints >= 3)
+		{
+			for (int32 Index = 0; Index < NumPoints; ++Index)
+			{
+				const FVector Tangent = Points[(Index + 1) % NumPoints] - Points[(Index + NumPoints - 1) % NumPoints];
+
+				if (FVector::DotProduct(Tangent, Normals[Index]) <= 0.0)
+				{
+					Errors.Add(FString::Printf(TEXT("%s faces against the racing line, toggle bFlipCrossingDirection."),
+						Index == 0 ? TEXT("Gate") : *FString::Printf(TEXT("Checkpoint %d"), Index - 1)));
+				}
+			}
+
+			// -------------------------------------------------
+			// 3. Sector lengths and a resampled centerline
+			// -------------------------------------------------
+			const int32 SubSteps = 64;
+
+			TArray<FVector> Dense;
+			TArray<double> DenseDistance;
+			Dense.Reserve(NumPoints * SubSteps + 1);
+			DenseDistance.Reserve(NumPoints * SubSteps + 1);
+
+			Dense.Add(Points[0]);
+			DenseDistance.Add(0.0);
+
+			for (int32 Segment = 0; Segment < NumPoints; ++Segment)
+			{
+				const FVector& P0 = Points[(Segment + NumPoints - 1) % NumPoints];
+				const FVector& P1 = Points[Segment];
+				const FVector& P2 = Points[(Segment + 1) % NumPoints];
+				const FVector& P3 = Points[(Segment + 2) % NumPoints];
+
+				const double SegmentStart = DenseDistance.Last();
+
+				for (int32 Step = 1; Step <= SubSteps; ++Step)
+				{
+					const FVector Point = CatmullRom(P0, P1, P2, P3, (double)Step / SubSteps);
+					DenseDistance.Add(DenseDistance.Last() + FVector::Distance(Dense.Last(), Point));
+					Dense.Add(Point);
+				}
+
+				Data->SectorLengths.Add((float)(DenseDistance.Last() - SegmentStart));
+			}
+
+			Data->TrackLength = (float)DenseDistance.Last();
+			Data->CenterlineSpacing = CenterlineSpacing;
+
+			int32 DenseIndex = 1;
+			for (double Distance = 0.0; Distance < DenseDistance.Last(); Distance += CenterlineSpacing)
+			{
+				while (DenseDistance[DenseIndex] < Distance)
+				{
+					++DenseIndex;
+				}
+
+				const double SpanLength = DenseDistance[DenseIndex] - DenseDistance[DenseIndex - 1];
+				const double Alpha = SpanLength > UE_KINDA_SMALL_NUMBER ? (Distance - DenseDistance[DenseIndex - 1]) / SpanLength : 0.0;
+
+				Data->Centerline.Add(FVector3f(FMath::Lerp(Dense[DenseIndex - 1], Dense[DenseIndex], Alpha)));
+			}
+		}
+		else
+		{
+			// Still one length per sector, so splits and progress line up with Checkpoints
+			for (int32 Segment = 0; Segment < NumPoints; ++Segment)
+			{
+				Data->SectorLengths.Add((float)FVector::Distance(Points[Segment], Points[(Segment + 1) % NumPoints]));
+				Data->TrackLength += Data->SectorLengths.Last();
+			}
+
+			UE_LOG(LogTemp, Warning, TEXT("%s: %d checkpoints, too few for a centerline, sectors are straight distances."), *MapName, Checkpoints.Num());
+		}
+
+		// -------------------------------------------------
+		// 4. Out of bounds: kill plane and play volumes
+		// -------------------------------------------------
+		float LowestZ = (float)Data->SpawnTransform.GetLocation().Z;
+
+		for (const FVector& Point : Points)
+		{
+			LowestZ = FMath::Min(LowestZ, (float)Point.Z);
+		}
+
+		for (const FVector3f& Point : Data->Centerline)
+		{
+			LowestZ = FMath::Min(LowestZ, Point.Z);
+		}
+
+		const AWorldSettings* WorldSettings = World->GetWorldSettings();
+		const float WorldKillZ = WorldSettings && WorldSettings->bEnableWorldBoundsChecks ? WorldSettings->KillZ : -UE_BIG_NUMBER;
+
+		Data->KillZ = FMath::Max(LowestZ - KillZDepth, WorldKillZ);
+
+		for (TActorIterator<AVolume> It(World); It; ++It)
+		{
+			if (It->ActorHasTag(PlayBoundsTag))
+			{
+				Data->PlayBounds.Add(It->GetComponentsBoundingBox(true));
+			}
+		}
+
+		// The ball has to start and time inside the bounds it is held to
+		if (Data->PlayBounds.Num() > 0)
+		{
+			FOMRTrackBounds Bounds;
+			Bounds.SetKillZ(Data->KillZ);
+
+			for (const FBox& Box : Data->PlayBounds)
+			{
+				Bounds.AddVolume(Box);
+			}
+
+			for (int32 Index = 0; Index < Points.Num(); ++Index)
+			{
+				if (!Bounds.IsInside(Points[Index]))
+				{
+					Errors.Add(FString::Printf(TEXT("%s is outside every %s volume."),
+						Index == 0 ? TEXT("Gate") : *FString::Printf(TEXT("Checkpoint %d"), Index - 1), *PlayBoundsTag.ToString()));
+				}
+			}
+
+			if (!Bounds.IsInside(Data->SpawnTransform.GetLocation()))
+			{
+				Errors.Add(FString::Printf(TEXT("PlayerStart is outside every %s volume."), *PlayBoundsTag.ToString()));
+			}
+		}
+	}
+
+	bool bSuccess = false;
+
+	if (Errors.Num() > 0)
+	{
+		for (const FString& Error : Errors)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: %s"), *MapName, *Error);
+		}
+	}
+	else
+	{
+		// -------------------------------------------------
+		// 5. Write /Game/TrackData/<Map>_TrackData
+		// -------------------------------------------------
+		const FString AssetPackageName = UOMRTrackData::GetAssetPackageName(MapName);
+		const FString AssetName = FPackageName::GetShortName(AssetPackageName);
+
+		UPackage* AssetPackage = CreatePackage(*AssetPackageName);
+		AssetPackage->FullyLoad();
+
+		// Overwrite in place so references to an earlier bake stay valid
+		UOMRTrackData* Asset = FindObject<UOMRTrackData>(AssetPackage, *AssetName);
+		if (!Asset)
+		{
+			Asset = NewObject<UOMRTrackData>(AssetPackage, *AssetName, RF_Public | RF_Standalone);
+		}
+
+		UEngine::CopyPropertiesForUnrelatedObjects(Data, Asset);
+		AssetPackage->MarkPackageDirty();
+
+		const FString Filename = FPackageName::LongPackageNameToFilename(AssetPackageName, FPackageName::GetAssetPackageExtension());
+
+		FSavePackageArgs SaveArgs;
+		SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+		SaveArgs.SaveFlags = SAVE_NoError;
+
+		bSuccess = UPackage::SavePackage(AssetPackage, Asset, *Filename, SaveArgs);
+
+		if (bSuccess)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%s: %d checkpoints, %.0f cm, %d centerline points, KillZ %.0f, %d play volumes to %s."),
+				*MapName, Asset->Checkpoints.Num(), Asset->TrackLength, Asset->Centerline.Num(), Asset->KillZ, Asset->PlayBounds.Num(), *Filename);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s: failed to write %s."), *MapName, *Filename);
+		}
+	}
+
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	return bSuccess;
+}
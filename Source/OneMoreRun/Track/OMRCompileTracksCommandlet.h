@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "OMRCompileTracksCommandlet.generated.h"
+
+/**
+ * Validates track maps and bakes their metadata into a UOMRTrackData asset.
+ *
+ * UnrealEditor-Cmd OneMoreRun.uproject -run=OMRCompileTracks [-Map=/Game/Maps/L_TestGym] [-CenterlineSpacing=200] [-KillZDepth=2000]
+ *
+ * Without -Map every map under /Game/Maps is compiled. KillZ ends up KillZDepth below the
+ * lowest point of the centerline, unless the world's own KillZ is higher. A map fails on a missing or extra
+ * gate, a missing spawn, checkpoint index gaps or duplicates, or a timing line facing
+ * against the racing line. Returns non-zero if any map failed.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRCompileTracksCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UOMRCompileTracksCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool CompileMap(const FString& PackageName, float CenterlineSpacing, float KillZDepth);
+};
@@ -4,6 +4,7 @@
 #include "OMRStartFinishGate.h"
 #include "Components/BoxComponent.h"
 #include "../Game/OMRTimeTrialGameState.h"
+#include "OMRCheckpointRegistry.h"
 
 // Sets default values
 AOMRStartFinishGate::AOMRStartFinishGate()
@@ -20,9 +21,33 @@ void AOMRStartFinishGate::BeginPlay()
 	Super::BeginPlay();
 	UE_LOG(LogTemp, Warning, TEXT("Gate BeginPlay Called"));
 
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		Registry->RegisterGate(this);
+	}
+
+	// Game state times the gate from its timing line
+	const AOMRTimeTrialGameState* GS = GetWorld()->GetGameState<AOMRTimeTrialGameState>();
+	if (GS && GS->bUseTimingLines)
+	{
+		Trigger->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Trigger->SetGenerateOverlapEvents(false);
+		return;
+	}
+
 	Trigger->OnComponentBeginOverlap.AddDynamic(this, &AOMRStartFinishGate::OnOverlapBegin);
 }
 
+void AOMRStartFinishGate::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UOMRCheckpointRegistry* Registry = GetWorld()->GetSubsystem<UOMRCheckpointRegistry>())
+	{
+		Registry->UnregisterGate(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AOMRStartFinishGate::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
 	UE_LOG(LogTemp, Warning, TEXT("Gate Overlap Triggered"));
@@ -17,12 +17,19 @@ public:
 	// Sets default values for this actor's properties
 	AOMRStartFinishGate();
 
+	UBoxComponent* GetTrigger() const { return Trigger; }
+
+	// Forward through the timing line is the trigger's +X; flip if the gate faces against the racing line
+	UPROPERTY(EditInstanceOnly, Category = "Gate")
+	bool bFlipCrossingDirection = false;
+
 protected:
 	UPROPERTY(VisibleAnywhere)
 	UBoxComponent* Trigger;
 
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UFUNCTION()
 	void OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTimingLines.h"
+#include "Components/BoxComponent.h"
+#include "GameFramework/Actor.h"
+#include "Algo/Sort.h"
+
+int32 FOMRTimingLines::AddFromBox(const UBoxComponent* Box, int32 CheckpointIndex, bool bFlipDirection)
+{
+	if (!Box) return INDEX_NONE;
+
+	const FTransform Transform = Box->GetComponentTransform();
+	const int32 Index = Add(Transform, Box->GetScaledBoxExtent(), CheckpointIndex, bFlipDirection,
+		Box->GetOwner() ? Box->GetOwner()->GetActorTransform() : Transform);
+
+	Lines[Index].Actor = Box->GetOwner();
+
+	return Index;
+}
+
+int32 FOMRTimingLines::Add(const FTransform& BoxTransform, const FVector& ScaledExtent, int32 CheckpointIndex, bool bFlipDirection, const FTransform& OwnerTransform)
+{
+	FOMRTimingLine& Line = Lines.AddDefaulted_GetRef();
+	Line.Origin = BoxTransform.GetLocation();
+	Line.Normal = BoxTransform.GetUnitAxis(EAxis::X) * (bFlipDirection ? -1.0 : 1.0);
+	Line.AxisY = BoxTransform.GetUnitAxis(EAxis::Y);
+	Line.AxisZ = BoxTransform.GetUnitAxis(EAxis::Z);
+	Line.HalfWidth = ScaledExtent.Y;
+	Line.HalfHeight = ScaledExtent.Z;
+	Line.CheckpointIndex = CheckpointIndex;
+	Line.Transform = OwnerTransform;
+
+	return Lines.Num() - 1;
+}
+
+void FOMRTimingLines::Test(TConstArrayView<FOMRBallPathSample> Path, double Radius, TArray<FOMRTimingCrossing, TInlineAllocator<4>>& OutCrossings) const
+{
+	const int32 FirstNew = OutCrossings.Num();
+
+	for (int32 SegmentIndex = 1; SegmentIndex < Path.Num(); ++SegmentIndex)
+	{
+		const FOMRBallPathSample& A = Path[SegmentIndex - 1];
+		const FOMRBallPathSample& B = Path[SegmentIndex];
+
+		for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			const FOMRTimingLine& Line = Lines[LineIndex];
+
+			const double DistA = FVector::DotProduct(A.Position - Line.Origin, Line.Normal);
+			const double DistB = FVector::DotProduct(B.Position - Line.Origin, Line.Normal);
+
+			// Counts once: leaving the negative side, or entering it
+			if ((DistA < 0.0) == (DistB < 0.0)) continue;
+
+			const double Alpha = DistA / (DistA - DistB);
+			const FVector Local = A.Position + (B.Position - A.Position) * Alpha - Line.Origin;
+
+			if (FMath::Abs(FVector::DotProduct(Local, Line.AxisY)) > Line.HalfWidth + Radius ||
+				FMath::Abs(FVector::DotProduct(Local, Line.AxisZ)) > Line.HalfHeight + Radius)
+			{
+				continue;
+			}
+
+			FOMRTimingCrossing& Crossing = OutCrossings.AddDefaulted_GetRef();
+			Crossing.LineIndex = LineIndex;
+			Crossing.Time = A.Time + (B.Time - A.Time) * Alpha;
+			Crossing.bForward = DistA < 0.0;
+		}
+	}
+
+	// Lines crossed within one segment come out in line order
+	if (OutCrossings.Num() - FirstNew > 1)
+	{
+		Algo::Sort(MakeArrayView(OutCrossings.GetData() + FirstNew, OutCrossings.Num() - FirstNew),
+			[](const FOMRTimingCrossing& L, const FOMRTimingCrossing& R) { return L.Time < R.Time; });
+	}
+}
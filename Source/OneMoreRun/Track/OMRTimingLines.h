@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UBoxComponent;
+
+// Ball centre at one point on the race clock, see AOMRPlayerPawn::GetBallPath
+struct FOMRBallPathSample
+{
+	FVector Position = FVector::ZeroVector;
+	double Time = 0.0;
+};
+
+// Bounded plane the ball has to pass through, Normal points in the racing direction
+struct FOMRTimingLine
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Normal = FVector::ForwardVector;
+	FVector AxisY = FVector::RightVector;
+	FVector AxisZ = FVector::UpVector;
+	double HalfWidth = 0.0;
+	double HalfHeight = 0.0;
+
+	// INDEX_NONE for the start/finish line
+	int32 CheckpointIndex = INDEX_NONE;
+
+	FTransform Transform;
+	TWeakObjectPtr<AActor> Actor;
+};
+
+struct FOMRTimingCrossing
+{
+	int32 LineIndex = INDEX_NONE;
+
+	// Interpolated along the segment, on the race clock
+	double Time = 0.0;
+
+	// Crossed along Normal rather than against it
+	bool bForward = true;
+};
+
+/**
+ * Analytic replacement for the gate and checkpoint overlap triggers: the ball's swept path
+ * (one segment per physics step) is intersected with every line in one pass, giving a
+ * crossing time between steps instead of at frame granularity.
+ */
+class ONEMORERUN_API FOMRTimingLines
+{
+public:
+	void Reset() { Lines.Reset(); }
+
+	// Plane through the box centre facing its X axis (reversed with bFlipDirection), sized by its Y/Z extent
+	int32 AddFromBox(const UBoxComponent* Box, int32 CheckpointIndex, bool bFlipDirection);
+
+	// Same from a baked box (see UOMRTrackData), OwnerTransform is what a crossing reports
+	int32 Add(const FTransform& BoxTransform, const FVector& ScaledExtent, int32 CheckpointIndex, bool bFlipDirection, const FTransform& OwnerTransform);
+
+	int32 Num() const { return Lines.Num(); }
+	const FOMRTimingLine& GetLine(int32 Index) const { return Lines[Index]; }
+
+	// Appends every crossing of Path, sorted by time. Radius widens the lines like an overlap would.
+	void Test(TConstArrayView<FOMRBallPathSample> Path, double Radius, TArray<FOMRTimingCrossing, TInlineAllocator<4>>& OutCrossings) const;
+
+private:
+	TArray<FOMRTimingLine> Lines;
+};
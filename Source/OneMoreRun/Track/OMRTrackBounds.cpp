@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTrackBounds.h"
+
+void FOMRTrackBounds::Reset()
+{
+	KillZ = -UE_BIG_NUMBER;
+	Volumes.Reset();
+}
+
+void FOMRTrackBounds::AddVolume(const FBox& Volume)
+{
+	if (Volume.IsValid)
+	{
+		Volumes.Add(FBox3f(Volume));
+	}
+}
+
+bool FOMRTrackBounds::IsInside(const FVector& Location) const
+{
+	if (Location.Z < KillZ) return false;
+
+	if (Volumes.Num() == 0) return true;
+
+	const FVector3f Point(Location);
+
+	for (const FBox3f& Volume : Volumes)
+	{
+		if (Volume.IsInsideOrOn(Point)) return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Where the ball is allowed to be: above KillZ and, if the track has any, inside one of its
+ * play volumes. A handful of plane and box tests, cheap enough for every physics step.
+ */
+class ONEMORERUN_API FOMRTrackBounds
+{
+public:
+	void Reset();
+
+	void SetKillZ(float InKillZ) { KillZ = InKillZ; }
+	void AddVolume(const FBox& Volume);
+
+	bool IsValid() const { return KillZ > -UE_BIG_NUMBER || Volumes.Num() > 0; }
+
+	bool IsInside(const FVector& Location) const;
+
+	float GetKillZ() const { return KillZ; }
+	int32 NumVolumes() const { return Volumes.Num(); }
+
+private:
+	float KillZ = -UE_BIG_NUMBER;
+
+	// None means only KillZ applies
+	TArray<FBox3f> Volumes;
+};
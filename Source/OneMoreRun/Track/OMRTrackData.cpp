@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTrackData.h"
+#include "Components/BoxComponent.h"
+#include "Misc/PackageName.h"
+
+namespace
+{
+	uint32 HashVector(const FVector& Vector, double Step, uint32 Hash)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(FMath::RoundToInt64(Vector.X / Step)));
+		Hash = HashCombineFast(Hash, GetTypeHash(FMath::RoundToInt64(Vector.Y / Step)));
+		return HashCombineFast(Hash, GetTypeHash(FMath::RoundToInt64(Vector.Z / Step)));
+	}
+
+	uint32 HashTransform(const FTransform& Transform, uint32 Hash)
+	{
+		// Q and -Q are the same rotation
+		FQuat Rotation = Transform.GetRotation().GetNormalized();
+		if (Rotation.W < 0.0)
+		{
+			Rotation *= -1.0;
+		}
+
+		Hash = HashVector(Transform.GetLocation(), 1.0, Hash);
+		Hash = HashVector(FVector(Rotation.X, Rotation.Y, Rotation.Z), 0.001, Hash);
+		return HashVector(Transform.GetScale3D(), 0.001, Hash);
+	}
+}
+
+uint32 UOMRTrackData::HashLine(const FOMRTrackLineData& Line, int32 CheckpointIndex)
+{
+	uint32 Hash = GetTypeHash(CheckpointIndex);
+	Hash = HashTransform(Line.TriggerTransform, Hash);
+	Hash = HashVector(Line.Extent, 1.0, Hash);
+	Hash = HashCombineFast(Hash, GetTypeHash(Line.bFlipCrossingDirection));
+	return HashTransform(Line.ActorTransform, Hash);
+}
+
+uint32 UOMRTrackData::HashLayout(const FOMRTrackLineData& Gate, TConstArrayView<FOMRTrackLineData> Checkpoints)
+{
+	uint32 Hash = HashLine(Gate, INDEX_NONE);
+
+	for (int32 Index = 0; Index < Checkpoints.Num(); ++Index)
+	{
+		Hash = HashCombineFast(Hash, HashLine(Checkpoints[Index], Index));
+	}
+
+	return Hash;
+}
+
+FOMRTrackLineData UOMRTrackData::MakeLineData(const UBoxComponent* Trigger, const AActor* Owner, bool bFlipCrossingDirection)
+{
+	FOMRTrackLineData Line;
+	Line.TriggerTransform = Trigger->GetComponentTransform();
+	Line.Extent = Trigger->GetScaledBoxExtent();
+	Line.bFlipCrossingDirection = bFlipCrossingDirection;
+	Line.ActorTransform = Owner->GetActorTransform();
+	return Line;
+}
+
+bool UOMRTrackData::MatchesLine(int32 CheckpointIndex, const FOMRTrackLineData& Line) const
+{
+	const FOMRTrackLineData* Baked = CheckpointIndex == INDEX_NONE ? &Gate :
+		Checkpoints.IsValidIndex(CheckpointIndex) ? &Checkpoints[CheckpointIndex] : nullptr;
+
+	return Baked && HashLine(*Baked, CheckpointIndex) == HashLine(Line, CheckpointIndex);
+}
+
+FString UOMRTrackData::GetAssetPackageName(const FString& MapName)
+{
+	return FString::Printf(TEXT("/Game/TrackData/%s_TrackData"), *MapName);
+}
+
+UOMRTrackData* UOMRTrackData::LoadForMap(const FString& MapName)
+{
+	const FString PackageName = GetAssetPackageName(MapName);
+
+	if (!FPackageName::DoesPackageExist(PackageName)) return nullptr;
+
+	const FString ObjectPath = PackageName + TEXT(".") + FPackageName::GetShortName(PackageName);
+
+	return LoadObject<UOMRTrackData>(nullptr, *ObjectPath, nullptr, LOAD_NoWarning);
+}
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OMRTrackData.generated.h"
+
+class UBoxComponent;
+
+// Trigger box of a gate or checkpoint as placed in the map
+USTRUCT()
+struct FOMRTrackLineData
+{
+	GENERATED_BODY()
+
+	// Box component transform and scaled extent, the timing line is its X facing plane
+	UPROPERTY(VisibleAnywhere)
+	FTransform TriggerTransform;
+
+	UPROPERTY(VisibleAnywhere)
+	FVector Extent = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere)
+	bool bFlipCrossingDirection = false;
+
+	// Owning actor, the respawn transform for checkpoints
+	UPROPERTY(VisibleAnywhere)
+	FTransform ActorTransform;
+};
+
+/**
+ * Track metadata baked offline by UOMRCompileTracksCommandlet, one asset per map under
+ * /Game/TrackData, so none of it is rediscovered at level load.
+ *
+ * Sectors run gate -> checkpoint 0 -> ... -> last checkpoint -> gate along Centerline.
+ *
+ * LayoutHash covers the gate and checkpoint lines as baked. UOMRCheckpointRegistry drops the
+ * asset when a placed checkpoint or gate no longer matches it, timing falls back to the actors.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRTrackData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	FOMRTrackLineData Gate;
+
+	// In CheckpointIndex order, no gaps
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	TArray<FOMRTrackLineData> Checkpoints;
+
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	FTransform SpawnTransform;
+
+	// Checkpoints.Num() + 1 lengths in cm, last one ends at the gate. Straight distances
+	// between the lines when there are too few checkpoints for a centerline
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	TArray<float> SectorLengths;
+
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	float TrackLength = 0.f;
+
+	// Closed loop starting at the gate, CenterlineSpacing apart. Empty below 2 checkpoints
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	TArray<FVector3f> Centerline;
+
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	float CenterlineSpacing = 0.f;
+
+	// Out of bounds below this, the world KillZ or KillZDepth under the lowest centerline point
+	UPROPERTY(VisibleAnywhere, Category = "Bounds")
+	float KillZ = -UE_BIG_NUMBER;
+
+	// Boxes of the volumes tagged OMRPlayBounds, empty if the map has none
+	UPROPERTY(VisibleAnywhere, Category = "Bounds")
+	TArray<FBox> PlayBounds;
+
+	// HashLayout(Gate, Checkpoints) at bake time
+	UPROPERTY(VisibleAnywhere, Category = "Track")
+	uint32 LayoutHash = 0;
+
+	// Index, transforms and extent rounded to a centimetre, so only real moves change it.
+	// CheckpointIndex is INDEX_NONE for the gate
+	static uint32 HashLine(const FOMRTrackLineData& Line, int32 CheckpointIndex);
+	static uint32 HashLayout(const FOMRTrackLineData& Gate, TConstArrayView<FOMRTrackLineData> Checkpoints);
+
+	static FOMRTrackLineData MakeLineData(const UBoxComponent* Trigger, const AActor* Owner, bool bFlipCrossingDirection);
+
+	// Line is where the gate or checkpoint is placed now, false if it moved since the bake
+	bool MatchesLine(int32 CheckpointIndex, const FOMRTrackLineData& Line) const;
+
+	// /Game/TrackData/<Map>_TrackData
+	static FString GetAssetPackageName(const FString& MapName);
+
+	// Null if the map was never compiled
+	static UOMRTrackData* LoadForMap(const FString& MapName);
+};
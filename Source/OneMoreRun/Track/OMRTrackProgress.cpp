@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTrackProgress.h"
+
+void FOMRTrackProgress::Reset()
+{
+	Points.Reset();
+	Distances.Reset();
+	Length = 0.f;
+	GridSizeX = 0;
+	GridSizeY = 0;
+	CellStarts.Reset();
+	SegmentIndices.Reset();
+}
+
+void FOMRTrackProgress::Build(TConstArrayView<FVector> InPoints, float CellSize)
+{
+	Reset();
+
+	if (InPoints.Num() < 2) return;
+
+	Points.Append(InPoints.GetData(), InPoints.Num());
+
+	const int32 NumSegments = Points.Num();
+
+	Distances.SetNumUninitialized(NumSegments + 1);
+	Distances[0] = 0.f;
+
+	FBox2D Bounds(ForceInit);
+
+	for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+	{
+		const FVector& A = Points[Segment];
+		const FVector& B = Points[(Segment + 1) % NumSegments];
+
+		Distances[Segment + 1] = Distances[Segment] + (float)FVector::Distance(A, B);
+		Bounds += FVector2D(A);
+	}
+
+	Length = Distances[NumSegments];
+
+	// -------------------------------------------------
+	// Grid over the track, every segment listed in the cells within MaxTrackDistance of it
+	// -------------------------------------------------
+	Bounds = Bounds.ExpandBy(MaxTrackDistance);
+
+	const FVector2D Size = Bounds.GetSize();
+	GridCellSize = FMath::Max(CellSize, (float)FMath::Sqrt(Size.X * Size.Y / (1024.0 * 1024.0)));
+	GridOrigin = Bounds.Min;
+	GridSizeX = FMath::Max(FMath::CeilToInt(Size.X / GridCellSize), 1);
+	GridSizeY = FMath::Max(FMath::CeilToInt(Size.Y / GridCellSize), 1);
+
+	auto ForEachCell = [this, NumSegments](int32 Segment, auto&& Function)
+	{
+		FBox2D SegmentBounds(ForceInit);
+		SegmentBounds += FVector2D(Points[Segment]);
+		SegmentBounds += FVector2D(Points[(Segment + 1) % NumSegments]);
+		SegmentBounds = SegmentBounds.ExpandBy(MaxTrackDistance);
+
+		const int32 MinX = FMath::Clamp(FMath::FloorToInt((SegmentBounds.Min.X - GridOrigin.X) / GridCellSize), 0, GridSizeX - 1);
+		const int32 MinY = FMath::Clamp(FMath::FloorToInt((SegmentBounds.Min.Y - GridOrigin.Y) / GridCellSize), 0, GridSizeY - 1);
+		const int32 MaxX = FMath::Clamp(FMath::FloorToInt((SegmentBounds.Max.X - GridOrigin.X) / GridCellSize), 0, GridSizeX - 1);
+		const int32 MaxY = FMath::Clamp(FMath::FloorToInt((SegmentBounds.Max.Y - GridOrigin.Y) / GridCellSize), 0, GridSizeY - 1);
+
+		for (int32 Y = MinY; Y <= MaxY; ++Y)
+		{
+			for (int32 X = MinX; X <= MaxX; ++X)
+			{
+				Function(Y * GridSizeX + X);
+			}
+		}
+	};
+
+	CellStarts.SetNumZeroed(GridSizeX * GridSizeY + 1);
+
+	for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+	{
+		ForEachCell(Segment, [this](int32 Cell) { CellStarts[Cell + 1]++; });
+	}
+
+	for (int32 Cell = 0; Cell < GridSizeX * GridSizeY; ++Cell)
+	{
+		CellStarts[Cell + 1] += CellStarts[Cell];
+	}
+
+	SegmentIndices.SetNumUninitialized(CellStarts.Last());
+
+	TArray<int32> Cursor(CellStarts.GetData(), GridSizeX * GridSizeY);
+
+	for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+	{
+		ForEachCell(Segment, [this, &Cursor, Segment](int32 Cell) { SegmentIndices[Cursor[Cell]++] = Segment; });
+	}
+}
+
+bool FOMRTrackProgress::Query(const FVector& Location, float& OutDistance) const
+{
+	if (!IsValid()) return false;
+
+	const int32 X = FMath::FloorToInt((Location.X - GridOrigin.X) / GridCellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - GridOrigin.Y) / GridCellSize);
+
+	if (X < 0 || Y < 0 || X >= GridSizeX || Y >= GridSizeY) return false;
+
+	const int32 Cell = Y * GridSizeX + X;
+	const int32 NumSegments = Points.Num();
+
+	double BestDistSq = FMath::Square((double)MaxTrackDistance);
+	int32 BestSegment = INDEX_NONE;
+	FVector BestPoint = FVector::ZeroVector;
+
+	for (int32 Entry = CellStarts[Cell]; Entry < CellStarts[Cell + 1]; ++Entry)
+	{
+		const int32 Segment = SegmentIndices[Entry];
+
+		const FVector Closest = FMath::ClosestPointOnSegment(Location, Points[Segment], Points[(Segment + 1) % NumSegments]);
+		const double DistSq = FVector::DistSquared(Location, Closest);
+
+		if (DistSq < BestDistSq)
+		{
+			BestDistSq = DistSq;
+			BestSegment = Segment;
+			BestPoint = Closest;
+		}
+	}
+
+	if (BestSegment == INDEX_NONE) return false;
+
+	OutDistance = FMath::Fmod(Distances[BestSegment] + (float)FVector::Distance(Points[BestSegment], BestPoint), Length);
+
+	return true;
+}
+
+int32 FOMRTrackProgress::GetAllocatedSize() const
+{
+	return Points.GetAllocatedSize() + Distances.GetAllocatedSize() + CellStarts.GetAllocatedSize() + SegmentIndices.GetAllocatedSize();
+}
+
+void FOMRProgressCurve::Init(float TrackLength, float InStep)
+{
+	Step = FMath::Max(InStep, 1.f);
+	Times.SetNumUninitialized(FMath::FloorToInt(TrackLength / Step) + 1);
+	Reset();
+}
+
+void FOMRProgressCurve::Reset()
+{
+	NumReached = 0;
+	LastDistance = 0.f;
+	LastTime = 0.f;
+}
+
+void FOMRProgressCurve::Advance(float Distance, float Time)
+{
+	if (Times.Num() == 0) return;
+
+	if (NumReached == 0)
+	{
+		Times[0] = Time;
+		NumReached = 1;
+		LastDistance = 0.f;
+		LastTime = Time;
+	}
+
+	if (Distance <= LastDistance) return;
+
+	// Every step boundary passed since the last call, interpolated between the two
+	while (NumReached < Times.Num() && NumReached * Step <= Distance)
+	{
+		const float Alpha = (NumReached * Step - LastDistance) / (Distance - LastDistance);
+		Times[NumReached++] = FMath::Lerp(LastTime, Time, Alpha);
+	}
+
+	LastDistance = Distance;
+	LastTime = Time;
+}
+
+float FOMRProgressCurve::GetTimeAt(float Distance) const
+{
+	if (NumReached == 0) return 0.f;
+	if (NumReached == 1) return Times[0];
+
+	const float Position = FMath::Clamp(Distance / Step, 0.f, (float)(NumReached - 1));
+	const int32 Index = FMath::Min(FMath::FloorToInt(Position), NumReached - 2);
+
+	return FMath::Lerp(Times[Index], Times[Index + 1], Position - Index);
+}
+
+bool FOMRLapProgressTracker::Update(const FOMRTrackProgress& Progress, const FVector& Location)
+{
+	float Raw;
+	if (!Progress.Query(Location, Raw)) return false;
+
+	const float Length = Progress.GetLength();
+
+	// Shortest way round from where we were, so the start line never wraps
+	float Delta = Raw - FMath::Fmod(Distance, Length);
+	if (Delta > Length * 0.5f) Delta -= Length;
+	else if (Delta < -Length * 0.5f) Delta += Length;
+
+	Distance = FMath::Clamp(FMath::Max(Distance, Distance + Delta), 0.f, Length);
+
+	return true;
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Maps a world location to distance along the track centerline (a closed polyline starting
+ * at the gate). Segments are bucketed into a uniform XY grid, so a query only projects onto
+ * the handful of segments near the location, independent of track length.
+ *
+ * Grid storage is compact: per cell an offset into one flat segment index array.
+ */
+class ONEMORERUN_API FOMRTrackProgress
+{
+public:
+	// Locations further than this from the centerline are off track, Query fails
+	static constexpr float MaxTrackDistance = 3000.f;
+
+	void Reset();
+
+	// Points form a closed loop, Points[0] is distance 0
+	void Build(TConstArrayView<FVector> Points, float CellSize = 2000.f);
+
+	bool IsValid() const { return Points.Num() >= 2; }
+	float GetLength() const { return Length; }
+
+	// Distance along the centerline in [0, GetLength()) of the closest point to Location
+	bool Query(const FVector& Location, float& OutDistance) const;
+
+	int32 GetAllocatedSize() const;
+
+private:
+	TArray<FVector> Points;
+
+	// Distance at Points[i], one extra entry for the closing segment
+	TArray<float> Distances;
+
+	float Length = 0.f;
+
+	// XY grid, cell (X, Y) lists SegmentIndices[CellStarts[C] .. CellStarts[C + 1])
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	float GridCellSize = 0.f;
+	int32 GridSizeX = 0;
+	int32 GridSizeY = 0;
+	TArray<int32> CellStarts;
+	TArray<int32> SegmentIndices;
+};
+
+/**
+ * Time into a lap at which each distance step along the track was first reached. Built
+ * for the best lap from its ghost, so the live delta is CurrentLapTime - GetTimeAt(Distance).
+ */
+class ONEMORERUN_API FOMRProgressCurve
+{
+public:
+	void Init(float TrackLength, float Step);
+	void Reset();
+
+	// Feed progress in order, going backwards is ignored
+	void Advance(float Distance, float Time);
+
+	bool IsValid() const { return NumReached > 1; }
+	float GetReachedDistance() const { return (NumReached - 1) * Step; }
+
+	// Interpolated, clamped to the reached range
+	float GetTimeAt(float Distance) const;
+
+private:
+	TArray<float> Times;
+	float Step = 0.f;
+	int32 NumReached = 0;
+
+	float LastDistance = 0.f;
+	float LastTime = 0.f;
+};
+
+/**
+ * Unwraps FOMRTrackProgress queries over one lap: distance runs from 0 at the gate to the
+ * track length, never jumps across the start line and never decreases.
+ */
+struct FOMRLapProgressTracker
+{
+	float Distance = 0.f;
+
+	void Reset() { Distance = 0.f; }
+
+	// False if the location is off track, Distance is left as is
+	bool Update(const FOMRTrackProgress& Progress, const FVector& Location);
+};
@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTrackSurfaceField.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FOMRTrackSurfaceField::~FOMRTrackSurfaceField()
+{
+	Close();
+}
+
+bool FOMRTrackSurfaceField::Open(const FString& Filename)
+{
+	Close();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FOpenMappedResult MappedResult = PlatformFile.OpenMappedEx(*Filename);
+	if (MappedResult.HasValue())
+	{
+		MappedHandle = MappedResult.StealValue();
+		MappedRegion.Reset(MappedHandle->MapRegion(0, MappedHandle->GetFileSize()));
+
+		if (MappedRegion)
+		{
+			Data = MappedRegion->GetMappedPtr();
+			DataSize = MappedRegion->GetMappedSize();
+		}
+	}
+
+	if (!Data)
+	{
+		if (!FFileHelper::LoadFileToArray(LoadedBytes, *Filename, FILEREAD_Silent))
+		{
+			Close();
+			return false;
+		}
+
+		Data = LoadedBytes.GetData();
+		DataSize = LoadedBytes.Num();
+	}
+
+	// Validate before trusting any offsets
+	bool bValid = DataSize >= (int64)sizeof(FHeader);
+
+	if (bValid)
+	{
+		const FHeader& Header = GetHeader();
+		const int64 NumTableEntries = (int64)Header.NumTilesX * Header.NumTilesY;
+
+		// Exactly what Write produces, a truncated or padded file is rejected
+		bValid =
+			Header.Magic == Magic &&
+			Header.Version == Version &&
+			Header.TileCells == TileCells &&
+			Header.CellSize > 0.f &&
+			Header.NumTilesX >= 0 &&
+			Header.NumTilesY >= 0 &&
+			Header.NumTiles >= 0 &&
+			NumTableEntries <= MAX_int32 &&
+			Header.NumTiles <= NumTableEntries &&
+			DataSize == (int64)sizeof(FHeader) + NumTableEntries * (int64)sizeof(int32) + Header.NumTiles * TileBytes;
+
+		// Every tile a lookup can reach has to be inside the file
+		const int32* TileTable = bValid ? GetTileTable() : nullptr;
+
+		for (int64 Entry = 0; bValid && Entry < NumTableEntries; ++Entry)
+		{
+			const int32 Ordinal = TileTable[Entry];
+			bValid = Ordinal == INDEX_NONE || (Ordinal >= 0 && Ordinal < Header.NumTiles);
+		}
+	}
+
+	if (!bValid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Surface field %s is invalid or out of date."), *Filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FOMRTrackSurfaceField::Close()
+{
+	MappedRegion.Reset();
+	MappedHandle.Reset();
+	LoadedBytes.Empty();
+
+	Data = nullptr;
+	DataSize = 0;
+}
+
+const uint8* FOMRTrackSurfaceField::GetTile(int32 TileIndex) const
+{
+	const int32 Ordinal = GetTileTable()[TileIndex];
+	if (Ordinal < 0) return nullptr;
+
+	const FHeader& Header = GetHeader();
+	const int64 TilesOffset = sizeof(FHeader) + (int64)Header.NumTilesX * Header.NumTilesY * sizeof(int32);
+
+	return Data + TilesOffset + Ordinal * TileBytes;
+}
+
+FOMRTrackSurfaceField::ELookup FOMRTrackSurfaceField::Lookup(const FVector& Location, FSample& OutSample) const
+{
+	if (!Data) return ELookup::Fallback;
+
+	const FHeader& Header = GetHeader();
+
+	const double LocalX = (Location.X - Header.OriginX) / Header.CellSize;
+	const double LocalY = (Location.Y - Header.OriginY) / Header.CellSize;
+
+	const int64 CellX = FMath::FloorToInt64(LocalX);
+	const int64 CellY = FMath::FloorToInt64(LocalY);
+
+	if (CellX < 0 || CellY < 0 ||
+		CellX >= (int64)Header.NumTilesX * TileCells ||
+		CellY >= (int64)Header.NumTilesY * TileCells)
+	{
+		return ELookup::Fallback;
+	}
+
+	const int32 TileIndex = (int32)(CellY / TileCells) * Header.NumTilesX + (int32)(CellX / TileCells);
+
+	const uint8* Tile = GetTile(TileIndex);
+	if (!Tile) return ELookup::Empty;
+
+	const FTileHeader& TileHeader = *reinterpret_cast<const FTileHeader*>(Tile);
+	const FCell* Cells = reinterpret_cast<const FCell*>(Tile + sizeof(FTileHeader));
+	const FCell& Cell = Cells[(CellY % TileCells) * TileCells + (CellX % TileCells)];
+
+	if (!(Cell.Flags & Cell_Valid)) return ELookup::Empty;
+
+	if (Cell.Flags & (Cell_Overhang | Cell_Edge)) return ELookup::Fallback;
+
+	const float NormalX = Cell.NormalX / 127.f;
+	const float NormalY = Cell.NormalY / 127.f;
+	const float NormalZ = FMath::Sqrt(FMath::Max(1.f - NormalX * NormalX - NormalY * NormalY, 0.f));
+
+	OutSample.Normal = FVector(NormalX, NormalY, NormalZ);
+	OutSample.SurfaceType = Cell.SurfaceType;
+
+	// Stored height is at the cell centre, follow the surface plane to the query point
+	const float CenterHeight = TileHeader.BaseZ + Cell.Height * TileHeader.HeightStep;
+	const float OffsetX = (float)(LocalX - CellX - 0.5) * Header.CellSize;
+	const float OffsetY = (float)(LocalY - CellY - 0.5) * Header.CellSize;
+
+	OutSample.Height = CenterHeight - (NormalX * OffsetX + NormalY * OffsetY) / FMath::Max(NormalZ, 0.1f);
+
+	return ELookup::Hit;
+}
+
+FString FOMRTrackSurfaceField::GetFieldPath(const FString& MapName)
+{
+	return FPaths::ProjectContentDir() / TEXT("Track/SurfaceFields") / (MapName + TEXT(".omrsurf"));
+}
+
+bool FOMRTrackSurfaceField::Write(const FString& Filename, double OriginX, double OriginY, float CellSize, int32 NumCellsX, int32 NumCellsY, const TArray<FBakeCell>& Cells)
+{
+	if (Cells.Num() != NumCellsX * NumCellsY || CellSize <= 0.f) return false;
+
+	FHeader Header;
+	Header.NumTilesX = FMath::DivideAndRoundUp(NumCellsX, TileCells);
+	Header.NumTilesY = FMath::DivideAndRoundUp(NumCellsY, TileCells);
+	Header.CellSize = CellSize;
+	Header.OriginX = OriginX;
+	Header.OriginY = OriginY;
+
+	TArray<int32> TileTable;
+	TileTable.Init(INDEX_NONE, Header.NumTilesX * Header.NumTilesY);
+
+	TArray64<uint8> TileData;
+
+	for (int32 TileY = 0; TileY < Header.NumTilesY; ++TileY)
+	{
+		for (int32 TileX = 0; TileX < Header.NumTilesX; ++TileX)
+		{
+			// Height range of this tile
+			float MinZ = TNumericLimits<float>::Max();
+			float MaxZ = TNumericLimits<float>::Lowest();
+
+			for (int32 Y = 0; Y < TileCells; ++Y)
+			{
+				for (int32 X = 0; X < TileCells; ++X)
+				{
+					const int32 CellX = TileX * TileCells + X;
+					const int32 CellY = TileY * TileCells + Y;
+					if (CellX >= NumCellsX || CellY >= NumCellsY) continue;
+
+					const FBakeCell& Cell = Cells[CellY * NumCellsX + CellX];
+					if (!(Cell.Flags & Cell_Valid)) continue;
+
+					MinZ = FMath::Min(MinZ, Cell.Height);
+					MaxZ = FMath::Max(MaxZ, Cell.Height);
+				}
+			}
+
+			// Nothing walkable, leave the tile out
+			if (MinZ > MaxZ) continue;
+
+			FTileHeader TileHeader;
+			TileHeader.BaseZ = MinZ;
+			TileHeader.HeightStep = FMath::Max((MaxZ - MinZ) / 65535.f, KINDA_SMALL_NUMBER);
+
+			TileTable[TileY * Header.NumTilesX + TileX] = Header.NumTiles++;
+
+			const int64 TileStart = TileData.AddZeroed(TileBytes);
+			FMemory::Memcpy(TileData.GetData() + TileStart, &TileHeader, sizeof(FTileHeader));
+
+			FCell* OutCells = reinterpret_cast<FCell*>(TileData.GetData() + TileStart + sizeof(FTileHeader));
+
+			for (int32 Y = 0; Y < TileCells; ++Y)
+			{
+				for (int32 X = 0; X < TileCells; ++X)
+				{
+					const int32 CellX = TileX * TileCells + X;
+					const int32 CellY = TileY * TileCells + Y;
+					if (CellX >= NumCellsX || CellY >= NumCellsY) continue;
+
+					const FBakeCell& Cell = Cells[CellY * NumCellsX + CellX];
+					if (!(Cell.Flags & Cell_Valid)) continue;
+
+					FCell& OutCell = OutCells[Y * TileCells + X];
+					OutCell.Height = (uint16)FMath::Clamp(FMath::RoundToInt((Cell.Height - MinZ) / TileHeader.HeightStep), 0, 65535);
+					OutCell.NormalX = (int8)FMath::Clamp(FMath::RoundToInt(Cell.Normal.X * 127.f), -127, 127);
+					OutCell.NormalY = (int8)FMath::Clamp(FMath::RoundToInt(Cell.Normal.Y * 127.f), -127, 127);
+					OutCell.SurfaceType = Cell.SurfaceType;
+					OutCell.Flags = Cell.Flags;
+				}
+			}
+		}
+	}
+
+	TArray64<uint8> Bytes;
+	Bytes.Reserve(sizeof(FHeader) + TileTable.Num() * sizeof(int32) + TileData.Num());
+	Bytes.Append(reinterpret_cast<const uint8*>(&Header), sizeof(FHeader));
+	Bytes.Append(reinterpret_cast<const uint8*>(TileTable.GetData()), TileTable.Num() * sizeof(int32));
+	Bytes.Append(TileData);
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
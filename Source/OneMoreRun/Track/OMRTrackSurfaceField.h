@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Baked 2.5D surface of a track: per cell top height, normal and surface type,
+ * stored in square tiles so a lookup touches one tile table entry and one cell.
+ *
+ * File layout (little endian, see FOMRTrackSurfaceField::Write):
+ *   FHeader | int32 TileTable[NumTilesX * NumTilesY] | FTile...
+ * Each FTile is a FTileHeader followed by TileCells * TileCells FCell.
+ */
+class ONEMORERUN_API FOMRTrackSurfaceField
+{
+public:
+	static constexpr uint32 Magic = 0x53524D4F; // 'OMRS'
+	static constexpr uint32 Version = 1;
+	static constexpr int32 TileCells = 64;
+
+	enum ECellFlags : uint8
+	{
+		Cell_Valid = 1 << 0,
+		// Another walkable layer below the top one (bridges, loops)
+		Cell_Overhang = 1 << 1,
+		// Next to a hole or a step the ball could catch on
+		Cell_Edge = 1 << 2,
+	};
+
+	struct FHeader
+	{
+		uint32 Magic = FOMRTrackSurfaceField::Magic;
+		uint32 Version = FOMRTrackSurfaceField::Version;
+		int32 TileCells = FOMRTrackSurfaceField::TileCells;
+		int32 NumTilesX = 0;
+		int32 NumTilesY = 0;
+		int32 NumTiles = 0;
+		float CellSize = 50.f;
+		float Padding = 0.f;
+		double OriginX = 0.0;
+		double OriginY = 0.0;
+	};
+
+	struct FTileHeader
+	{
+		float BaseZ = 0.f;
+		float HeightStep = 1.f;
+	};
+
+	struct FCell
+	{
+		uint16 Height = 0;
+		int8 NormalX = 0;
+		int8 NormalY = 0;
+		uint8 SurfaceType = 0;
+		uint8 Flags = 0;
+	};
+	static_assert(sizeof(FCell) == 6, "FCell is part of the file format");
+
+	static constexpr int64 TileBytes = sizeof(FTileHeader) + sizeof(FCell) * TileCells * TileCells;
+
+	enum class ELookup : uint8
+	{
+		// Surface found under the location
+		Hit,
+		// Inside the baked area but nothing walkable below
+		Empty,
+		// Outside the bake, on an edge or under an overhang: use a scene query
+		Fallback
+	};
+
+	struct FSample
+	{
+		float Height = 0.f;
+		FVector Normal = FVector::UpVector;
+		uint8 SurfaceType = 0;
+	};
+
+	FOMRTrackSurfaceField() = default;
+	~FOMRTrackSurfaceField();
+
+	FOMRTrackSurfaceField(const FOMRTrackSurfaceField&) = delete;
+	FOMRTrackSurfaceField& operator=(const FOMRTrackSurfaceField&) = delete;
+
+	// Memory maps the file, falling back to reading it whole where mapping is unsupported
+	bool Open(const FString& Filename);
+	void Close();
+
+	bool IsValid() const { return Data != nullptr; }
+
+	ELookup Lookup(const FVector& Location, FSample& OutSample) const;
+
+	static FString GetFieldPath(const FString& MapName);
+
+	// Build side: write a field from a dense cell grid (NumCellsX * NumCellsY, row major)
+	// with heights in world units, empty cells have Flags == 0
+	struct FBakeCell
+	{
+		float Height = 0.f;
+		FVector3f Normal = FVector3f::UpVector;
+		uint8 SurfaceType = 0;
+		uint8 Flags = 0;
+	};
+
+	static bool Write(
+		const FString& Filename,
+		double OriginX,
+		double OriginY,
+		float CellSize,
+		int32 NumCellsX,
+		int32 NumCellsY,
+		const TArray<FBakeCell>& Cells
+	);
+
+private:
+	const FHeader& GetHeader() const { return *reinterpret_cast<const FHeader*>(Data); }
+	const int32* GetTileTable() const { return reinterpret_cast<const int32*>(Data + sizeof(FHeader)); }
+	const uint8* GetTile(int32 TileIndex) const;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	TUniquePtr<IMappedFileHandle> MappedHandle;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	// Used when the platform can't map the file
+	TArray64<uint8> LoadedBytes;
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "OMRTrackSurfaceSubsystem.h"
+#include "../OneMoreRun.h"
+#include "Engine/World.h"
+
+void UOMRTrackSurfaceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	LLM_SCOPE_BYTAG(OMR_Track);
+
+	const FString MapName = UWorld::RemovePIEPrefix(InWorld.GetMapName());
+
+	if (Field.Open(FOMRTrackSurfaceField::GetFieldPath(MapName)))
+	{
+		UE_LOG(LogTemp, Log, TEXT("Loaded surface field for %s."), *MapName);
+	}
+}
+
+void UOMRTrackSurfaceSubsystem::Deinitialize()
+{
+	Field.Close();
+
+	Super::Deinitialize();
+}
+
+bool UOMRTrackSurfaceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OMRTrackSurfaceField.h"
+#include "OMRTrackSurfaceSubsystem.generated.h"
+
+/**
+ * Owns the baked surface field of the current track (see UOMRBakeSurfaceFieldCommandlet).
+ * Ground queries go through here so callers don't care whether a bake exists.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRTrackSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	bool HasField() const { return Field.IsValid(); }
+	const FOMRTrackSurfaceField& GetField() const { return Field; }
+
+	// Fallback when there is no field, or the location is on an edge/overhang
+	FOMRTrackSurfaceField::ELookup Lookup(const FVector& Location, FOMRTrackSurfaceField::FSample& OutSample) const
+	{
+		return Field.Lookup(Location, OutSample);
+	}
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FOMRTrackSurfaceField Field;
+};
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "../UI/OMRHudModel.h"
+#include "../Game/OMRTimeTrialGameState.h"
+
+uint32 FOMRHudModel::Update(const AOMRTimeTrialGameState& GameState)
+{
+	const int32 NewLap = GameState.GetDisplayedLap();
+	const float NewLapTime = GameState.GetDisplayedLaptime();
+	const float NewBestLapTime = GameState.GetDisplayedBestLapTime();
+
+	// Playback shows recorded splits, not a live comparison
+	const bool bNewHasLiveDelta = GameState.bHasLiveDelta && !GameState.bPlayingSession;
+
+	const int32 NewLapCentiseconds = ToCentiseconds(FMath::Max(NewLapTime, 0.f));
+	const int32 NewBestCentiseconds = NewBestLapTime < 0.f ? INDEX_NONE : ToCentiseconds(NewBestLapTime);
+	const int32 NewLiveDeltaCentiseconds = bNewHasLiveDelta ? ToCentiseconds(GameState.LiveDelta) : 0;
+
+	uint32 Changed = 0;
+
+	if (!bValid || NewLap != Lap) Changed |= Field_Lap;
+	if (!bValid || NewLapCentiseconds != LapCentiseconds) Changed |= Field_LapTime;
+	if (!bValid || NewBestCentiseconds != BestCentiseconds) Changed |= Field_BestTime;
+
+	// Losing the live delta isn't shown, the restart or next lap start resets the widget
+	if (bNewHasLiveDelta && (!bValid || !bHasLiveDelta || NewLiveDeltaCentiseconds != LiveDeltaCentiseconds)) Changed |= Field_LiveDelta;
+
+	bValid = true;
+
+	Lap = NewLap;
+	LapTime = NewLapTime;
+	BestLapTime = NewBestLapTime;
+	LapCentiseconds = NewLapCentiseconds;
+	BestCentiseconds = NewBestCentiseconds;
+
+	bHasLiveDelta = bNewHasLiveDelta;
+	LiveDelta = GameState.LiveDelta;
+	PredictedLapTime = GameState.PredictedLapTime;
+	LiveDeltaCentiseconds = NewLiveDeltaCentiseconds;
+
+	return Changed;
+}
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AOMRTimeTrialGameState;
+
+/**
+ * What the HUD shows, read from the game state once per frame.
+ *
+ * Times are compared as whole centiseconds, the resolution they're displayed at, so Update
+ * reports a field only when its widget would actually show something different.
+ */
+struct FOMRHudModel
+{
+	enum EField : uint32
+	{
+		Field_Lap = 1 << 0,
+		Field_LapTime = 1 << 1,
+		Field_BestTime = 1 << 2,
+		Field_LiveDelta = 1 << 3,
+	};
+
+	int32 Lap = 0;
+	float LapTime = 0.f;
+
+	// Negative while there's no best lap
+	float BestLapTime = -1.f;
+
+	bool bHasLiveDelta = false;
+	float LiveDelta = 0.f;
+	float PredictedLapTime = 0.f;
+
+	// Reads GameState, returns the EField bits that changed since the last Update
+	uint32 Update(const AOMRTimeTrialGameState& GameState);
+
+	// Next Update reports every field
+	void Invalidate() { bValid = false; }
+
+private:
+	static int32 ToCentiseconds(float Time) { return FMath::FloorToInt(Time * 100.f); }
+
+	bool bValid = false;
+
+	int32 LapCentiseconds = 0;
+	int32 BestCentiseconds = 0;
+	int32 LiveDeltaCentiseconds = 0;
+};
@@ -2,13 +2,168 @@
 
 
 #include "../UI/OMRTimeTrialHUD.h"
+#include "../UI/OMRTimerText.h"
+#include "../Game/OMRTimeTrialGameState.h"
+#include "Slate/SInvalidationPanel.h"
 
-FText UOMRTimeTrialHUD::FormatTime(float Time) const
+TSharedRef<SWidget> UOMRTimeTrialHUD::RebuildWidget()
 {
-	int32 Minutes = FMath::FloorToInt(Time / 60.f);
-	int32 Seconds = FMath::FloorToInt(Time) % 60;
-	int32 Centiseconds = FMath::FloorToInt((Time - FMath::FloorToInt(Time)) * 100.f);
-	return FText::FromString(
-		FString::Printf(TEXT("%d:%02d:%02d"), Minutes, Seconds, Centiseconds)
-	);
+	TSharedRef<SWidget> Content = Super::RebuildWidget();
+
+	if (!bCacheInInvalidationPanel || IsDesignTime())
+	{
+		return Content;
+	}
+
+	return SNew(SInvalidationPanel)
+	[
+		Content
+	];
+}
+
+void UOMRTimeTrialHUD::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	GameState = GetWorld() ? GetWorld()->GetGameState<AOMRTimeTrialGameState>() : nullptr;
+
+	Model.Invalidate();
+}
+
+void UOMRTimeTrialHUD::NativeTick(const FGeometry& MyGeometry, float InDeltaTime)
+{
+	Super::NativeTick(MyGeometry, InDeltaTime);
+
+	if (!bPullRaceState) return;
+
+	const AOMRTimeTrialGameState* GS = GameState.Get();
+	if (!GS) return;
+
+	const uint32 Changed = Model.Update(*GS);
+
+	if (Changed & FOMRHudModel::Field_Lap)
+	{
+		UpdateLapNumber(Model.Lap);
+	}
+
+	// Every frame while the lap runs, so only the native timer sees it. Without one Blueprint
+	// gets it at the game state's feed rate, and the last value always gets through
+	if (Changed & FOMRHudModel::Field_LapTime)
+	{
+		if (LapTimer)
+		{
+			LapTimer->SetTime(Model.LapTime);
+		}
+		else
+		{
+			bLapTimePending = true;
+		}
+	}
+
+	// Moves nearly every frame between checkpoints too, same feed rate
+	if (Changed & FOMRHudModel::Field_LiveDelta)
+	{
+		bLiveDeltaPending = true;
+	}
+
+	if (bLapTimePending || bLiveDeltaPending)
+	{
+		const float FeedInterval = 1.f / FMath::Max(GS->LapTimerUpdateRate, 1.f);
+
+		FeedAccumulator += InDeltaTime;
+
+		// A new lap shows its start at once
+		if (FeedAccumulator >= FeedInterval || (Changed & FOMRHudModel::Field_Lap))
+		{
+			FeedAccumulator = FMath::Fmod(FeedAccumulator, FeedInterval);
+
+			if (bLapTimePending)
+			{
+				bLapTimePending = false;
+				UpdateLapTime(Model.LapTime);
+			}
+
+			if (bLiveDeltaPending)
+			{
+				bLiveDeltaPending = false;
+				UpdateLiveDelta(Model.LiveDelta, Model.PredictedLapTime);
+			}
+		}
+	}
+
+	if (Changed & FOMRHudModel::Field_BestTime)
+	{
+		ShowBestTime(Model.BestLapTime);
+	}
+}
+
+void UOMRTimeTrialHUD::ShowLapTime(float NewTime)
+{
+	if (LapTimer)
+	{
+		LapTimer->SetTime(NewTime);
+	}
+
+	UpdateLapTime(NewTime);
+}
+
+void UOMRTimeTrialHUD::ShowBestTime(float NewBestTime)
+{
+	if (BestTimer)
+	{
+		if (NewBestTime < 0.f)
+		{
+			BestTimer->ClearTime();
+		}
+		else
+		{
+			BestTimer->SetTime(NewBestTime);
+		}
+	}
+
+	UpdateBestTime(NewBestTime);
+}
+
+FText UOMRTimeTrialHUD::FormatTime(float Time, EOMRTimeSlot Slot) const
+{
+	const int32 SlotIndex = FMath::Clamp((int32)Slot, 0, NumTimeSlots - 1);
+	const int32 TotalCentiseconds = FMath::Max(FMath::FloorToInt(Time * 100.f), 0);
+
+	if (TotalCentiseconds == LastFormattedCentiseconds[SlotIndex])
+	{
+		return LastFormattedTime[SlotIndex];
+	}
+
+	const int32 Minutes = TotalCentiseconds / 6000;
+	const int32 Seconds = TotalCentiseconds / 100 % 60;
+	const int32 Centiseconds = TotalCentiseconds % 100;
+
+	// Written back to front into a stack buffer, no format string and no temporary strings.
+	// The only allocation left is the text itself, once per change
+	TCHAR Buffer[16];
+	int32 Start = UE_ARRAY_COUNT(Buffer);
+
+	auto PutTwoDigits = [&Buffer, &Start](int32 Value)
+	{
+		Buffer[--Start] = (TCHAR)(TEXT('0') + Value % 10);
+		Buffer[--Start] = (TCHAR)(TEXT('0') + Value / 10);
+	};
+
+	PutTwoDigits(Centiseconds);
+	Buffer[--Start] = TEXT(':');
+	PutTwoDigits(Seconds);
+	Buffer[--Start] = TEXT(':');
+
+	int32 RemainingMinutes = Minutes;
+	do
+	{
+		Buffer[--Start] = (TCHAR)(TEXT('0') + RemainingMinutes % 10);
+		RemainingMinutes /= 10;
+	}
+	while (RemainingMinutes > 0);
+
+	LastFormattedCentiseconds[SlotIndex] = TotalCentiseconds;
+	LastFormattedTime[SlotIndex] = FText::AsCultureInvariant(FString(FStringView(Buffer + Start, UE_ARRAY_COUNT(Buffer) - Start)));
+
+	return LastFormattedTime[SlotIndex];
 }
@@ -4,8 +4,21 @@
 
 #include "CoreMinimal.h"
 #include "Blueprint/UserWidget.h"
+#include "OMRHudModel.h"
 #include "OMRTimeTrialHUD.generated.h"
 
+class UOMRTimerText;
+class AOMRTimeTrialGameState;
+
+// Which time FormatTime is formatting, each keeps its own last text
+UENUM(BlueprintType)
+enum class EOMRTimeSlot : uint8
+{
+	Lap,
+	Best,
+	Split,
+};
+
 /**
  * 
  */
@@ -16,6 +29,21 @@ class ONEMORERUN_API UOMRTimeTrialHUD : public UUserWidget
 	
 public:
 
+    // Read lap, times and live delta from the game state every frame and update only what
+    // changed. Otherwise the player controller relays the game state's delegates
+    UPROPERTY(EditAnywhere, Category = "HUD")
+    bool bPullRaceState = true;
+
+    // Wrap the HUD in an invalidation panel, widgets only repaint when they invalidate
+    UPROPERTY(EditAnywhere, Category = "HUD")
+    bool bCacheInInvalidationPanel = true;
+
+    bool PullsRaceState() const { return bPullRaceState; }
+
+    // Set the native timers if the Blueprint has them, then raise the Update events
+    void ShowLapTime(float NewTime);
+    void ShowBestTime(float NewBestTime);
+
     UFUNCTION(BlueprintImplementableEvent)
     void UpdateLapTime(float NewTime);
 
@@ -31,9 +59,49 @@ public:
     UFUNCTION(BlueprintImplementableEvent, Category = "UI")
     void PlayGoAnimation();
 
+    // M:SS:CC, negative times show as zero. Pass the slot the text goes to so lap, best and
+    // split don't keep evicting each other's text
     UFUNCTION(BlueprintCallable)
-    FText FormatTime(float Time) const;
+    FText FormatTime(float Time, EOMRTimeSlot Slot = EOMRTimeSlot::Lap) const;
 
     UFUNCTION(BlueprintImplementableEvent)
     void UpdateSplit(float SplitTime, float SplitDelta, bool bIsAhead);
+
+    // Race restarted in place, clear splits, deltas and anything else left from the last run
+    UFUNCTION(BlueprintImplementableEvent)
+    void ResetForRaceRestart();
+
+    // Between checkpoints, against the best lap at the same distance along the track. Fed at
+    // the game state's LapTimerUpdateRate like UpdateLapTime
+    UFUNCTION(BlueprintImplementableEvent)
+    void UpdateLiveDelta(float LiveDelta, float PredictedLapTime);
+
+    // Optional native timers, bound by name. Preferred over FormatTime into a text block,
+    // they only repaint when a digit changes
+    UPROPERTY(BlueprintReadOnly, meta = (BindWidgetOptional))
+    TObjectPtr<UOMRTimerText> LapTimer;
+
+    UPROPERTY(BlueprintReadOnly, meta = (BindWidgetOptional))
+    TObjectPtr<UOMRTimerText> BestTimer;
+
+protected:
+    virtual TSharedRef<SWidget> RebuildWidget() override;
+    virtual void NativeConstruct() override;
+    virtual void NativeTick(const FGeometry& MyGeometry, float InDeltaTime) override;
+
+private:
+    // Pull model, last values shown
+    FOMRHudModel Model;
+    TWeakObjectPtr<AOMRTimeTrialGameState> GameState;
+
+    // Blueprint feed of the lap time (when there's no native LapTimer) and the live delta
+    float FeedAccumulator = 0.f;
+    bool bLapTimePending = false;
+    bool bLiveDeltaPending = false;
+
+    static constexpr int32 NumTimeSlots = 3;
+
+    // FormatTime is called at the HUD feed rate, reuse each slot's text while its centiseconds don't change
+    mutable int32 LastFormattedCentiseconds[NumTimeSlots] = { INDEX_NONE, INDEX_NONE, INDEX_NONE };
+    mutable FText LastFormattedTime[NumTimeSlots];
 };
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "../UI/OMRTimerText.h"
+#include "../UI/SOMRTimerText.h"
+
+#define LOCTEXT_NAMESPACE "OMR"
+
+UOMRTimerText::UOMRTimerText()
+{
+	Font = FCoreStyle::GetDefaultFontStyle("Mono", 32);
+}
+
+void UOMRTimerText::SetTime(float NewTime)
+{
+	Time = FMath::Max(NewTime, 0.f);
+
+	if (MyTimerText.IsValid())
+	{
+		MyTimerText->SetTime(Time);
+	}
+}
+
+void UOMRTimerText::ClearTime()
+{
+	Time = -1.f;
+
+	if (MyTimerText.IsValid())
+	{
+		MyTimerText->ClearTime();
+	}
+}
+
+TSharedRef<SWidget> UOMRTimerText::RebuildWidget()
+{
+	if (bStartCleared && !IsDesignTime())
+	{
+		Time = -1.f;
+	}
+
+	MyTimerText = SNew(SOMRTimerText)
+		.Font(Font)
+		.ColorAndOpacity(ColorAndOpacity);
+
+	return MyTimerText.ToSharedRef();
+}
+
+void UOMRTimerText::SynchronizeProperties()
+{
+	Super::SynchronizeProperties();
+
+	if (!MyTimerText.IsValid()) return;
+
+	MyTimerText->SetFont(Font);
+	MyTimerText->SetColorAndOpacity(ColorAndOpacity);
+
+	if (Time < 0.f)
+	{
+		MyTimerText->ClearTime();
+	}
+	else
+	{
+		MyTimerText->SetTime(Time);
+	}
+}
+
+void UOMRTimerText::ReleaseSlateResources(bool bReleaseChildren)
+{
+	Super::ReleaseSlateResources(bReleaseChildren);
+
+	MyTimerText.Reset();
+}
+
+#if WITH_EDITOR
+const FText UOMRTimerText::GetPaletteCategory()
+{
+	return LOCTEXT("OneMoreRun", "One More Run");
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
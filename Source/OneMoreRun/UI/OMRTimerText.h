@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/Widget.h"
+#include "Styling/CoreStyle.h"
+#include "OMRTimerText.generated.h"
+
+class SOMRTimerText;
+
+/**
+ * UMG face of SOMRTimerText. Cheap enough to set every frame, the widget repaints only when
+ * a shown digit changes.
+ */
+UCLASS()
+class ONEMORERUN_API UOMRTimerText : public UWidget
+{
+	GENERATED_BODY()
+
+public:
+	UOMRTimerText();
+
+	UFUNCTION(BlueprintCallable, Category = "Timer")
+	void SetTime(float NewTime);
+
+	UFUNCTION(BlueprintCallable, Category = "Timer")
+	void ClearTime();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateFontInfo Font;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Appearance")
+	FSlateColor ColorAndOpacity = FLinearColor::White;
+
+	// Shown before the first SetTime, dashes otherwise
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Timer")
+	bool bStartCleared = false;
+
+	virtual void SynchronizeProperties() override;
+	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
+
+#if WITH_EDITOR
+	virtual const FText GetPaletteCategory() override;
+#endif
+
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+
+	TSharedPtr<SOMRTimerText> MyTimerText;
+
+	// Survives a widget rebuild, negative when cleared
+	float Time = 0.f;
+};
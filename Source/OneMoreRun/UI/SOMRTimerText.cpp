@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "../UI/SOMRTimerText.h"
+#include "Framework/Application/SlateApplication.h"
+#include "Fonts/FontMeasure.h"
+#include "Rendering/DrawElements.h"
+
+const FString SOMRTimerText::GlyphChars = TEXT("0123456789:-");
+
+void SOMRTimerText::Construct(const FArguments& InArgs)
+{
+	Font = InArgs._Font;
+	ColorAndOpacity = InArgs._ColorAndOpacity;
+
+	MeasureGlyphs();
+}
+
+void SOMRTimerText::SetTime(float Time)
+{
+	SetCentiseconds(FMath::FloorToInt(FMath::Max(Time, 0.f) * 100.f));
+}
+
+void SOMRTimerText::ClearTime()
+{
+	SetCentiseconds(INDEX_NONE);
+}
+
+void SOMRTimerText::SetCentiseconds(int32 NewCentiseconds)
+{
+	if (NewCentiseconds == Centiseconds) return;
+
+	const float OldWidth = GetGlyphsWidth();
+
+	Centiseconds = NewCentiseconds;
+
+	// Same width, only the glyphs in the cells changed. Clearing keeps the glyph count but
+	// swaps digit cells for dash cells, so the count alone can't tell
+	Invalidate(GetGlyphsWidth() == OldWidth ? EInvalidateWidgetReason::Paint : EInvalidateWidgetReason::Layout);
+}
+
+void SOMRTimerText::SetFont(const FSlateFontInfo& InFont)
+{
+	if (Font.IsIdenticalTo(InFont)) return;
+
+	Font = InFont;
+	MeasureGlyphs();
+
+	Invalidate(EInvalidateWidgetReason::Layout);
+}
+
+void SOMRTimerText::SetColorAndOpacity(const FSlateColor& InColorAndOpacity)
+{
+	if (ColorAndOpacity == InColorAndOpacity) return;
+
+	ColorAndOpacity = InColorAndOpacity;
+
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+int32 SOMRTimerText::BuildGlyphs(uint8 (&OutGlyphs)[MaxGlyphs]) const
+{
+	if (Centiseconds < 0)
+	{
+		const uint8 Cleared[] = { GlyphDash, GlyphColon, GlyphDash, GlyphDash, GlyphColon, GlyphDash, GlyphDash };
+		FMemory::Memcpy(OutGlyphs, Cleared, sizeof(Cleared));
+		return UE_ARRAY_COUNT(Cleared);
+	}
+
+	const int32 Minutes = FMath::Min(Centiseconds / 6000, 999);
+	const int32 Seconds = (Centiseconds / 100) % 60;
+	const int32 Hundredths = Centiseconds % 100;
+
+	int32 Num = 0;
+
+	if (Minutes >= 100) OutGlyphs[Num++] = (uint8)(Minutes / 100);
+	if (Minutes >= 10) OutGlyphs[Num++] = (uint8)(Minutes / 10 % 10);
+	OutGlyphs[Num++] = (uint8)(Minutes % 10);
+
+	OutGlyphs[Num++] = GlyphColon;
+	OutGlyphs[Num++] = (uint8)(Seconds / 10);
+	OutGlyphs[Num++] = (uint8)(Seconds % 10);
+
+	OutGlyphs[Num++] = GlyphColon;
+	OutGlyphs[Num++] = (uint8)(Hundredths / 10);
+	OutGlyphs[Num++] = (uint8)(Hundredths % 10);
+
+	return Num;
+}
+
+void SOMRTimerText::MeasureGlyphs()
+{
+	DigitWidth = 0.f;
+	SeparatorWidth = 0.f;
+	GlyphHeight = 0.f;
+	FMemory::Memzero(GlyphWidths);
+
+	if (!FSlateApplication::IsInitialized()) return;
+
+	const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+
+	// Widest digit sets the cell, so the timer never changes width as it counts
+	for (int32 Glyph = 0; Glyph < NumGlyphChars; ++Glyph)
+	{
+		const FVector2D Size = FontMeasure->Measure(GlyphChars, Glyph, Glyph + 1, Font);
+
+		GlyphWidths[Glyph] = (float)Size.X;
+
+		float& Width = Glyph < GlyphColon ? DigitWidth : SeparatorWidth;
+		Width = FMath::Max(Width, GlyphWidths[Glyph]);
+		GlyphHeight = FMath::Max(GlyphHeight, (float)Size.Y);
+	}
+}
+
+float SOMRTimerText::GetGlyphsWidth() const
+{
+	uint8 Glyphs[MaxGlyphs];
+	const int32 Num = BuildGlyphs(Glyphs);
+
+	float Width = 0.f;
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		Width += GetCellWidth(Glyphs[Index]);
+	}
+
+	return Width;
+}
+
+FVector2D SOMRTimerText::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D(GetGlyphsWidth(), GlyphHeight);
+}
+
+int32 SOMRTimerText::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+	FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	uint8 Glyphs[MaxGlyphs];
+	const int32 Num = BuildGlyphs(Glyphs);
+
+	const ESlateDrawEffect DrawEffects = ShouldBeEnabled(bParentEnabled) ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const FLinearColor Tint = InWidgetStyle.GetColorAndOpacityTint() * ColorAndOpacity.GetColor(InWidgetStyle);
+
+	float X = 0.f;
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const uint8 Glyph = Glyphs[Index];
+		const float CellWidth = GetCellWidth(Glyph);
+
+		// Narrow glyphs sit centred in their cell
+		const float Inset = (CellWidth - GlyphWidths[Glyph]) * 0.5f;
+
+		FSlateDrawElement::MakeText(
+			OutDrawElements,
+			LayerId,
+			AllottedGeometry.ToPaintGeometry(FVector2f(CellWidth, GlyphHeight), FSlateLayoutTransform(FVector2f(X + Inset, 0.f))),
+			GlyphChars,
+			Glyph,
+			Glyph + 1,
+			Font,
+			DrawEffects,
+			Tint);
+
+		X += CellWidth;
+	}
+
+	return LayerId;
+}
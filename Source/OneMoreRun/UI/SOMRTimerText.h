@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+#include "Styling/CoreStyle.h"
+
+/**
+ * Lap timer as M:SS:CC, kept as whole centiseconds instead of text.
+ *
+ * Every character is one glyph of a constant string, drawn in its own fixed-width cell from
+ * the font cache's atlas, so painting builds no strings and shapes no text and the digits
+ * don't jitter as they change. SetTime only invalidates when a shown digit changes, and only
+ * invalidates layout when that changes its width: the minutes gaining a digit, or the time
+ * being cleared or set again.
+ */
+class ONEMORERUN_API SOMRTimerText : public SLeafWidget
+{
+public:
+	SLATE_BEGIN_ARGS(SOMRTimerText)
+		: _Font(FCoreStyle::GetDefaultFontStyle("Mono", 32))
+		, _ColorAndOpacity(FLinearColor::White)
+	{}
+		SLATE_ARGUMENT(FSlateFontInfo, Font)
+		SLATE_ARGUMENT(FSlateColor, ColorAndOpacity)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	// Negative times show as zero
+	void SetTime(float Time);
+
+	// Dashes in place of the digits, for a best time that doesn't exist yet
+	void ClearTime();
+
+	void SetFont(const FSlateFontInfo& InFont);
+	void SetColorAndOpacity(const FSlateColor& InColorAndOpacity);
+
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+		FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+protected:
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+	// "0123456789:-", glyphs are drawn as one-character ranges of it
+	static const FString GlyphChars;
+	static constexpr int32 GlyphColon = 10;
+	static constexpr int32 GlyphDash = 11;
+	static constexpr int32 NumGlyphChars = 12;
+
+	// Minutes up to 999
+	static constexpr int32 MaxGlyphs = 9;
+
+	void SetCentiseconds(int32 NewCentiseconds);
+
+	// Glyph indices left to right, returns how many
+	int32 BuildGlyphs(uint8 (&OutGlyphs)[MaxGlyphs]) const;
+
+	// Cell widths at layout scale 1, measured once per font
+	void MeasureGlyphs();
+
+	float GetCellWidth(uint8 Glyph) const { return Glyph < GlyphColon ? DigitWidth : SeparatorWidth; }
+
+	// Summed cells of the current glyphs
+	float GetGlyphsWidth() const;
+
+	FSlateFontInfo Font;
+	FSlateColor ColorAndOpacity;
+
+	// INDEX_NONE when cleared
+	int32 Centiseconds = 0;
+
+	float DigitWidth = 0.f;
+	float SeparatorWidth = 0.f;
+	float GlyphHeight = 0.f;
+
+	// Own width of each glyph, for centring it in its cell
+	float GlyphWidths[NumGlyphChars] = {};
+};